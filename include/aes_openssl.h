@@ -15,12 +15,71 @@
 
 #include "header.h"
 #include "crypto_util.h"
+#include "util_aesni.h"
+#include "util_bitslice.h"
 
 //------------------------------------------------------------------------------
 //      Constants
 //------------------------------------------------------------------------------
 #define BLOCK_SIZE 16   // 16 bytes == 128-bit
 
+// Bytes needed to hold n bytes padded up to a whole number of blocks
+#define AES_ECB_LEN(n) ((((n) + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE)
+
+// Length of nbyte bytes after PKCS#7 padding to block size bs (adds 1 to bs)
+#define PKCS7_LEN(nbyte, bs) ((nbyte) + (bs) - (nbyte) % (bs))
+
+// Blocks decrypted per pass before XOR-ing, when a backend can't fuse the two
+#define AES_XOR_CHUNK_BLOCKS 1024
+
+// Keystream blocks generated per AES call in CTR mode
+#define AES_CTR_BATCH_BLOCKS 256
+
+// Keyed contexts kept for reuse by the mode functions, least recently used
+// evicted first
+#define AES_CTX_CACHE_SIZE 8
+
+// Environment variable that overrides the default block cipher backend
+#define AES_BACKEND_ENV "AES_BACKEND"
+
+//------------------------------------------------------------------------------
+//      Structures
+//------------------------------------------------------------------------------
+// Block cipher implementations behind an AES_CTX
+typedef enum {
+    AES_BACKEND_OPENSSL = 0,    // EVP interface, always available
+    AES_BACKEND_AESNI,          // native AES-NI kernels, x86 with CPUID.aes
+    AES_BACKEND_BITSLICE,       // portable constant-time software, batched
+    AES_BACKEND_COUNT
+} AES_BACKEND;
+
+// Keyed AES context. Create once per (key, direction) and reuse it for every
+// block; the expanded key schedule lives inside the context.
+typedef struct _AES_CTX {
+    AES_BACKEND backend;    // implementation used for every call
+    int enc;                // 1 == encrypt, 0 == decrypt
+    BYTE key[BLOCK_SIZE];   // key it was made with, to match in the cache
+    EVP_CIPHER_CTX *evp;    // keyed OpenSSL context, padding disabled
+    BYTE rk[AES_128_RK_LEN];  // expanded schedule for AES-NI
+    uint64_t bs_rk[BITSLICE_RK_WORDS];  // bitsliced schedule
+} __AES_CTX;
+
+typedef struct _AES_CTX AES_CTX;
+
+// ECB or CBC over a stream of any length, fed a chunk at a time. Whole blocks
+// go out as soon as they arrive; decryption holds back the last block until
+// aes_stream_final so its padding can be checked.
+typedef struct _AES_STREAM {
+    AES_CTX *ctx;
+    int enc;                // 1 == encrypt, 0 == decrypt
+    int cbc;                // 1 == CBC, 0 == ECB
+    BYTE chain[BLOCK_SIZE]; // CBC: previous ciphertext block (IV at first)
+    BYTE buf[BLOCK_SIZE];   // bytes not yet processed
+    size_t n_buf;           // bytes held in buf
+} __AES_STREAM;
+
+typedef struct _AES_STREAM AES_STREAM;
+
 //------------------------------------------------------------------------------
 //      Function declarations
 //------------------------------------------------------------------------------
@@ -29,6 +88,87 @@ void OpenSSL_init(void);
 void OpenSSL_cleanup(void);
 void handleErrors(void);
 
+// Backend used by init_aes_ctx. Chosen at startup: AES-NI when CPUID reports
+// it, else OpenSSL; the AES_BACKEND environment variable ("openssl", "aesni"
+// or "bitslice") overrides the choice.
+AES_BACKEND aes_default_backend(void);
+
+// Force the default backend. Returns -1 if it is not available here.
+int aes_set_default_backend(AES_BACKEND backend);
+
+// Non-zero if the backend can run on this build and CPU
+int aes_backend_available(AES_BACKEND backend);
+
+// Short name of a backend, as accepted by AES_BACKEND
+const char *aes_backend_name(AES_BACKEND backend);
+
+// Allocate an AES 128-bit context keyed for encryption (enc=1) or decryption
+AES_CTX *init_aes_ctx(const BYTE *key, int enc);
+
+// Allocate a context that uses the given backend instead of the default
+AES_CTX *init_aes_ctx_backend(const BYTE *key, int enc, AES_BACKEND backend);
+
+// Free a keyed AES context
+void free_aes_ctx(AES_CTX *ctx);
+
+// Keyed context for the default backend from the schedule cache, or a new one
+// on a miss. The caller has it to itself until aes_ctx_release, which gives it
+// back to the cache. Thread-safe.
+AES_CTX *aes_ctx_acquire(const BYTE *key, int enc);
+void aes_ctx_release(AES_CTX *ctx);
+
+// Cache hits/misses since startup or the last flush
+void aes_ctx_cache_stats(size_t *hits, size_t *misses);
+
+// Free every cached context and zero the counters
+void aes_ctx_cache_flush(void);
+
+// Turn the cache off (0) or on (1, the default). Off, acquire and release are
+// init_aes_ctx and free_aes_ctx.
+void aes_ctx_cache_enable(int on);
+
+// Encrypt/decrypt n_blocks consecutive blocks into caller buffer (out == in ok)
+int aes_128_encrypt_blocks(AES_CTX *ctx, BYTE *out, const BYTE *in, size_t n_blocks);
+int aes_128_decrypt_blocks(AES_CTX *ctx, BYTE *out, const BYTE *in, size_t n_blocks);
+
+// Encrypt block i of in with ctx[i]. Runs of the same context go through one
+// bulk call; on AES-NI, blocks under different keys are interleaved too.
+int aes_128_encrypt_blocks_multi(AES_CTX **ctx, BYTE *out, const BYTE *in,
+        size_t n_blocks);
+
+// Decrypt n_blocks and XOR block i of the output with block i of mask, as CBC
+// decryption does with the previous ciphertext. mask must not overlap out.
+int aes_128_decrypt_blocks_xor(AES_CTX *ctx, BYTE *out, const BYTE *in,
+        const BYTE *mask, size_t n_blocks);
+
+// CTR mode: XOR len bytes of in with the keystream E(nonce || le64(counter))
+// from byte pos of the stream on, so any range can be processed without the
+// keystream before it. Keystream is generated AES_CTR_BATCH_BLOCKS at a time.
+// ctx must be keyed for encryption. out == in is allowed.
+int aes_128_ctr_xor(AES_CTX *ctx, BYTE *out, const BYTE *in, size_t len,
+        const BYTE *nonce, uint64_t pos);
+
+// Start an ECB (iv == NULL) or CBC stream keyed for encryption (enc=1) or
+// decryption (enc=0)
+AES_STREAM *init_aes_stream(const BYTE *key, const BYTE *iv, int enc);
+
+// Process n more bytes of input into out (at least n + BLOCK_SIZE bytes; must
+// not overlap in). Returns the number of bytes written.
+size_t aes_stream_update(AES_STREAM *s, BYTE *out, const BYTE *in, size_t n);
+
+// Flush the last block into out (BLOCK_SIZE bytes): PKCS#7 padded when
+// encrypting, padding removed when decrypting. As with the one-shot modes,
+// input that is a block multiple gets no extra padding block. Returns the
+// bytes written, or -1 on invalid padding or a partial ciphertext block.
+ssize_t aes_stream_final(AES_STREAM *s, BYTE *out);
+
+// Free a stream and its key schedule
+void free_aes_stream(AES_STREAM *s);
+
+// Encrypt/decrypt a single block into caller buffer
+int aes_128_encrypt_block(AES_CTX *ctx, BYTE *out, const BYTE *in);
+int aes_128_decrypt_block(AES_CTX *ctx, BYTE *out, const BYTE *in);
+
 // AES 128-bit ECB-mode encrypt/decrypt single block
 int aes_128_ecb_block(BYTE **out, size_t *out_len, BYTE *in, size_t in_len, 
         BYTE *key, int enc);
@@ -39,6 +179,11 @@ int aes_128_ecb_block(BYTE **out, size_t *out_len, BYTE *in, size_t in_len,
 // Challenge 9: PKCS#7 padding to block size 
 BYTE *pkcs7_pad(const BYTE *byte, size_t nbyte, size_t block_size);
 
+// Pad into a caller buffer of PKCS7_LEN(nbyte, block_size) bytes (out == byte
+// is fine). Returns the padded length.
+ssize_t pkcs7_pad_into(BYTE *out, const BYTE *byte, size_t nbyte,
+        size_t block_size);
+
 // Challenge 15: Remove PKCS#7 padding
 int pkcs7_rmpad(const BYTE *byte, size_t nbyte, size_t block_size);
 
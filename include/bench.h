@@ -0,0 +1,114 @@
+//==============================================================================
+//      File: bench.h
+//   Created: 10/17/2026, 10:12
+//    Author: Bernie Roesler
+//
+//   Description: Useful benchmarking macros
+//==============================================================================
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Minimum wall-clock time to spend on each measurement [s]
+#define BENCH_MIN_TIME 0.5
+
+// Seconds since an arbitrary point, from the monotonic clock
+#define BENCH_NOW(t) do {\
+    struct timespec _ts;\
+    clock_gettime(CLOCK_MONOTONIC, &_ts);\
+    (t) = (double)_ts.tv_sec + 1e-9*(double)_ts.tv_nsec;\
+} while(0)
+
+// Time-stamp counter, in reference cycles (0 where there is none)
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_TSC() ((unsigned long long)__rdtsc())
+#else
+#define BENCH_TSC() 0ULL
+#endif
+
+// Repeat statement x until BENCH_MIN_TIME has elapsed (at least once). Sets
+// reps to the number of repetitions and secs to the total time taken.
+// e.g., BENCH_LOOP(reps, secs, aes_128_encrypt_blocks(ctx, y, x, n));
+#define BENCH_LOOP(reps, secs, x) do {\
+    double _t0, _t1;\
+    (reps) = 0;\
+    BENCH_NOW(_t0);\
+    do {\
+        x;\
+        (reps)++;\
+        BENCH_NOW(_t1);\
+    } while (_t1 - _t0 < BENCH_MIN_TIME);\
+    (secs) = _t1 - _t0;\
+} while(0)
+
+// Print one result line: name, input size, and throughput in units/second
+#define BENCH_REPORT(name, nbyte, units, rate) \
+    printf("%-28s %12zu B %14.0f %s/s\n", (name), (size_t)(nbyte), (rate), (units))
+
+// Print one result line in cycles per byte
+#define BENCH_REPORT_CPB(name, nbyte, cpb) \
+    printf("%-28s %12zu B %14.2f cycles/B\n", (name), (size_t)(nbyte), (cpb))
+
+//------------------------------------------------------------------------------
+//      Sampled measurements, for the JSON suites
+//------------------------------------------------------------------------------
+// Samples per measurement of a fast statement
+#define BENCH_SAMPLES 101
+
+// Untimed batches run before sampling starts
+#define BENCH_WARMUP 3
+
+// Shortest time one sample may take [s]. Fast statements are run in batches
+// long enough to reach it, and timed per call.
+#define BENCH_SAMPLE_TIME 1e-3
+
+// Summary of one measurement. Times are per call, in seconds.
+typedef struct _BENCH_RESULT {
+    size_t n_samples;       // samples taken
+    size_t batch;           // calls per sample
+    double min, median, p99, mean;
+} __BENCH_RESULT;
+
+typedef struct _BENCH_RESULT BENCH_RESULT;
+
+// Take n samples of statement x into res, after sizing the batch and
+// warming up. e.g., BENCH_SAMPLE(res, BENCH_SAMPLES, fixed_xor_into(y,a,b,n));
+#define BENCH_SAMPLE(res, n, x) do {\
+    double _s[(n)], _t0, _t1;\
+    size_t _batch = 1;\
+    do {\
+        BENCH_NOW(_t0);\
+        for (size_t _i = 0; _i < _batch; _i++) { x; }\
+        BENCH_NOW(_t1);\
+    } while (_t1 - _t0 < BENCH_SAMPLE_TIME && (_batch *= 2));\
+    for (int _w = 0; _w < BENCH_WARMUP; _w++) {\
+        for (size_t _i = 0; _i < _batch; _i++) { x; }\
+    }\
+    for (size_t _k = 0; _k < (size_t)(n); _k++) {\
+        BENCH_NOW(_t0);\
+        for (size_t _i = 0; _i < _batch; _i++) { x; }\
+        BENCH_NOW(_t1);\
+        _s[_k] = (_t1 - _t0) / _batch;\
+    }\
+    bench_summary(&(res), _s, (n), _batch);\
+} while(0)
+
+// Sort samples and fill in res (bench.c)
+void bench_summary(BENCH_RESULT *res, double *samples, size_t n, size_t batch);
+
+// Write one JSON object of results to stdout, {"suite": ..., "results": [...]},
+// and a readable line per result to stderr. nbyte may be 0 when throughput
+// means nothing.
+void bench_json_begin(const char *suite);
+void bench_json_result(const char *name, size_t nbyte, const BENCH_RESULT *res);
+void bench_json_end(void);
+
+#endif
+//==============================================================================
+//==============================================================================
@@ -22,12 +22,19 @@
 extern BYTE *global_key;
 extern BYTE *global_iv;
 
+// Scratch arena for last_byte and block_decrypt, created on first use. Free it
+// with free_arena when done.
+extern ARENA *global_arena;
+
 //------------------------------------------------------------------------------ 
 //       Macros and Constnats
 //------------------------------------------------------------------------------
 // Define PRNG seed for consistency
 #define SRAND_INIT 56
 
+// Chunk size of global_arena
+#define ORACLE_ARENA_SIZE 256
+
 // String to be encrypted 
 static const char * const POSSIBLE_X[10] = 
 { 
@@ -18,17 +18,36 @@
 #define MAX_KEY_LEN 128     // All powers of 2
 #define MAX_WORD_LEN 16384
 
+// Key lengths break_repeating_xor tries in full
+#define XOR_TOP_K 3
+
+// Key lengths get_key_lengths considers
+#define XOR_MIN_KEY_LEN 2
+#define XOR_MAX_KEY_LEN 40
+
+// A multiple of a key length ranks behind it if the shorter length has at
+// least this fraction of its score
+#define XOR_DIVISOR_RATIO 0.75f
+
+// Buffer sizes for the _into codecs: base64 output includes the NUL, and
+// decoding never gives more than 3 bytes per 4 chars
+#define BYTE2B64_LEN(nbyte) (4*(((nbyte) + 2) / 3) + 1)
+#define B642BYTE_LEN(nchar) (3*((nchar) / 4))
+
 #define XSTR(X) STR(X)
 #define STR(X) #X
 
 //------------------------------------------------------------------------------
 //      Structures
 //------------------------------------------------------------------------------
-// The character frequency structure contains the letter and its frequency
+// A broken XOR cipher: the key, the plaintext and its score. key and
+// plaintext are NUL-terminated and live in the same allocation as the node,
+// so one free() (or popping its arena) releases everything.
 typedef struct _XOR_NODE {
-    BYTE key[MAX_KEY_LEN];
-    BYTE plaintext[MAX_WORD_LEN];
+    BYTE *key;              // key_byte bytes, 0 until a key is found
+    BYTE *plaintext;        // nbyte bytes
     size_t key_byte;
+    size_t nbyte;
     float score;
     int file_line;
 } __XOR_NODE;
@@ -47,27 +66,70 @@ char *b642hex(const char *b64);
 // Encode byte array as b64 string
 char *byte2b64(const BYTE *byte, size_t nbyte);
 
+// Encode into a caller buffer of BYTE2B64_LEN(nbyte) chars. Returns the
+// number of chars written, not counting the NUL.
+ssize_t byte2b64_into(char *b64, const BYTE *byte, size_t nbyte);
+
+// Encode as lines of width chars (e.g. B64_WIDTH_DATA), each ending in a
+// newline, like the files in data/
+char *byte2b64_wrap(const BYTE *byte, size_t nbyte, size_t width);
+
 // Decode base64 string to byte array
 size_t b642byte(BYTE **byte, const char *b64);
 
+// Decode nchar (a multiple of 4) base64 chars into a caller buffer of
+// B642BYTE_LEN(nchar) bytes. Returns the number of bytes, or a (negative)
+// B64_ERROR on bad input.
+ssize_t b642byte_into(BYTE *byte, const char *b64, size_t nchar);
+
 // Challenge 2: XOR two fixed-length byte arrays
 BYTE *fixed_xor(const BYTE *a, const BYTE *b, size_t nbyte);
 
+// XOR into a caller buffer of nbyte bytes (may be a or b). Returns nbyte.
+ssize_t fixed_xor_into(BYTE *xor, const BYTE *a, const BYTE *b, size_t nbyte);
+
 // Character frequency score
 float char_freq_score(const BYTE *byte, size_t nbyte);
 
-// Allocate memory and initialize an XOR_NODE
-XOR_NODE *init_xor_node(void);
+// Score of the plaintext byte ^ key, given the NUM_BYTES-bin histogram of
+// nbyte bytes of byte (see count_bytes)
+float char_freq_score_hist(const size_t *hist, BYTE key, size_t nbyte);
+
+// Allocate and initialize an XOR_NODE with room for a key of key_len bytes
+// and nbyte bytes of plaintext
+XOR_NODE *init_xor_node(size_t key_len, size_t nbyte);
+
+// The same, allocated from an arena
+XOR_NODE *arena_xor_node(ARENA *a, size_t key_len, size_t nbyte);
 
 // Challenge 3: Single byte XOR decode
 XOR_NODE *single_byte_xor_decode(const BYTE *byte, size_t nbyte);
 
+// Decode into a node with room for a 1-byte key and nbyte bytes of
+// plaintext. Returns 0 if no key gives printable text.
+int single_byte_xor_decode_into(XOR_NODE *out, const BYTE *byte,
+        size_t nbyte);
+
+// The top->k best single-byte keys (item value) and their scores, best
+// first. top must be initialized. Returns the number found.
+size_t single_byte_xor_rank(TOPK *top, const BYTE *byte, size_t nbyte);
+
+// Score candidate plaintexts of the XOR breakers with a language model
+// instead of chi-squared letter frequencies. NULL restores chi-squared. The
+// model must outlive its use.
+void set_xor_model(const NGRAM *model);
+
 // Challenge 4: Search file for single byte XOR'd string
 XOR_NODE *find_single_byte_xor(const char *filename);
 
 // Challenge 5: Encode byte array using repeating-key XOR
 BYTE *repeating_key_xor(const BYTE *byte, const BYTE *key_byte, size_t nbyte, size_t key_len);
 
+// Repeating-key XOR into a caller buffer of nbyte bytes (may be byte).
+// Returns nbyte.
+ssize_t repeating_key_xor_into(BYTE *xor, const BYTE *byte,
+        const BYTE *key_byte, size_t nbyte, size_t key_len);
+
 // Compute Hamming distance between strings 
 size_t hamming_dist(const BYTE *a, const BYTE *b, size_t nbyte);
 
@@ -77,13 +139,33 @@ float norm_mean_hamming(const BYTE *byte, size_t nbyte, size_t k);
 // Get most probable key length of repeating XOR 
 size_t get_key_length(const BYTE *byte, size_t nbyte);
 
-// Challenge 6: Break repeating key XOR cipher 
+// The top->k most probable key lengths up to XOR_MAX_KEY_LEN, best first.
+// top must be initialized. Returns the number found.
+size_t get_key_lengths(TOPK *top, const BYTE *byte, size_t nbyte);
+
+// The same for lengths up to max_len (at most HAMMING_MAX_SHIFT), in time
+// linear in nbyte. A length is scored by how much more often bytes a
+// multiple of it apart are equal than bytes at other shifts.
+size_t rank_key_lengths(TOPK *top, const BYTE *byte, size_t nbyte,
+        size_t max_len);
+
+// Challenge 6: Break repeating key XOR cipher. A negative key_byte tries
+// the XOR_TOP_K likeliest key lengths.
 XOR_NODE *break_repeating_xor(const BYTE *byte, const size_t nbyte,
                               int key_byte);
 
+// Break with each of the n_len likeliest key lengths, in parallel, and keep
+// the plaintext with the best score
+XOR_NODE *break_repeating_xor_top(const BYTE *byte, size_t nbyte,
+        size_t n_len);
+
 // Challenge 7: AES 128-bit ECB-mode encrypt/decrypt entire byte array
 int aes_128_ecb_cipher(BYTE **y, size_t *y_len, BYTE *x, size_t x_len, BYTE *key, int enc);
 
+// AES 128-bit ECB-mode into caller buffer of AES_ECB_LEN(x_len) bytes (y == x ok)
+ssize_t aes_128_ecb_cipher_into(BYTE *y, const BYTE *x, size_t x_len,
+        const BYTE *key, int enc);
+
 // Same as norm_mean_hamming except return logical value
 int has_identical_blocks(const BYTE *byte, size_t nbyte, size_t block_size);
 
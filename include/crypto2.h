@@ -19,15 +19,63 @@
 // maximum bytes to feed into get_block_size
 #define IMAX 48
 
+// Messages advanced in lockstep at once by aes_128_cbc_encrypt_batch
+#define CBC_BATCH_GROUP 256
+
+// Bytes of CBC ciphertext for n bytes of plaintext: padded up to the next block
+// boundary, with no extra padding block when n is already aligned
+#define AES_CBC_LEN(n) AES_ECB_LEN(n)
+
+// Don't give a CBC decryption thread fewer blocks than this (1 MB)
+#define CBC_MIN_THREAD_BLOCKS (1 << 16)
+
+//------------------------------------------------------------------------------
+//      Structures
+//------------------------------------------------------------------------------
+// One message of a CBC encryption batch. The caller fills in the inputs; the
+// batch allocates y (free it) and sets y_len.
+typedef struct _CBC_MSG {
+    const BYTE *x;          // plaintext
+    size_t x_len;           // plaintext length
+    const BYTE *key;        // 16-byte key
+    const BYTE *iv;         // 16-byte initialization vector
+    BYTE *y;                // ciphertext (output)
+    size_t y_len;           // ciphertext length (output)
+} __CBC_MSG;
+
+typedef struct _CBC_MSG CBC_MSG;
+
 //------------------------------------------------------------------------------
 //      Function Definitions
 //------------------------------------------------------------------------------
 // Challenge 10: Encrypt using AES 128-bit CBC mode
 int aes_128_cbc_encrypt(BYTE **y, size_t *y_len, BYTE *x, size_t x_len, BYTE *key, BYTE *iv);
 
+// Encrypt into a caller buffer of AES_CBC_LEN(x_len) bytes. Returns the bytes
+// written. No heap allocation.
+ssize_t aes_128_cbc_encrypt_into(BYTE *y, const BYTE *x, size_t x_len,
+        const BYTE *key, const BYTE *iv);
+
+// Encrypt n_msg independent messages in CBC mode. Step i encrypts block i of
+// every message still running in one multi-block AES call, so the chains
+// advance in lockstep instead of one after another. Groups where most messages
+// bring their own key are chained one by one instead. Same output as calling
+// aes_128_cbc_encrypt on each; the caller frees each msg[j].y.
+int aes_128_cbc_encrypt_batch(CBC_MSG *msg, size_t n_msg);
+
 // Decrypt using AES 128-bit CBC mode
 int aes_128_cbc_decrypt(BYTE **x, size_t *x_len, BYTE *y, size_t y_len, BYTE *key, BYTE *iv);
 
+// Decrypt into a caller buffer of y_len bytes that does not overlap y. Returns
+// the plaintext length with padding removed, or -1 on bad padding.
+ssize_t aes_128_cbc_decrypt_into(BYTE *x, const BYTE *y, size_t y_len,
+        const BYTE *key, const BYTE *iv);
+
+// Decrypt n_blocks of CBC ciphertext into x (no padding removed), split over
+// up to n_threads threads. x and y must not overlap.
+void aes_128_cbc_decrypt_blocks(BYTE *x, const BYTE *y, size_t n_blocks,
+        const BYTE *key, const BYTE *iv, int n_threads);
+
 // Get block size given function pointer
 size_t get_block_size(int (*encrypt)(BYTE**, size_t*, BYTE*, size_t), size_t *count, size_t *n);
 
@@ -8,13 +8,46 @@
 #ifndef _CRYPTO3_H_
 #define _CRYPTO3_H_
 
+#include <stdint.h>
+
 #include "header.h"
 #include "crypto_util.h"
 
+//-------------------------------------------------------------------------------
+//      Macros
+//-------------------------------------------------------------------------------
+// Bytes moved per read/write by the FILE* CTR interface (multiple of 16)
+#define CTR_CHUNK (1 << 16)
+
+// Fewest blocks worth handing to another thread in aes_128_ctr_file (1 MB)
+#define CTR_MIN_THREAD_BLOCKS (1 << 16)
+
 //-------------------------------------------------------------------------------
 //      Function Prototypes
 //-------------------------------------------------------------------------------
-// AES 128-bit CTR mode streamcipher (encrypt or decrypt)
+// AES 128-bit CTR mode over memory (encrypt or decrypt): y = x ^ keystream,
+// counter starting at 0. y == x is allowed.
+int aes_128_ctr_buf(BYTE *y, const BYTE *x, size_t len, const BYTE *key,
+        const BYTE *nonce);
+
+// Random access: x holds bytes [off, off+len) of a CTR stream. Only the
+// keystream for that range is generated. y == x is allowed.
+int aes_128_ctr_at(BYTE *y, const BYTE *x, size_t len, uint64_t off,
+        const BYTE *key, const BYTE *nonce);
+
+// CTR-encrypt/decrypt in_file into out_file (created or truncated). Both are
+// memory-mapped and split into block-aligned ranges over up to n_threads
+// threads, each starting at its own counter. Same bytes as aes_128_ctr.
+// out_file may be in_file (or a link to it), which is then done in place.
+int aes_128_ctr_file(const char *out_file, const char *in_file,
+        const BYTE *key, const BYTE *nonce, int n_threads);
+
+// Set the 64-bit little endian counter of the block holding stream byte off,
+// and return off's position within that block
+size_t ctr_seek(BYTE *counter, uint64_t off);
+
+// AES 128-bit CTR mode streamcipher (encrypt or decrypt), CTR_CHUNK bytes at a
+// time. Rewinds y when done.
 int aes_128_ctr(FILE *y, FILE *x, BYTE *key, BYTE *nonce);
 
 // Encrypt (nonce||counter) using key in AES 128-bit ECB block
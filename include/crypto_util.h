@@ -30,12 +30,20 @@
 typedef unsigned char BYTE;
 #endif
 
+#include "util_base64.h"
 #include "util_convert.h"
+#include "util_cpu.h"
 #include "util_file.h"
+#include "util_hamming.h"
 #include "util_init.h"
+#include "util_ngram.h"
 #include "util_print.h"
+#include "util_stats.h"
 #include "util_str.h"
+#include "util_thread.h"
+#include "util_topk.h"
 #include "util_twister.h"
+#include "util_xor.h"
 
 #endif
 //==============================================================================
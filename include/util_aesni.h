@@ -0,0 +1,48 @@
+//==============================================================================
+//     File: include/util_aesni.h
+//  Created: 10/17/2026, 11:20
+//   Author: Bernie Roesler
+//
+//  Description: Native AES-128 block functions using the AES-NI instructions
+//=============================================================================
+#ifndef _UTIL_AESNI_H_
+#define _UTIL_AESNI_H_
+
+#include "header.h"
+#include "crypto_util.h"
+
+//------------------------------------------------------------------------------
+//      Constants
+//------------------------------------------------------------------------------
+#define AES_128_ROUNDS 10
+#define AES_128_RK_LEN ((AES_128_ROUNDS + 1) * 16)  // bytes in a key schedule
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// Non-zero if this build and this CPU can run the AES-NI kernels
+int aesni_available(void);
+
+// Expand a 16-byte key into encryption (ek) and decryption (dk) schedules of
+// AES_128_RK_LEN bytes each. Either output may be NULL.
+void aesni_expand_key(BYTE *ek, BYTE *dk, const BYTE *key);
+
+// Encrypt/decrypt n_blocks consecutive blocks with an expanded schedule.
+// Blocks are processed 8 at a time to keep the AES unit pipeline full.
+// out == in is allowed.
+void aesni_encrypt_blocks(const BYTE *ek, BYTE *out, const BYTE *in, size_t n_blocks);
+void aesni_decrypt_blocks(const BYTE *dk, BYTE *out, const BYTE *in, size_t n_blocks);
+
+// Encrypt block i with its own schedule ek[i], 8 independent chains at a time
+void aesni_encrypt_blocks_multikey(const BYTE *const *ek, BYTE *out,
+        const BYTE *in, size_t n_blocks);
+
+// Decrypt and XOR each output block with the matching block of mask (CBC
+// decryption with mask = previous ciphertext), in one pass. mask must not
+// overlap out.
+void aesni_decrypt_blocks_xor(const BYTE *dk, BYTE *out, const BYTE *in,
+        const BYTE *mask, size_t n_blocks);
+
+#endif
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,118 @@
+//==============================================================================
+//     File: include/util_base64.h
+//  Created: 10/17/2026, 18:30
+//   Author: Bernie Roesler
+//
+//  Description: Table-driven base64 codec kernels, with SSE4.1 and AVX2 paths
+//      chosen at runtime
+//=============================================================================
+#ifndef _UTIL_BASE64_H_
+#define _UTIL_BASE64_H_
+
+#include "header.h"
+#include "crypto_util.h"
+
+//------------------------------------------------------------------------------
+//      Constants
+//------------------------------------------------------------------------------
+// Characters in the encoding of nbyte bytes, not counting the NUL
+#define B64_ENCODE_LEN(nbyte) (4*(((nbyte) + 2) / 3))
+
+// Buffer size for b64_encode_wrap: the characters, a newline ending each
+// line of width, and the NUL
+#define B64_WRAP_LEN(nbyte, width)                                     \
+    (B64_ENCODE_LEN(nbyte)                                             \
+     + (B64_ENCODE_LEN(nbyte) + (width) - 1) / (width) + 1)
+
+// Line widths of the challenge data files and of MIME
+#define B64_WIDTH_DATA 60
+#define B64_WIDTH_MIME 76
+
+// Most bytes b64_stream_update writes for nchar characters of input
+#define B64_STREAM_LEN(nchar) (3 * ((nchar) / 4 + 1))
+
+// Characters read per chunk by b64_decode_file, and the most bytes it hands
+// to emit at once
+#define B64_FILE_CHUNK (1 << 16)
+#define B64_EMIT_MAX B64_STREAM_LEN(B64_FILE_CHUNK)
+
+// Errors. All are negative, so callers may simply test < 0.
+typedef enum {
+    B64_ELEN  = -1,     // length is not a multiple of 4
+    B64_ECHAR = -2,     // character outside the alphabet
+    B64_EPAD  = -3,     // '=' anywhere but the last one or two places
+    B64_EIO   = -4,     // the file could not be read
+    B64_ESTOP = -5      // the consumer asked to stop
+} B64_ERROR;
+
+//------------------------------------------------------------------------------
+//      Structs
+//------------------------------------------------------------------------------
+// Incremental decoder state: a partial quad carried between chunks
+typedef struct _B64_STREAM {
+    BYTE quad[4];           // sextets of the quad in progress
+    size_t n_quad;          // sextets held in quad
+    int done;               // 1 once a quad with '=' padding has ended
+} __B64_STREAM;
+
+typedef struct _B64_STREAM B64_STREAM;
+
+// Consumer of decoded bytes. Returns non-zero to stop decoding.
+typedef int (*B64_EMIT)(void *arg, const BYTE *byte, size_t nbyte);
+
+// b64_emit_buf target: bytes are appended at byte + nbyte, up to size
+typedef struct _B64_BUF {
+    BYTE *byte;
+    size_t nbyte;
+    size_t size;
+} __B64_BUF;
+
+typedef struct _B64_BUF B64_BUF;
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// Encode nbyte bytes into B64_ENCODE_LEN(nbyte) + 1 chars of b64, padded
+// with '=' and NUL-terminated. Returns the number of characters.
+size_t b64_encode(char *b64, const BYTE *byte, size_t nbyte);
+
+// The same, without the SIMD paths. For testing and benchmarks.
+size_t b64_encode_scalar(char *b64, const BYTE *byte, size_t nbyte);
+
+// Encode into lines of width characters, each ending in '\n', as in the data
+// files. b64 holds B64_WRAP_LEN(nbyte, width) chars. Returns the number of
+// characters, or B64_ELEN for a zero width.
+ssize_t b64_encode_wrap(char *b64, const BYTE *byte, size_t nbyte,
+        size_t width);
+
+// Decode nchar base64 characters into 3*nchar/4 bytes of byte. Returns the
+// number of bytes written, or a B64_ERROR. The output may be partly written
+// on error.
+ssize_t b64_decode(BYTE *byte, const char *b64, size_t nchar);
+
+// The same, without the SIMD paths. For testing and benchmarks.
+ssize_t b64_decode_scalar(BYTE *byte, const char *b64, size_t nchar);
+
+// Decode a chunk at a time, skipping whitespace and keeping partial quads
+// across chunks. update writes at most B64_STREAM_LEN(nchar) bytes and
+// returns the count, or a B64_ERROR; final returns B64_ELEN if a partial
+// quad is left over.
+void b64_stream_init(B64_STREAM *s);
+ssize_t b64_stream_update(B64_STREAM *s, BYTE *byte, const char *b64,
+        size_t nchar);
+int b64_stream_final(B64_STREAM *s);
+
+// Decode a whole (wrapped) base64 file in constant memory, passing the bytes
+// to emit as they come. Returns the total bytes, or a B64_ERROR.
+ssize_t b64_decode_file(FILE *fp, B64_EMIT emit, void *arg);
+
+// Emitter appending to a B64_BUF. Fails once the buffer is full.
+int b64_emit_buf(void *arg, const BYTE *byte, size_t nbyte);
+
+// Read a base64 file into a new byte array. Returns the number of bytes or a
+// B64_ERROR; exits if the file cannot be opened.
+ssize_t b64_file2byte(BYTE **byte, const char *filename);
+
+#endif
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,51 @@
+//==============================================================================
+//     File: include/util_bitslice.h
+//  Created: 10/17/2026, 13:05
+//   Author: Bernie Roesler
+//
+//  Description: Constant-time bitsliced software AES-128 for batches of
+//      independent blocks. No table lookups depend on key or data.
+//=============================================================================
+#ifndef _UTIL_BITSLICE_H_
+#define _UTIL_BITSLICE_H_
+
+#include <stdint.h>
+
+#include "header.h"
+#include "crypto_util.h"
+#include "util_aesni.h"     // AES_128_ROUNDS
+
+//------------------------------------------------------------------------------
+//      Constants
+//------------------------------------------------------------------------------
+// 64-bit lanes per bitsliced word. Each lane carries 4 blocks, so a kernel call
+// processes 4*BITSLICE_LANES blocks: 2 lanes == 8 blocks in one 128-bit
+// register, 4 lanes == 16 blocks in one AVX2 (or two SSE2) registers, 8 lanes
+// == 32 blocks. 4 is fastest on both AVX2 and SSE2; at 8 the S-box circuit no
+// longer fits in the register file.
+#ifndef BITSLICE_LANES
+#define BITSLICE_LANES 4
+#endif
+
+#define BITSLICE_BLOCKS (4 * BITSLICE_LANES)
+
+// 64-bit words in a bitsliced key schedule: 8 bit-planes per round key
+#define BITSLICE_RK_WORDS ((AES_128_ROUNDS + 1) * 8)
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// Expand a 16-byte key into a bitsliced schedule of BITSLICE_RK_WORDS words.
+// The same schedule serves both directions.
+void bitslice_expand_key(uint64_t *rk, const BYTE *key);
+
+// Encrypt/decrypt n_blocks consecutive blocks, BITSLICE_BLOCKS at a time. A
+// short final batch costs as much as a full one. out == in is allowed.
+void bitslice_encrypt_blocks(const uint64_t *rk, BYTE *out, const BYTE *in,
+        size_t n_blocks);
+void bitslice_decrypt_blocks(const uint64_t *rk, BYTE *out, const BYTE *in,
+        size_t n_blocks);
+
+#endif
+//==============================================================================
+//==============================================================================
@@ -11,6 +11,14 @@
 #include "header.h" 
 #include "crypto_util.h"
 
+//------------------------------------------------------------------------------
+//      Macros
+//------------------------------------------------------------------------------
+// Buffer sizes for the _into conversions. String outputs include room for the
+// terminating NUL.
+#define BYTE2HEX_LEN(nbyte) (2*(nbyte) + 1)
+#define HEX2BYTE_LEN(nchar) ((nchar) / 2)
+
 //------------------------------------------------------------------------------
 //      Function Definitions
 //------------------------------------------------------------------------------
@@ -26,9 +34,19 @@ BYTE get_hex_byte(const char *hex);
 // Print byte array as hexadecimal string
 char *byte2hex(const BYTE *byte, size_t nbyte);
 
+// Hex-encode into a caller buffer of BYTE2HEX_LEN(nbyte) chars, in upper or
+// lower case. Returns the number of hex chars written, not counting the NUL.
+ssize_t byte2hex_into(char *hex, const BYTE *byte, size_t nbyte);
+ssize_t byte2hex_lower_into(char *hex, const BYTE *byte, size_t nbyte);
+
 // Decode hexadecimal string to raw bytes 
 size_t hex2byte(BYTE **byte, const char *hex);
 
+// Decode nchar hex chars into a caller buffer of HEX2BYTE_LEN(nchar) bytes.
+// Returns the number of bytes, or -1 on an odd length or a non-hex char (the
+// output may then be partly written). Either case is accepted.
+ssize_t hex2byte_into(BYTE *byte, const char *hex, size_t nchar);
+
 // Convert hex string to ASCII string
 char *htoa(const char *hex);
 
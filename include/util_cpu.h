@@ -0,0 +1,22 @@
+//==============================================================================
+//     File: include/util_cpu.h
+//  Created: 10/17/2026, 11:02
+//   Author: Bernie Roesler
+//
+//  Description: Runtime detection of CPU instruction set extensions
+//=============================================================================
+#ifndef _UTIL_CPU_H_
+#define _UTIL_CPU_H_
+
+#include "header.h"
+#include "crypto_util.h"
+
+// Non-zero if the CPU (and OS, for AVX) supports the given extension
+int cpu_has_aesni(void);
+int cpu_has_ssse3(void);
+int cpu_has_sse41(void);
+int cpu_has_avx2(void);
+
+#endif
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,55 @@
+//==============================================================================
+//     File: include/util_hamming.h
+//  Created: 10/17/2026, 23:20
+//   Author: Bernie Roesler
+//
+//  Description: Popcount kernels for Hamming distances between byte arrays,
+//      and the Hamming autocorrelation of one array at many shifts.
+//      Nothing is allocated.
+//=============================================================================
+#ifndef _UTIL_HAMMING_H_
+#define _UTIL_HAMMING_H_
+
+#include <stdint.h>
+
+#include "header.h"
+#include "crypto_util.h"
+
+//------------------------------------------------------------------------------
+//      Constants
+//------------------------------------------------------------------------------
+// Most shifts hamming_autocorr computes
+#define HAMMING_MAX_SHIFT 1024
+
+// Positions done per pass over the shifts; with the shifted copy it stays
+// in L1
+#define HAMMING_CHUNK (1 << 13)
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// Number of differing bits between a and b, nbyte bytes each
+size_t hamming_xor(const BYTE *a, const BYTE *b, size_t nbyte);
+
+// dist[s] = differing bits between byte[i] and byte[i+s] over every i with
+// i + s < nbyte, for s = 1 to max_shift; dist[0] = 0. dist holds
+// max_shift + 1 counts. Reads byte once, HAMMING_CHUNK positions at a time.
+void hamming_autocorr(uint64_t *dist, const BYTE *byte, size_t nbyte,
+        size_t max_shift);
+
+// The same, without the AVX2 path. For testing and benchmarks.
+void hamming_autocorr_scalar(uint64_t *dist, const BYTE *byte, size_t nbyte,
+        size_t max_shift);
+
+// count[s] = number of i with byte[i] == byte[i+s], for s = 1 to max_shift;
+// count[0] = 0. The numerators of the index of coincidence at each shift.
+void coincidence_autocorr(uint64_t *count, const BYTE *byte, size_t nbyte,
+        size_t max_shift);
+
+// The same, without the AVX2 path. For testing and benchmarks.
+void coincidence_autocorr_scalar(uint64_t *count, const BYTE *byte,
+        size_t nbyte, size_t max_shift);
+
+#endif
+//==============================================================================
+//==============================================================================
@@ -11,6 +11,48 @@
 #include "header.h"
 #include "crypto_util.h"
 
+//------------------------------------------------------------------------------
+//      Arena allocator
+//------------------------------------------------------------------------------
+// Flags for init_arena
+#define ARENA_ZERO   0x1    // zero each allocation, like calloc
+#define ARENA_POISON 0x2    // fill popped memory with ARENA_POISON_BYTE
+
+#define ARENA_POISON_BYTE 0xA5
+
+// Alignment of every arena allocation
+#define ARENA_ALIGN 16
+
+// One chunk of arena memory. Allocations are bumped off the front of data.
+typedef struct _ARENA_CHUNK {
+    struct _ARENA_CHUNK *prev;  // older chunk, NULL for the first
+    size_t size;                // usable bytes
+    size_t used;                // bytes handed out
+} __ARENA_CHUNK;
+
+typedef struct _ARENA_CHUNK ARENA_CHUNK;
+
+// Region allocator for loop temporaries: allocation bumps a pointer, and
+// arena_pop() frees everything allocated since the matching arena_push().
+// Chunks are added when one fills up, and freed again when popped past.
+typedef struct _ARENA {
+    ARENA_CHUNK *head;      // chunk being allocated from
+    size_t chunk_size;      // size of each new chunk
+    int flags;              // ARENA_ZERO | ARENA_POISON
+    size_t n_alloc;         // allocations served
+    size_t n_chunk;         // chunks malloc'd, including the first
+} __ARENA;
+
+typedef struct _ARENA ARENA;
+
+// Position in an arena to pop back to
+typedef struct _ARENA_MARK {
+    ARENA_CHUNK *chunk;
+    size_t used;
+} __ARENA_MARK;
+
+typedef struct _ARENA_MARK ARENA_MARK;
+
 // Initialize string (char array)
 char *init_str(const size_t len);
 
@@ -29,6 +71,29 @@ BYTE *rand_byte(size_t len);
 // Initialize integer array
 int *init_int(const size_t len);
 
+// Create an arena whose chunks hold size bytes, with flags ARENA_*
+ARENA *init_arena(size_t size, int flags);
+
+// Free an arena and everything allocated from it
+void free_arena(ARENA *a);
+
+// Mark the current position, and free everything allocated since a mark
+ARENA_MARK arena_push(const ARENA *a);
+void arena_pop(ARENA *a, ARENA_MARK mark);
+
+// Free everything allocated from the arena, keeping its first chunk
+void arena_reset(ARENA *a);
+
+// Allocate len bytes, aligned to ARENA_ALIGN. Never returns NULL.
+void *arena_alloc(ARENA *a, size_t len);
+
+// Arena versions of init_str, init_byte, rand_byte and init_int. Strings and
+// byte arrays get their terminating NUL whether or not the arena zeroes.
+char *arena_str(ARENA *a, size_t len);
+BYTE *arena_byte(ARENA *a, size_t len);
+BYTE *arena_rand_byte(ARENA *a, size_t len);
+int  *arena_int(ARENA *a, size_t len);
+
 // Repeat byte N times
 BYTE *bytenrepeat(const BYTE *src, size_t src_len, size_t nbyte);
 
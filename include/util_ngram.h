@@ -0,0 +1,92 @@
+//==============================================================================
+//     File: include/util_ngram.h
+//  Created: 10/17/2026, 22:05
+//   Author: Bernie Roesler
+//
+//  Description: Unigram, bigram and trigram language models for scoring
+//      candidate plaintexts. Tables are trained offline into a binary file
+//      that is mmapped by ngram_load.
+//=============================================================================
+#ifndef _UTIL_NGRAM_H_
+#define _UTIL_NGRAM_H_
+
+#include <stdint.h>
+
+#include "header.h"
+#include "crypto_util.h"
+
+//------------------------------------------------------------------------------
+//      Constants
+//------------------------------------------------------------------------------
+// "NGRM" read as a little-endian word; a byte-swapped file fails to load
+#define NGRAM_MAGIC   0x4D52474EU
+#define NGRAM_VERSION 1
+
+// Highest order a table file holds
+#define NGRAM_MAX_ORDER 3
+
+// Bigrams and trigrams are over classes of bytes: 26 case-folded letters,
+// space, digit, sentence punctuation, other printable, newline/tab and
+// everything else
+#define NGRAM_SYMS 32
+
+//------------------------------------------------------------------------------
+//      Structs
+//------------------------------------------------------------------------------
+// Table file layout, all little-endian:
+//     NGRAM_HEADER
+//     BYTE  sym[256]                       class of each byte
+//     float uni[256]                       log P(b)
+//     float bi[NGRAM_SYMS^2]               log P(s | s1) - log P(s)
+//     float tri[NGRAM_SYMS^3]              log P(s | s2 s1) - log P(s | s1)
+// so the terms of one position add up to log P(b | s) + log P(s | context).
+typedef struct _NGRAM_HEADER {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t order;         // NGRAM_MAX_ORDER; lower orders may be scored
+    uint32_t n_sym;         // NGRAM_SYMS
+    uint32_t reserved[4];
+} __NGRAM_HEADER;
+
+typedef struct _NGRAM_HEADER NGRAM_HEADER;
+
+// A loaded model. The tables point into the mapped file.
+typedef struct _NGRAM {
+    const BYTE *sym;
+    const float *uni, *bi, *tri;
+    int32_t sym32[256];     // sym widened, for gathers
+    int order;              // orders scored, 1 to NGRAM_MAX_ORDER
+    void *map;
+    size_t map_len;
+} __NGRAM;
+
+typedef struct _NGRAM NGRAM;
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// Train all orders on a corpus and write the table file. Returns 0, or -1
+// if the file cannot be written.
+int ngram_train(const char *path, const BYTE *corpus, size_t nbyte);
+
+// Map a table file, scoring up to order (1 to NGRAM_MAX_ORDER). Returns
+// NULL if the file is missing or not a valid table.
+NGRAM *ngram_load(const char *path, int order);
+
+// Unmap and free a model
+void ngram_free(NGRAM *m);
+
+// Mean negative log-likelihood per byte of byte ^ key: lower reads more
+// like the corpus. FLT_MAX for empty input.
+float ngram_score_xor(const NGRAM *m, const BYTE *byte, size_t nbyte,
+        BYTE key);
+
+// The same for byte itself
+float ngram_score(const NGRAM *m, const BYTE *byte, size_t nbyte);
+
+// The same, without the AVX2 path. For testing and benchmarks.
+float ngram_score_scalar(const NGRAM *m, const BYTE *byte, size_t nbyte);
+
+#endif
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,81 @@
+//==============================================================================
+//     File: include/util_stats.h
+//  Created: 10/17/2026, 16:20
+//   Author: Bernie Roesler
+//
+//  Description: Call, byte and cycle counters for the util primitives. Only
+//      compiled in with -DUTIL_STATS (implied by the LOGSTATUS and VERBOSE
+//      builds); otherwise every STATS_* macro expands to nothing.
+//=============================================================================
+#ifndef _UTIL_STATS_H_
+#define _UTIL_STATS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if !defined(UTIL_STATS) && (defined(LOGSTATUS) || defined(VERBOSE))
+#define UTIL_STATS
+#endif
+
+//------------------------------------------------------------------------------
+//      Counters
+//------------------------------------------------------------------------------
+// Environment variable naming a file for the JSON dump (default stderr),
+// read once when the first counter is added
+#define UTIL_STATS_ENV "UTIL_STATS_FILE"
+
+// Each counter keeps calls, bytes and clock ticks. Ticks are inclusive: an
+// oracle's include the AES it calls.
+typedef enum {
+    STAT_ALLOC,         // init_str, init_byte, init_int: bytes requested
+    STAT_ARENA,         // arena_alloc
+    STAT_AES,           // AES block calls, any backend: bytes / 16 == blocks
+    STAT_ORACLE,        // attack oracle invocations
+    STAT_HEX,           // hex codec, bytes of binary in or out
+    STAT_B64,           // base64 codec, bytes of binary in or out
+    STAT_XOR,           // fixed and repeating-key XOR
+    STAT_COUNT
+} STAT_ID;
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// Add one call of n bytes taking ticks to counter id. The first call
+// registers the dump at exit and on SIGUSR1.
+void util_stats_add(STAT_ID id, uint64_t nbyte, uint64_t ticks);
+
+// Write all counters as one JSON object
+void util_stats_dump(FILE *stream);
+
+// Zero all counters
+void util_stats_reset(void);
+
+#ifdef UTIL_STATS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UTIL_STATS_CLOCK "tsc"
+static inline uint64_t util_stats_ticks(void) { return __rdtsc(); }
+#else
+#include <time.h>
+#define UTIL_STATS_CLOCK "ns"
+static inline uint64_t util_stats_ticks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+// Time a primitive: STATS_START(t); ... STATS_STOP(STAT_AES, t, nbyte);
+#define STATS_START(t)       uint64_t t = util_stats_ticks()
+#define STATS_STOP(id, t, n) util_stats_add((id), (n), util_stats_ticks() - (t))
+#define STATS_COUNT(id, n)   util_stats_add((id), (n), 0)
+#else
+#define STATS_START(t)
+#define STATS_STOP(id, t, n) ((void)0)
+#define STATS_COUNT(id, n)   ((void)0)
+#endif
+
+#endif
+//==============================================================================
+//==============================================================================
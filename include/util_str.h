@@ -12,6 +12,7 @@
 #include "crypto_util.h"
 
 #define NUM_LETTERS 27      // include space!!
+#define NUM_BYTES 256       // bins of a byte histogram
 
 // Get index of character in string 
 size_t indexof(const char *str, char c);
@@ -19,6 +20,9 @@ size_t indexof(const char *str, char c);
 // Character frequency list
 int *count_chars(const BYTE *s, size_t nbyte);
 
+// Histogram of all NUM_BYTES byte values into hist
+void count_bytes(size_t *hist, const BYTE *s, size_t nbyte);
+
 // Hamming weight of hex string 
 size_t hamming_weight(const BYTE *byte, size_t nbyte);
 
@@ -0,0 +1,34 @@
+//==============================================================================
+//     File: include/util_thread.h
+//  Created: 10/17/2026, 14:40
+//   Author: Bernie Roesler
+//
+//  Description: Minimal pthreads helpers for splitting work across cores
+//=============================================================================
+#ifndef _UTIL_THREAD_H_
+#define _UTIL_THREAD_H_
+
+#include "header.h"
+#include "crypto_util.h"
+
+//------------------------------------------------------------------------------
+//      Constants
+//------------------------------------------------------------------------------
+// Environment variable that caps the number of worker threads
+#define THREADS_ENV "CRYPTO_THREADS"
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// Number of worker threads to use: $CRYPTO_THREADS if set, else online CPUs
+int util_nthreads(void);
+
+// Call fn(start, end, arg) on contiguous sub-ranges covering [0, n), using up
+// to n_threads threads (the calling thread is one of them). Each range holds
+// at least min_chunk items, so small inputs stay on the calling thread.
+void parallel_for(size_t n, size_t min_chunk, int n_threads,
+        void (*fn)(size_t start, size_t end, void *arg), void *arg);
+
+#endif
+//==============================================================================
+//==============================================================================
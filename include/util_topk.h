@@ -0,0 +1,56 @@
+//==============================================================================
+//     File: include/util_topk.h
+//  Created: 10/17/2026, 21:10
+//   Author: Bernie Roesler
+//
+//  Description: Bounded heap keeping the k lowest-scoring candidates seen
+//=============================================================================
+#ifndef _UTIL_TOPK_H_
+#define _UTIL_TOPK_H_
+
+#include "header.h"
+#include "crypto_util.h"
+
+//------------------------------------------------------------------------------
+//      Constants
+//------------------------------------------------------------------------------
+// Most candidates a TOPK can hold
+#define TOPK_MAX 16
+
+//------------------------------------------------------------------------------
+//      Structs
+//------------------------------------------------------------------------------
+// One candidate: a key byte, key length, etc. and its score (lower is better)
+typedef struct _TOPK_ITEM {
+    float score;
+    size_t value;
+} __TOPK_ITEM;
+
+typedef struct _TOPK_ITEM TOPK_ITEM;
+
+// Max-heap on score while filling, so the worst kept item is item[0];
+// best-first once sorted
+typedef struct _TOPK {
+    TOPK_ITEM item[TOPK_MAX];
+    size_t n;               // items held
+    size_t k;               // items kept, at most TOPK_MAX
+} __TOPK;
+
+typedef struct _TOPK TOPK;
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// Empty top with room for k items (1 <= k <= TOPK_MAX)
+void topk_init(TOPK *top, size_t k);
+
+// Offer a candidate. It is kept if fewer than k are held or it beats the
+// worst one. Equal scores go to the smaller value; NaN scores are dropped.
+void topk_push(TOPK *top, float score, size_t value);
+
+// Sort the items best-first. No more pushes after this. Returns top->n.
+size_t topk_sort(TOPK *top);
+
+#endif
+//==============================================================================
+//==============================================================================
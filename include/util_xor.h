@@ -0,0 +1,35 @@
+//==============================================================================
+//     File: include/util_xor.h
+//  Created: 10/17/2026, 20:05
+//   Author: Bernie Roesler
+//
+//  Description: Wide XOR kernels for fixed and repeating keys. Nothing is
+//      allocated; every output may alias its input.
+//=============================================================================
+#ifndef _UTIL_XOR_H_
+#define _UTIL_XOR_H_
+
+#include "header.h"
+#include "crypto_util.h"
+
+//------------------------------------------------------------------------------
+//      Constants
+//------------------------------------------------------------------------------
+// Bytes per iteration of the wide loops: two AVX2 (or four SSE2) registers
+#define XOR_WIDE 64
+
+//------------------------------------------------------------------------------
+//      Function Definitions
+//------------------------------------------------------------------------------
+// dst = a ^ b over nbyte bytes. dst may equal a or b.
+void xor_buf(BYTE *dst, const BYTE *a, const BYTE *b, size_t nbyte);
+
+// dst = src ^ key, the key_len-byte key repeated from key[phase]. dst may
+// equal src. Returns the phase after the last byte, so a stream can be
+// XOR-ed a piece at a time.
+size_t xor_repeat(BYTE *dst, const BYTE *src, size_t nbyte, const BYTE *key,
+        size_t key_len, size_t phase);
+
+#endif
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,81 @@
+/*==============================================================================
+ *     File: bench.c
+ *  Created: 10/17/2026, 17:02
+ *   Author: Bernie Roesler
+ *
+ *  Description: Sample statistics and JSON output for the benchmark suites
+ *
+ *============================================================================*/
+#include "header.h"
+#include "bench.h"
+
+/*------------------------------------------------------------------------------
+ *         Summarize samples
+ *----------------------------------------------------------------------------*/
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a,
+           y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted samples, 0 < p <= 100 */
+static double percentile(const double *sorted, size_t n, double p)
+{
+    size_t rank = (size_t)(p / 100.0 * n + 0.999999);
+    if (rank < 1) { rank = 1; }
+    if (rank > n) { rank = n; }
+    return sorted[rank - 1];
+}
+
+void bench_summary(BENCH_RESULT *res, double *samples, size_t n, size_t batch)
+{
+    double sum = 0;
+
+    qsort(samples, n, sizeof(double), cmp_double);
+    for (size_t i = 0; i < n; i++) { sum += samples[i]; }
+
+    res->n_samples = n;
+    res->batch  = batch;
+    res->min    = samples[0];
+    res->median = percentile(samples, n, 50);
+    res->p99    = percentile(samples, n, 99);
+    res->mean   = sum / n;
+}
+
+/*------------------------------------------------------------------------------
+ *         JSON output
+ *----------------------------------------------------------------------------*/
+static int n_results = 0;
+
+void bench_json_begin(const char *suite)
+{
+    n_results = 0;
+    printf("{\"suite\": \"%s\", \"clock\": \"monotonic\", \"results\": [", suite);
+    fprintf(stderr, "%-40s %12s %12s %12s %10s\n",
+            suite, "bytes", "median ns", "p99 ns", "MB/s");
+}
+
+void bench_json_result(const char *name, size_t nbyte, const BENCH_RESULT *res)
+{
+    /* Throughput at the median, in 10^6 bytes per second */
+    double mbs = (nbyte && res->median > 0) ? nbyte / res->median / 1e6 : 0;
+
+    printf("%s\n  {\"name\": \"%s\", \"bytes\": %zu, \"samples\": %zu, "
+            "\"batch\": %zu, \"min_ns\": %.1f, \"median_ns\": %.1f, "
+            "\"p99_ns\": %.1f, \"mean_ns\": %.1f, \"mb_per_s\": %.2f}",
+            n_results ? "," : "", name, nbyte, res->n_samples, res->batch,
+            1e9*res->min, 1e9*res->median, 1e9*res->p99, 1e9*res->mean, mbs);
+    fprintf(stderr, "%-40s %12zu %12.0f %12.0f %10.1f\n",
+            name, nbyte, 1e9*res->median, 1e9*res->p99, mbs);
+    fflush(stdout);
+    n_results++;
+}
+
+void bench_json_end(void)
+{
+    printf("\n]}\n");
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,151 @@
+/*==============================================================================
+ *     File: bench_aes.c
+ *  Created: 10/17/2026, 10:20
+ *   Author: Bernie Roesler
+ *
+ *  Description: Throughput of AES 128-bit block calls, in blocks/second
+ *
+ *============================================================================*/
+#include "header.h"
+#include "aes_openssl.h"
+#include "crypto_util.h"
+#include "crypto1.h"
+#include "bench.h"
+
+/* Size of data/7.txt once base64-decoded */
+#define SMALL_LEN 2880
+#define LARGE_LEN (100*1024*1024)
+
+/*------------------------------------------------------------------------------
+ *         One-shot path: fresh context and output buffer for every block
+ *----------------------------------------------------------------------------*/
+static void oneshot_blocks(BYTE *y, BYTE *x, size_t n_blocks, BYTE *key)
+{
+    BYTE *yi = NULL;
+    size_t len = 0;
+    for (size_t i = 0; i < n_blocks; i++) {
+        aes_128_ecb_block(&yi, &len, x + i*BLOCK_SIZE, BLOCK_SIZE, key, 1);
+        memcpy(y + i*BLOCK_SIZE, yi, len);
+        free(yi);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         Keyed context, one block per call
+ *----------------------------------------------------------------------------*/
+static void ctx_single_blocks(BYTE *y, BYTE *x, size_t n_blocks, AES_CTX *ctx)
+{
+    for (size_t i = 0; i < n_blocks; i++) {
+        aes_128_encrypt_block(ctx, y + i*BLOCK_SIZE, x + i*BLOCK_SIZE);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         Run all paths over nbyte of input, on every available backend
+ *----------------------------------------------------------------------------*/
+static void bench_size(size_t nbyte, BYTE *key)
+{
+    size_t n_blocks = nbyte / BLOCK_SIZE,
+           reps = 0;
+    double secs = 0;
+    char name[MAX_CHAR];
+    BYTE *x = rand_byte(nbyte);
+    BYTE *y = init_byte(nbyte);
+
+    BENCH_LOOP(reps, secs, oneshot_blocks(y, x, n_blocks, key));
+    BENCH_REPORT("aes_128_ecb_block (one-shot)", nbyte, "blocks", reps*n_blocks/secs);
+
+    for (int b = 0; b < AES_BACKEND_COUNT; b++) {
+        if (!aes_backend_available(b)) { continue; }
+        AES_CTX *ctx = init_aes_ctx_backend(key, 1, b);
+
+        BENCH_LOOP(reps, secs, ctx_single_blocks(y, x, n_blocks, ctx));
+        snprintf(name, MAX_CHAR, "%s, 1 block/call", aes_backend_name(b));
+        BENCH_REPORT(name, nbyte, "blocks", reps*n_blocks/secs);
+
+        BENCH_LOOP(reps, secs, aes_128_encrypt_blocks(ctx, y, x, n_blocks));
+        snprintf(name, MAX_CHAR, "%s, N blocks/call", aes_backend_name(b));
+        BENCH_REPORT(name, nbyte, "blocks", reps*n_blocks/secs);
+
+        free_aes_ctx(ctx);
+    }
+
+    free(x);
+    free(y);
+}
+
+/*------------------------------------------------------------------------------
+ *         Cycles per byte of bulk encryption, per backend
+ *----------------------------------------------------------------------------*/
+static void bench_cpb(size_t nbyte, BYTE *key)
+{
+    size_t n_blocks = nbyte / BLOCK_SIZE,
+           reps = 0;
+    double secs = 0;
+    char name[MAX_CHAR];
+    BYTE *x = rand_byte(nbyte);
+    BYTE *y = init_byte(nbyte);
+
+    for (int b = 0; b < AES_BACKEND_COUNT; b++) {
+        if (!aes_backend_available(b)) { continue; }
+        AES_CTX *ctx = init_aes_ctx_backend(key, 1, b);
+
+        unsigned long long c0 = BENCH_TSC();
+        BENCH_LOOP(reps, secs, aes_128_encrypt_blocks(ctx, y, x, n_blocks));
+        unsigned long long c1 = BENCH_TSC();
+        (void)secs;     /* only the cycle count matters here */
+
+        snprintf(name, MAX_CHAR, "%s, encrypt", aes_backend_name(b));
+        BENCH_REPORT_CPB(name, nbyte, (double)(c1 - c0) / (reps*nbyte));
+
+        free_aes_ctx(ctx);
+    }
+
+    free(x);
+    free(y);
+}
+
+/*------------------------------------------------------------------------------
+ *         Whole-message ECB, allocating and in-place
+ *----------------------------------------------------------------------------*/
+static void ecb_alloc(BYTE *x, size_t nbyte, BYTE *key)
+{
+    BYTE *y = NULL;
+    size_t y_len = 0;
+    aes_128_ecb_cipher(&y, &y_len, x, nbyte, key, 1);
+    free(y);
+}
+
+static void bench_ecb_size(size_t nbyte, BYTE *key)
+{
+    size_t reps = 0;
+    double secs = 0;
+    BYTE *x = rand_byte(AES_ECB_LEN(nbyte));
+
+    BENCH_LOOP(reps, secs, ecb_alloc(x, nbyte, key));
+    BENCH_REPORT("aes_128_ecb_cipher", nbyte, "bytes", reps*nbyte/secs);
+
+    BENCH_LOOP(reps, secs, aes_128_ecb_cipher_into(x, x, nbyte, key, 1));
+    BENCH_REPORT("aes_128_ecb_cipher_into", nbyte, "bytes", reps*nbyte/secs);
+
+    free(x);
+}
+
+/*------------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    BYTE key[] = "YELLOW SUBMARINE";
+    srand(56);
+    bench_size(SMALL_LEN, key);
+    bench_size(LARGE_LEN, key);
+    bench_cpb(SMALL_LEN, key);
+    bench_cpb(LARGE_LEN, key);
+    bench_ecb_size(SMALL_LEN, key);
+    bench_ecb_size(LARGE_LEN, key);
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
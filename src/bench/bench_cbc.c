@@ -0,0 +1,94 @@
+/*==============================================================================
+ *     File: bench_cbc.c
+ *  Created: 10/17/2026, 15:10
+ *   Author: Bernie Roesler
+ *
+ *  Description: CBC decryption throughput and its scaling with threads.
+ *      Usage: bench_cbc [size in MB] [max threads]
+ *
+ *============================================================================*/
+#include "header.h"
+#include "aes_openssl.h"
+#include "crypto_util.h"
+#include "crypto2.h"
+#include "bench.h"
+
+#define DEFAULT_MB 256
+
+/* Width of the longest bar in the scaling chart */
+#define BAR_WIDTH 40
+
+/*------------------------------------------------------------------------------
+ *         Reference: one block per call, as CBC decryption used to be
+ *----------------------------------------------------------------------------*/
+static void cbc_decrypt_serial(BYTE *x, const BYTE *y, size_t n_blocks,
+        AES_CTX *ctx, const BYTE *iv)
+{
+    for (size_t i = 0; i < n_blocks; i++) {
+        const BYTE *yim1 = i ? y + (i-1)*BLOCK_SIZE : iv;
+        BYTE *xi = x + i*BLOCK_SIZE;
+        aes_128_decrypt_block(ctx, xi, y + i*BLOCK_SIZE);
+        for (size_t j = 0; j < BLOCK_SIZE; j++) { xi[j] ^= yim1[j]; }
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    size_t nbyte = (size_t)(argc > 1 ? atol(argv[1]) : DEFAULT_MB) << 20,
+           n_blocks = nbyte / BLOCK_SIZE,
+           reps = 0;
+    int max_threads = argc > 2 ? atoi(argv[2]) : util_nthreads();
+    double secs = 0,
+           rate[max_threads+1];
+    BYTE key[] = "YELLOW SUBMARINE";
+    BYTE iv[BLOCK_SIZE] = {0};
+    BYTE *y = rand_byte(nbyte);
+    BYTE *x = init_byte(nbyte);
+
+    if (max_threads < 1) { max_threads = 1; }
+
+    /* Fault in the output pages so the first measurement doesn't pay for it */
+    memset(x, 0xff, nbyte);
+
+    printf("AES backend: %s\n", aes_backend_name(aes_default_backend()));
+
+    /*---------- Baselines ----------*/
+    AES_CTX *ctx = init_aes_ctx(key, 0);
+    BENCH_LOOP(reps, secs, aes_128_decrypt_blocks(ctx, x, y, n_blocks));
+    BENCH_REPORT("ECB decrypt, 1 thread", nbyte, "bytes", reps*nbyte/secs);
+
+    BENCH_LOOP(reps, secs, cbc_decrypt_serial(x, y, n_blocks, ctx, iv));
+    BENCH_REPORT("CBC decrypt, 1 block/call", nbyte, "bytes", reps*nbyte/secs);
+    free_aes_ctx(ctx);
+
+    /*---------- Scaling with threads ----------*/
+    for (int t = 1; t <= max_threads; t++) {
+        char name[MAX_CHAR];
+        BENCH_LOOP(reps, secs,
+                aes_128_cbc_decrypt_blocks(x, y, n_blocks, key, iv, t));
+        rate[t] = reps*nbyte/secs;
+        snprintf(name, MAX_CHAR, "CBC decrypt, %d thread%s", t, t > 1 ? "s" : "");
+        BENCH_REPORT(name, nbyte, "bytes", rate[t]);
+    }
+
+    /* Chart of speedup relative to one thread */
+    double best = 0;
+    for (int t = 1; t <= max_threads; t++) { best = rate[t] > best ? rate[t] : best; }
+    printf("\nthreads  speedup\n");
+    for (int t = 1; t <= max_threads; t++) {
+        int bar = (int)(BAR_WIDTH * rate[t] / best + 0.5);
+        printf("%7d  %6.2fx  ", t, rate[t] / rate[1]);
+        for (int i = 0; i < bar; i++) { putchar('#'); }
+        putchar('\n');
+    }
+
+    free(x);
+    free(y);
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
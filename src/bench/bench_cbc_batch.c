@@ -0,0 +1,96 @@
+/*==============================================================================
+ *     File: bench_cbc_batch.c
+ *  Created: 10/17/2026, 16:05
+ *   Author: Bernie Roesler
+ *
+ *  Description: Many small CBC encryptions: one call per message vs. one
+ *      lockstep batch, in messages/second
+ *
+ *============================================================================*/
+#include "header.h"
+#include "aes_openssl.h"
+#include "crypto_util.h"
+#include "crypto2.h"
+#include "bench.h"
+
+#define N_MSG 10000
+#define MAX_MSG_LEN 64      /* about the size of a profile string */
+
+/*------------------------------------------------------------------------------
+ *         One aes_128_cbc_encrypt call per message
+ *----------------------------------------------------------------------------*/
+static void encrypt_loop(CBC_MSG *msg, size_t n_msg)
+{
+    for (size_t j = 0; j < n_msg; j++) {
+        aes_128_cbc_encrypt(&msg[j].y, &msg[j].y_len, (BYTE *)msg[j].x,
+                msg[j].x_len, (BYTE *)msg[j].key, (BYTE *)msg[j].iv);
+        free(msg[j].y);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         All messages in one batch
+ *----------------------------------------------------------------------------*/
+static void encrypt_batch(CBC_MSG *msg, size_t n_msg)
+{
+    aes_128_cbc_encrypt_batch(msg, n_msg);
+    for (size_t j = 0; j < n_msg; j++) { free(msg[j].y); }
+}
+
+/*------------------------------------------------------------------------------
+ *         Run both with one shared key, then with a key per message
+ *----------------------------------------------------------------------------*/
+static void bench_keys(CBC_MSG *msg, size_t n_msg, int shared)
+{
+    size_t nbyte = 0,
+           reps = 0;
+    double secs = 0;
+    char name[MAX_CHAR];
+    BYTE *keys = rand_byte(n_msg*BLOCK_SIZE);
+    const char *label = shared ? "shared key" : "key/msg";
+
+    for (size_t j = 0; j < n_msg; j++) {
+        msg[j].key = keys + (shared ? 0 : j*BLOCK_SIZE);
+        nbyte += msg[j].x_len;
+    }
+
+    BENCH_LOOP(reps, secs, encrypt_loop(msg, n_msg));
+    snprintf(name, MAX_CHAR, "loop, %s", label);
+    BENCH_REPORT(name, nbyte, "msgs", reps*n_msg/secs);
+
+    BENCH_LOOP(reps, secs, encrypt_batch(msg, n_msg));
+    snprintf(name, MAX_CHAR, "batch, %s", label);
+    BENCH_REPORT(name, nbyte, "msgs", reps*n_msg/secs);
+
+    free(keys);
+}
+
+/*------------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    CBC_MSG *msg = calloc(N_MSG, sizeof(CBC_MSG));
+    BYTE *iv = rand_byte(BLOCK_SIZE);
+    MALLOC_CHECK(msg);
+
+    srand(56);
+    printf("AES backend: %s\n", aes_backend_name(aes_default_backend()));
+
+    for (size_t j = 0; j < N_MSG; j++) {
+        msg[j].x_len = RAND_RANGE(1, MAX_MSG_LEN);
+        msg[j].x = rand_byte(msg[j].x_len);
+        msg[j].iv = iv;
+    }
+
+    bench_keys(msg, N_MSG, 1);
+    bench_keys(msg, N_MSG, 0);
+
+    for (size_t j = 0; j < N_MSG; j++) { free((BYTE *)msg[j].x); }
+    free(msg);
+    free(iv);
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
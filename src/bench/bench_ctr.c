@@ -0,0 +1,110 @@
+/*==============================================================================
+ *     File: bench_ctr.c
+ *  Created: 10/17/2026, 16:40
+ *   Author: Bernie Roesler
+ *
+ *  Description: CTR mode throughput: the old byte-at-a-time stream loop vs.
+ *      the chunked FILE* interface vs. the buffer API vs. the threaded,
+ *      memory-mapped file mode.
+ *      Usage: bench_ctr [size in MB] [max threads]
+ *
+ *============================================================================*/
+#include "header.h"
+#include "aes_openssl.h"
+#include "crypto_util.h"
+#include "crypto3.h"
+#include "bench.h"
+
+#define DEFAULT_MB 64
+
+/* Scratch files for the file mode */
+#define IN_FILE  "/tmp/bench_ctr_in.bin"
+#define OUT_FILE "/tmp/bench_ctr_out.bin"
+
+/*------------------------------------------------------------------------------
+ *         Reference: fgetc/fputc, one keystream block per call
+ *----------------------------------------------------------------------------*/
+static void ctr_bytewise(FILE *y, FILE *x, BYTE *key, BYTE *nonce)
+{
+    int c;
+    BYTE counter[BLOCK_SIZE/2] = {0};
+
+    do {
+        BYTE *keystream = get_keystream_block(key, nonce, counter);
+        int n = 0;
+        while ((n < BLOCK_SIZE) && ((c = fgetc(x)) != EOF)) {
+            fputc(c ^ keystream[n++], y);
+        }
+        inc64le(counter);
+        free(keystream);
+    } while (!feof(x));
+}
+
+/*------------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    size_t nbyte = (size_t)(argc > 1 ? atol(argv[1]) : DEFAULT_MB) << 20,
+           reps = 0;
+    int max_threads = argc > 2 ? atoi(argv[2]) : util_nthreads();
+    double secs = 0;
+    BYTE key[] = "YELLOW SUBMARINE";
+    BYTE nonce[BLOCK_SIZE/2] = {0};
+    BYTE *x = rand_byte(nbyte);
+    BYTE *y = init_byte(nbyte);
+
+    /* Streams backed by temporary files, as a file tool would see them */
+    FILE *xs = tmpfile(),
+         *ys = tmpfile();
+    if (!xs || !ys) { ERROR("Could not open temporary files!"); }
+    if (fwrite(x, 1, nbyte, xs) != nbyte) { ERROR("Write failed!"); }
+
+    printf("AES backend: %s\n", aes_backend_name(aes_default_backend()));
+
+    /* The old path is slow enough that a sixteenth of the data is plenty */
+    size_t small = nbyte / 16;
+    FILE *xsmall = tmpfile();
+    if (!xsmall || fwrite(x, 1, small, xsmall) != small) { ERROR("Write failed!"); }
+    BENCH_LOOP(reps, secs, do {
+            rewind(xsmall); rewind(ys);
+            ctr_bytewise(ys, xsmall, key, nonce);
+        } while (0));
+    BENCH_REPORT("CTR fgetc/fputc", small, "bytes", reps*small/secs);
+
+    BENCH_LOOP(reps, secs, do {
+            rewind(xs); rewind(ys);
+            aes_128_ctr(ys, xs, key, nonce);
+        } while (0));
+    BENCH_REPORT("CTR FILE*, 64 KB chunks", nbyte, "bytes", reps*nbyte/secs);
+
+    BENCH_LOOP(reps, secs, aes_128_ctr_buf(y, x, nbyte, key, nonce));
+    BENCH_REPORT("CTR buffer", nbyte, "bytes", reps*nbyte/secs);
+
+    BENCH_LOOP(reps, secs, aes_128_ctr_buf(y, y, nbyte, key, nonce));
+    BENCH_REPORT("CTR buffer, in place", nbyte, "bytes", reps*nbyte/secs);
+
+    /* Whole files, mapped and split over threads */
+    FILE *fp = fopen(IN_FILE, "w");
+    if (!fp || fwrite(x, 1, nbyte, fp) != nbyte) { ERROR("Write failed!"); }
+    fclose(fp);
+    for (int t = 1; t <= max_threads; t *= 2) {
+        char name[MAX_CHAR];
+        BENCH_LOOP(reps, secs,
+                aes_128_ctr_file(OUT_FILE, IN_FILE, key, nonce, t));
+        snprintf(name, MAX_CHAR, "CTR file, mmap, %d thread%s", t, t > 1 ? "s" : "");
+        BENCH_REPORT(name, nbyte, "bytes", reps*nbyte/secs);
+    }
+    remove(IN_FILE);
+    remove(OUT_FILE);
+
+    fclose(xs);
+    fclose(ys);
+    fclose(xsmall);
+    free(x);
+    free(y);
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
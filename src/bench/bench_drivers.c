@@ -0,0 +1,115 @@
+/*==============================================================================
+ *     File: bench_drivers.c
+ *  Created: 10/17/2026, 17:45
+ *   Author: Bernie Roesler
+ *
+ *  Description: End-to-end time of each challenge binary on the data/ files,
+ *      as JSON on stdout. Build the sets first; missing binaries are skipped.
+ *
+ *============================================================================*/
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include "header.h"
+#include "bench.h"
+
+/* Whole runs take far longer than a sample needs, so take fewer */
+#define DRIVER_SAMPLES 11
+
+/* Scratch output of aes_ctr_file, removed at the end */
+#define CTR_OUT "aes_ctr_file.out"
+
+extern char **environ;
+
+/* Command lines, relative to src/bench/ */
+typedef struct _DRIVER {
+    const char *name;
+    const char *argv[4];
+} DRIVER;
+
+static const DRIVER DRIVERS[] = {
+    { "set1/find_single_byte_xor 4.txt",
+        { "../set1/find_single_byte_xor", "../../data/4.txt" } },
+    { "set1/break_repeating_xor 6.txt",
+        { "../set1/break_repeating_xor", "../../data/6.txt" } },
+    { "set1/aes_ecb_file 7.txt",
+        { "../set1/aes_ecb_file", "../../data/7.txt", "0" } },
+    { "set1/find_ecb 8.txt",
+        { "../set1/find_ecb", "../../data/8.txt" } },
+    { "set2/aes_cbc_file 10.txt",
+        { "../set2/aes_cbc_file", "../../data/10.txt" } },
+    { "set2/detect_block_mode",
+        { "../set2/detect_block_mode" } },
+    { "set2/one_byte_ecb easy",
+        { "../set2/one_byte_ecb", "easy" } },
+    { "set2/one_byte_ecb hard",
+        { "../set2/one_byte_ecb", "hard" } },
+    { "set2/make_admin_profile",
+        { "../set2/make_admin_profile" } },
+    { "set2/cbc_bit_flip",
+        { "../set2/cbc_bit_flip" } },
+    { "set3/cbc_padding_oracle_main",
+        { "../set3/cbc_padding_oracle_main" } },
+    { "set3/aes_ctr_file 7.txt",
+        { "../set3/aes_ctr_file", "../../data/7.txt", CTR_OUT } },
+};
+
+#define N_DRIVERS (sizeof(DRIVERS) / sizeof(DRIVERS[0]))
+
+/*------------------------------------------------------------------------------
+ *         Run one command line to completion, output discarded
+ *----------------------------------------------------------------------------*/
+static int run(const DRIVER *d)
+{
+    posix_spawn_file_actions_t fa;
+    pid_t pid;
+    int status = 0;
+
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&fa, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    if (posix_spawn(&pid, d->argv[0], &fa, NULL, (char * const *)d->argv,
+                environ)) {
+        status = -1;
+    } else if (waitpid(pid, &status, 0) < 0) {
+        status = -1;
+    }
+
+    posix_spawn_file_actions_destroy(&fa);
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    BENCH_RESULT res;
+
+    bench_json_begin("drivers");
+
+    for (size_t i = 0; i < N_DRIVERS; i++) {
+        const DRIVER *d = &DRIVERS[i];
+
+        if (access(d->argv[0], X_OK)) {
+            fprintf(stderr, "%-40s not built, skipped\n", d->name);
+            continue;
+        }
+        if (run(d)) {
+            fprintf(stderr, "%-40s failed, skipped\n", d->name);
+            continue;
+        }
+
+        BENCH_SAMPLE(res, DRIVER_SAMPLES, run(d));
+        bench_json_result(d->name, 0, &res);
+    }
+
+    bench_json_end();
+    remove(CTR_OUT);
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
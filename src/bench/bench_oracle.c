@@ -0,0 +1,94 @@
+/*==============================================================================
+ *     File: bench_oracle.c
+ *  Created: 10/17/2026, 19:40
+ *   Author: Bernie Roesler
+ *
+ *  Description: Padding-oracle calls per second, with and without the AES
+ *      context cache. The oracle is the one from Challenge 17: CBC-decrypt a
+ *      chosen 2-block ciphertext under a fixed key and report the padding.
+ *
+ *============================================================================*/
+#include "header.h"
+#include "aes_openssl.h"
+#include "crypto_util.h"
+#include "crypto2.h"
+#include "bench.h"
+
+/* Oracle calls per timed repetition: one byte's worth of guesses */
+#define N_GUESS 256
+
+static BYTE *oracle_key = NULL,
+            *oracle_iv  = NULL;
+
+/* padding_oracle() as it was, with a heap buffer per call */
+static int padding_oracle_alloc(BYTE *y, size_t y_len)
+{
+    BYTE *x = NULL;
+    size_t x_len = 0;
+    int test = aes_128_cbc_decrypt(&x, &x_len, y, y_len, oracle_key, oracle_iv);
+    free(x);
+    return test;
+}
+
+/* Same as padding_oracle() in cbc_padding_oracle.c */
+static int padding_oracle_into(BYTE *y, size_t y_len)
+{
+    BYTE x[y_len + 1];
+    ssize_t x_len = aes_128_cbc_decrypt_into(x, y, y_len, oracle_key, oracle_iv);
+    return x_len < 0 ? -1 : (int)(y_len - y_len % BLOCK_SIZE - x_len);
+}
+
+static int (*padding_oracle)(BYTE *y, size_t y_len) = padding_oracle_alloc;
+
+/* Guess every value of the last byte of r in r || y, as the attack does */
+static int guess_byte(BYTE *ry)
+{
+    int n_valid = 0;
+    for (int i = 0; i < N_GUESS; i++) {
+        ry[BLOCK_SIZE-1] = i;
+        n_valid += (0 < padding_oracle(ry, 2*BLOCK_SIZE));
+    }
+    return n_valid;
+}
+
+/*------------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    size_t reps = 0,
+           hits = 0,
+           misses = 0;
+    double secs = 0;
+    BYTE *ry = rand_byte(2*BLOCK_SIZE);
+    oracle_key = rand_byte(BLOCK_SIZE);
+    oracle_iv = rand_byte(BLOCK_SIZE);
+
+    printf("AES backend: %s\n", aes_backend_name(aes_default_backend()));
+
+    aes_ctx_cache_enable(0);
+    BENCH_LOOP(reps, secs, guess_byte(ry));
+    BENCH_REPORT("oracle, schedule per call", 2*BLOCK_SIZE, "calls",
+            reps*N_GUESS/secs);
+
+    aes_ctx_cache_enable(1);
+    BENCH_LOOP(reps, secs, guess_byte(ry));
+    BENCH_REPORT("oracle, cached schedule", 2*BLOCK_SIZE, "calls",
+            reps*N_GUESS/secs);
+
+    padding_oracle = padding_oracle_into;
+    BENCH_LOOP(reps, secs, guess_byte(ry));
+    BENCH_REPORT("oracle, cached schedule, no malloc", 2*BLOCK_SIZE,
+            "calls", reps*N_GUESS/secs);
+
+    aes_ctx_cache_stats(&hits, &misses);
+    printf("cache: %zu hits, %zu misses\n", hits, misses);
+
+    free(ry);
+    free(oracle_key);
+    free(oracle_iv);
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,319 @@
+/*==============================================================================
+ *     File: bench_primitives.c
+ *  Created: 10/17/2026, 17:20
+ *   Author: Bernie Roesler
+ *
+ *  Description: Median and p99 time of every primitive, as JSON on stdout
+ *
+ *============================================================================*/
+#include "header.h"
+#include "aes_openssl.h"
+#include "crypto_util.h"
+#include "crypto1.h"
+#include "crypto2.h"
+#include "crypto3.h"
+#include "bench.h"
+
+/* Benchmarks run from src/bench/ */
+#define DATA_PATH "../../data/"
+
+/* Sizes of the codec and AES inputs */
+static const size_t CODEC_LEN[] = { 64, 4096, 1 << 20 };
+static const size_t AES_LEN[]   = { 16, 1024, 1 << 16, 1 << 20 };
+
+#define N_SIZES(a) (sizeof(a) / sizeof((a)[0]))
+
+/* Results the compiler must not throw away */
+static volatile unsigned long sink = 0;
+
+/*------------------------------------------------------------------------------
+ *         Helpers
+ *----------------------------------------------------------------------------*/
+static void stream_decode(BYTE *y, const char *b64, size_t nchar)
+{
+    B64_STREAM s;
+    b64_stream_init(&s);
+    sink += b64_stream_update(&s, y, b64, nchar);
+}
+
+static void single_byte(const BYTE *y, size_t n)
+{
+    XOR_NODE *node = single_byte_xor_decode(y, n);
+    sink += node->key[0];
+    free(node);
+}
+
+static void key_lengths(const BYTE *y, size_t n)
+{
+    TOPK lens;
+    topk_init(&lens, XOR_TOP_K);
+    get_key_lengths(&lens, y, n);
+    sink += lens.item[0].value;
+}
+
+static void break_repeating(const BYTE *y, size_t n, size_t n_len)
+{
+    XOR_NODE *node = break_repeating_xor_top(y, n, n_len);
+    sink += node->key_byte;
+    free(node);
+}
+
+/*------------------------------------------------------------------------------
+ *         Hex, base64 and XOR
+ *----------------------------------------------------------------------------*/
+static void bench_codecs(void)
+{
+    BENCH_RESULT res;
+    char name[MAX_CHAR];
+
+    for (size_t k = 0; k < N_SIZES(CODEC_LEN); k++) {
+        size_t n = CODEC_LEN[k];
+        BYTE *x = rand_byte(n),
+             *y = init_byte(n);
+        char *hex = init_str(BYTE2HEX_LEN(n)),
+             *b64 = init_str(BYTE2B64_LEN(n)),
+             *wrap = init_str(B64_WRAP_LEN(n, B64_WIDTH_DATA));
+        size_t n_hex = byte2hex_into(hex, x, n),
+               n_b64 = byte2b64_into(b64, x, n);
+
+        snprintf(name, MAX_CHAR, "byte2hex_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, byte2hex_into(hex, x, n));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "byte2hex_lower_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, byte2hex_lower_into(hex, x, n));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "hex2byte_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, hex2byte_into(y, hex, n_hex));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "byte2b64_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, byte2b64_into(b64, x, n));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "b64_encode_scalar %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, b64_encode_scalar(b64, x, n));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "b64_encode_wrap 60 %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES,
+                b64_encode_wrap(wrap, x, n, B64_WIDTH_DATA));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "b642byte_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, b642byte_into(y, b64, n_b64));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "b64_decode_scalar %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, b64_decode_scalar(y, b64, n_b64));
+        bench_json_result(name, n, &res);
+
+        /* As read from a data file */
+        size_t n_wrap = b64_encode_wrap(wrap, x, n, B64_WIDTH_DATA);
+        snprintf(name, MAX_CHAR, "b64_stream_update 60 %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, stream_decode(y, wrap, n_wrap));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "fixed_xor_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, fixed_xor_into(y, x, y, n));
+        bench_json_result(name, n, &res);
+
+        /* A key inside the rotating window, and one past it */
+        snprintf(name, MAX_CHAR, "repeating_key_xor_into 3 %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES,
+                repeating_key_xor_into(y, x, x, n, MIN(n, 3)));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "repeating_key_xor_into 100 %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES,
+                repeating_key_xor_into(y, x, x, n, MIN(n, 100)));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "hamming_weight %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, sink += hamming_weight(x, n));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "hamming_xor %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, sink += hamming_xor(x, y, n));
+        bench_json_result(name, n, &res);
+
+        /* Every shift up to the default longest key */
+        uint64_t same[XOR_MAX_KEY_LEN + 1];
+        snprintf(name, MAX_CHAR, "coincidence_autocorr 40 %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES,
+                coincidence_autocorr(same, x, n, XOR_MAX_KEY_LEN));
+        sink += same[1];
+        bench_json_result(name, n, &res);
+
+        free(x);
+        free(y);
+        free(hex);
+        free(b64);
+        free(wrap);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         Set 1 attacks on real text
+ *----------------------------------------------------------------------------*/
+static void bench_attacks(void)
+{
+    BENCH_RESULT res;
+    char *text = NULL;
+    size_t n_text = file2str(&text, DATA_PATH "play_that_funky_music.txt");
+
+    /* One line of data/4.txt is 30 bytes; use a sentence of English */
+    size_t n = MIN(n_text, 60);
+    BYTE key = 'X';
+    BYTE *y = init_byte(n);
+    repeating_key_xor_into(y, (BYTE *)text, &key, n, 1);
+
+    BENCH_SAMPLE(res, BENCH_SAMPLES, sink += char_freq_score((BYTE *)text, n));
+    bench_json_result("char_freq_score 60", n, &res);
+
+    BENCH_SAMPLE(res, BENCH_SAMPLES, single_byte(y, n));
+    bench_json_result("single_byte_xor_decode 60", n, &res);
+
+    /* Language model scoring against chi-squared, on a sentence and on
+     * the whole text */
+    NGRAM *model[NGRAM_MAX_ORDER + 1] = { NULL };
+    for (int order = 1; order <= NGRAM_MAX_ORDER; order += 2) {
+        if (!(model[order] = ngram_load(DATA_PATH "english.ngram", order))) {
+            ERROR("Could not load english.ngram!");
+        }
+        size_t lens[] = { n, n_text };
+        for (size_t k = 0; k < N_SIZES(lens); k++) {
+            char name[MAX_CHAR];
+            snprintf(name, MAX_CHAR, "ngram_score order %d %zu", order, lens[k]);
+            BENCH_SAMPLE(res, BENCH_SAMPLES,
+                    sink += ngram_score(model[order], (BYTE *)text, lens[k]));
+            bench_json_result(name, lens[k], &res);
+
+            snprintf(name, MAX_CHAR, "ngram_score_scalar order %d %zu",
+                    order, lens[k]);
+            BENCH_SAMPLE(res, BENCH_SAMPLES, sink += ngram_score_scalar(
+                        model[order], (BYTE *)text, lens[k]));
+            bench_json_result(name, lens[k], &res);
+        }
+    }
+
+    BENCH_SAMPLE(res, BENCH_SAMPLES,
+            sink += char_freq_score((BYTE *)text, n_text));
+    bench_json_result("char_freq_score whole", n_text, &res);
+
+    set_xor_model(model[NGRAM_MAX_ORDER]);
+    BENCH_SAMPLE(res, BENCH_SAMPLES, single_byte(y, n));
+    bench_json_result("single_byte_xor_decode ngram 60", n, &res);
+    set_xor_model(NULL);
+
+    BYTE *ctext = NULL;
+    ssize_t n_ctext = b64_file2byte(&ctext, DATA_PATH "6.txt");
+    if (n_ctext < 0) { ERROR("6.txt is not valid base64!"); }
+    BENCH_SAMPLE(res, BENCH_SAMPLES, key_lengths(ctext, n_ctext));
+    bench_json_result("get_key_lengths 6.txt", n_ctext, &res);
+
+    /* Key lengths tried in full */
+    static const size_t TOP_K[] = { 1, XOR_TOP_K, 5 };
+    for (size_t k = 0; k < N_SIZES(TOP_K); k++) {
+        char name[MAX_CHAR];
+        snprintf(name, MAX_CHAR, "break_repeating_xor K=%zu 6.txt", TOP_K[k]);
+        BENCH_SAMPLE(res, 21, break_repeating(ctext, n_ctext, TOP_K[k]));
+        bench_json_result(name, n_ctext, &res);
+    }
+
+    free(text);
+    free(y);
+    free(ctext);
+    for (int order = 1; order <= NGRAM_MAX_ORDER; order++) {
+        ngram_free(model[order]);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         AES modes
+ *----------------------------------------------------------------------------*/
+static void bench_aes_modes(void)
+{
+    BENCH_RESULT res;
+    char name[MAX_CHAR];
+    BYTE *key = rand_byte(BLOCK_SIZE),
+         *iv  = rand_byte(BLOCK_SIZE);
+
+    for (size_t k = 0; k < N_SIZES(AES_LEN); k++) {
+        size_t n = AES_LEN[k],
+               n_pad = PKCS7_LEN(n, BLOCK_SIZE);
+        BYTE *x = rand_byte(n_pad),
+             *y = init_byte(n_pad),
+             *z = init_byte(n_pad);
+
+        snprintf(name, MAX_CHAR, "aes_128_ecb_cipher_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES,
+                aes_128_ecb_cipher_into(y, x, n, key, 1));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "aes_128_cbc_encrypt_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES,
+                aes_128_cbc_encrypt_into(y, x, n, key, iv));
+        bench_json_result(name, n, &res);
+
+        /* Decrypt a ciphertext that carries its own padding */
+        pkcs7_pad_into(x, x, n, BLOCK_SIZE);
+        aes_128_cbc_encrypt_into(y, x, n_pad, key, iv);
+        snprintf(name, MAX_CHAR, "aes_128_cbc_decrypt_into %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES,
+                aes_128_cbc_decrypt_into(z, y, n_pad, key, iv));
+        bench_json_result(name, n, &res);
+
+        snprintf(name, MAX_CHAR, "aes_128_ctr_buf %zu", n);
+        BENCH_SAMPLE(res, BENCH_SAMPLES, aes_128_ctr_buf(y, x, n, key, iv));
+        bench_json_result(name, n, &res);
+
+        free(x);
+        free(y);
+        free(z);
+    }
+
+    free(key);
+    free(iv);
+}
+
+/*------------------------------------------------------------------------------
+ *         Mersenne Twister
+ *----------------------------------------------------------------------------*/
+static void bench_twister(void)
+{
+    BENCH_RESULT res;
+    RNG_MT *rng = init_rng_mt();
+    srand_mt(rng, 5489);
+    unsigned long y = rand_int32(rng);
+
+    BENCH_SAMPLE(res, BENCH_SAMPLES, sink += rand_int32(rng));
+    bench_json_result("rand_int32", sizeof(uint32_t), &res);
+
+    BENCH_SAMPLE(res, BENCH_SAMPLES, y = untemper(y ^ sink));
+    sink += y;
+    bench_json_result("untemper", sizeof(uint32_t), &res);
+
+    free(rng);
+}
+
+/*------------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    srand(56);
+
+    bench_json_begin("primitives");
+    bench_codecs();
+    bench_attacks();
+    bench_aes_modes();
+    bench_twister();
+    bench_json_end();
+
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
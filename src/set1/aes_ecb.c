@@ -15,53 +15,73 @@
  *----------------------------------------------------------------------------*/
 int aes_128_ecb_cipher(BYTE **y, size_t *y_len, BYTE *x, size_t x_len, BYTE *key, int enc)
 {
-    size_t len = 0;     /* intermediate length */
-    *y_len = 0;         /* output length */
-    BYTE *xi = NULL,    /* one block plaintext input */
-         *yi = NULL;    /* one block output of AES encryption */
-    int n_pad = 0;
+    /* initialize output byte array, just big enough for the padded input */
+    *y = init_byte(AES_ECB_LEN(x_len));
 
-    /* Number of blocks needed */
-    size_t n_blocks = x_len / BLOCK_SIZE;
-    if (x_len % BLOCK_SIZE) { n_blocks++; }
-    size_t tot_len = BLOCK_SIZE * n_blocks;
+    ssize_t len = aes_128_ecb_cipher_into(*y, x, x_len, key, enc);
 
-    /* initialize output byte array with one extra block */
-    *y = init_byte(tot_len + BLOCK_SIZE);
+    /* Invalid padding leaves the whole decrypted array in place */
+    if (len < 0) {
+        *y_len = AES_ECB_LEN(x_len);
+        return -1;
+    }
 
-    /* Pad the input (n_pad only non-zero for last block) */
-    BYTE *x_pad = pkcs7_pad(x, x_len, BLOCK_SIZE);
+    *y_len = len;
+    return 0;
+}
 
-    /* Encrypt blocks of plaintext using Chain Block Cipher (CBC) mode */
-    for (size_t i = 0; i < n_blocks; i++) {
-        /* Input blocks */
-        xi = x_pad + i*BLOCK_SIZE;
+/*------------------------------------------------------------------------------
+ *         Encrypt/decrypt AES in ECB mode into caller buffer
+ *----------------------------------------------------------------------------*/
+ssize_t aes_128_ecb_cipher_into(BYTE *y, const BYTE *x, size_t x_len,
+        const BYTE *key, int enc)
+{
+    /* y     : output, at least AES_ECB_LEN(x_len) bytes
+     * x     : input. May be the same array as y (in-place), in which case it
+     *         must also have room for AES_ECB_LEN(x_len) bytes
+     * x_len : number of input bytes
+     * key   : 128-bit AES key
+     * enc   : 1 to encrypt, 0 to decrypt (and strip padding)
+     *
+     * returns : number of bytes in y, or -1 on invalid padding
+     */
+    size_t n_full = x_len / BLOCK_SIZE,     /* whole blocks of input */
+           n_rem  = x_len % BLOCK_SIZE,     /* bytes in last partial block */
+           y_len  = n_full * BLOCK_SIZE;    /* output length */
+    BYTE last[BLOCK_SIZE];                  /* padded last block */
+    int n_pad = 0;
 
-        /* Encrypt single block using key and AES cipher */
-        if (0 != aes_128_ecb_block(&yi, &len, xi, BLOCK_SIZE, key, enc)) {
-                ERROR("Encryption failed!");
-        }
+    /* Key schedule comes from the cache, else is expanded once here */
+    AES_CTX *ctx = aes_ctx_acquire(key, enc);
 
-        /* Append encrypted text to output array */
-        memcpy(*y + *y_len, yi, len);
-        *y_len += len;
-        free(yi);
+    /* Hand the entire run of whole blocks to the cipher in one call */
+    int err = enc ? aes_128_encrypt_blocks(ctx, y, x, n_full)
+                  : aes_128_decrypt_blocks(ctx, y, x, n_full);
+
+    /* Pad only the last partial block (PKCS#7), on the stack. NOTE input that
+     * is already a BLOCK_SIZE multiple gets no extra padding block. */
+    if (!err && n_rem) {
+        memcpy(last, x + y_len, n_rem);
+        memset(last + n_rem, BLOCK_SIZE - n_rem, BLOCK_SIZE - n_rem);
+        err = enc ? aes_128_encrypt_block(ctx, y + y_len, last)
+                  : aes_128_decrypt_block(ctx, y + y_len, last);
+        y_len += BLOCK_SIZE;
     }
 
-    /* Clean-up */
-    free(x_pad);
+    aes_ctx_release(ctx);
+    if (err) { ERROR("Encryption failed!"); }
 
     /* Remove padding on decryption, or return error code */
-    if (!enc) {
-        if ((n_pad = pkcs7_rmpad(*y, *y_len, BLOCK_SIZE)) < 0) {
+    if (!enc && y_len) {
+        if ((n_pad = pkcs7_rmpad(y, y_len, BLOCK_SIZE)) < 0) {
             return -1;
         }
 
         /* Adjust output length to removed padding */
-        *y_len -= n_pad;
+        y_len -= n_pad;
     }
 
-    return 0;
+    return y_len;
 }
 
 /*==============================================================================
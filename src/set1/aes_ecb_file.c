@@ -3,7 +3,8 @@
  *  Created: 07/28/2017, 14:53
  *   Author: Bernie Roesler
  *
- *  Description: Decrypt a file encrypted in AES 128-bit ECB mode
+ *  Description: Decrypt a file encrypted in AES 128-bit ECB mode. The file is
+ *      streamed a chunk at a time, so memory use doesn't grow with its size.
  *
  *============================================================================*/
 #include <stdio.h>
@@ -13,6 +14,19 @@
 #include "crypto_util.h"
 #include "crypto1.h"
 
+/* Cipher each chunk of decoded bytes and print it as it comes */
+typedef struct _SINK {
+    AES_STREAM *aes;
+    BYTE *out;              /* B64_EMIT_MAX + BLOCK_SIZE bytes */
+} SINK;
+
+static int cipher_chunk(void *arg, const BYTE *byte, size_t nbyte)
+{
+    SINK *sink = arg;
+    printall(sink->out, aes_stream_update(sink->aes, sink->out, byte, nbyte));
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     char *b64_file = NULL;
@@ -35,37 +49,30 @@ int main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
-    /* Read file into memory */
-    char *b64 = NULL;
-    (void)file2str(&b64, b64_file);
-    char *b64_clean = strrmchr(b64, "\n");  /* strip newlines */
-
-    /* Convert to byte array for decryption */
-    BYTE *byte = NULL;
-    size_t nbyte = b642byte(&byte, b64_clean);
-
-    /* Initialize the OpenSSL library */
-    /* OpenSSL_init(); */
+    FILE *fp = fopen(b64_file, "r");
+    if (!fp) { ERROR("File %s could not be read!", b64_file); }
 
     /* Define the key -- 16 byte == 128 bit key */
     BYTE key[] = "YELLOW SUBMARINE";
-    BYTE *plaintext = NULL;
-    size_t plaintext_len = 0;
+
+    /* Constant memory: one chunk of bytes and their cipher at a time */
+    BYTE *out = init_byte(B64_EMIT_MAX + BLOCK_SIZE);
+    AES_STREAM *aes = init_aes_stream(key, NULL, enc);
+    SINK sink = { aes, out };
 
     /*---------- Break the code! ----------*/
-    if (0 != aes_128_ecb_cipher(&plaintext, &plaintext_len, byte, nbyte, key, enc)) {
-        ERROR("Invalid padding!");
+    if (b64_decode_file(fp, cipher_chunk, &sink) < 0) {
+        ERROR("Could not decode %s!", b64_file);
     }
 
-    /* Write to stdout */
-    printall(plaintext, plaintext_len); /* works even for non-printables */
+    ssize_t n_last = aes_stream_final(aes, out);
+    if (n_last < 0) { ERROR("Invalid padding!"); }
+    printall(out, n_last);   /* works even for non-printables */
 
     /* Clean up */
-    /* OpenSSL_cleanup(); */
-    free(b64);
-    free(b64_clean);
-    free(byte);
-    free(plaintext);
+    free_aes_stream(aes);
+    free(out);
+    fclose(fp);
     return 0;
 }
 
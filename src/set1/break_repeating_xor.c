@@ -15,16 +15,20 @@
 
 int main(int argc, char **argv)
 {
-    char *b64_file = NULL;
+    char *b64_file = NULL,
+         *model_file = NULL;
     int v_flag = 0;
     int c;
 
     /* Get flags */
-    while ((c = getopt(argc, argv, "v")) != -1) {
+    while ((c = getopt(argc, argv, "vm:")) != -1) {
         switch (c) {
             case 'v':
                 v_flag = 1;
                 break;
+            case 'm':
+                model_file = optarg;
+                break;
             default:
                 abort();
         }
@@ -34,18 +38,23 @@ int main(int argc, char **argv)
     if (optind < argc) {
         b64_file = argv[optind];
     } else {
-        fprintf(stderr, "Usage: %s [base64_file]\n", argv[0]);
+        fprintf(stderr, "Usage: %s [-v] [-m model.ngram] [base64_file]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    /* Read file into memory */
-    char *b64 = NULL;
-    (void)file2str(&b64, b64_file);
-    char *b64_clean = strrmchr(b64, "\n");  /* strip newlines */
-
-    /* Convert to byte array for decryption */
+    /* Decode the file straight into a byte array for decryption */
     BYTE *byte = NULL;
-    size_t nbyte = b642byte(&byte, b64_clean);
+    ssize_t nbyte = b64_file2byte(&byte, b64_file);
+    if (nbyte < 0) { ERROR("Could not decode %s!", b64_file); }
+
+    /* Score with a trigram model instead of letter frequencies */
+    NGRAM *model = NULL;
+    if (model_file) {
+        if (!(model = ngram_load(model_file, NGRAM_MAX_ORDER))) {
+            ERROR("Could not load n-gram model %s!", model_file);
+        }
+        set_xor_model(model);
+    }
 
     /*---------- Break the code! ----------*/
     XOR_NODE *out = break_repeating_xor(byte, nbyte, -1);
@@ -59,10 +68,9 @@ int main(int argc, char **argv)
     printall(out->plaintext, nbyte); /* works even for non-printables */
 
     /* clean-up */
-    free(b64);
-    free(b64_clean);
     free(byte);
     free(out);
+    ngram_free(model);
 
     return 0;
 }
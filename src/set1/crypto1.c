@@ -15,11 +15,6 @@
 #include "crypto_util.h"
 #include "header.h"
 
-/* Globals */
-/* Used in hex2b64_str() and b642hex_str(): */
-static const char B64_LUT[] =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
-
 /*------------------------------------------------------------------------------
  *          Challenge 1: Convert hexadecimal string to base64 string
  *----------------------------------------------------------------------------*/
@@ -49,75 +44,33 @@ char *b642hex(const char *b64)
  *----------------------------------------------------------------------------*/
 char *byte2b64(const BYTE *byte, size_t nbyte)
 {
-    int nbyte_out,
-        nchr_out,
-        b64_int;
-    BYTE this_byte;
-
     if (!byte) { return NULL; }
 
-    /* round nbyte up to multiple of 3 (need 3 bytes for even base64 output) */
-    nbyte_out = nbyte + 3 - (nbyte % 3);
-    nchr_out = nbyte_out * 4/3;  /* Number of chars in output */
-
     /* allocate memory for output */
-    char *b64_str = init_str(nchr_out);
-    char *p = b64_str; /* moveable pointer for concatenation */
-
-    /* Operate in chunks of 3 bytes in ==> 4 bytes out */
-    for (size_t i = 0; i < nbyte; i+=3) {
-        int j = 0;
-        this_byte = *(byte+i+j);
-
-        /* Add first character using first 6 bits of first byte */
-        b64_int = (this_byte & 0xFC) >> 2;
-        *p++ = B64_LUT[b64_int];
-
-        /* get last 2 bits of first byte */
-        b64_int = (this_byte & 0x03) << 4;
-
-        /* if we have more bytes to go */
-        if (i+j+1 < nbyte) {
-            j++;
-            this_byte = *(byte+i+j);
-
-            /* Add second character using first 4 bits of second byte and
-             * combine with 2 from above */
-            b64_int |= (this_byte & 0xF0) >> 4;
-            *p++ = B64_LUT[b64_int];
-
-            /* get last 4 bits of second byte */
-            b64_int = (this_byte & 0x0F) << 2;
-
-            /* if we have more bytes to go */
-            if (i+j+1 < nbyte) {
-                j++;
-                this_byte = *(byte+i+j);
-
-                /* Add third character */
-                /* get first 2 bits of third byte and combine with 4 from above */
-                b64_int |= (this_byte & 0xC0) >> 6;
-                *p++ = B64_LUT[b64_int];
-
-                /* Add fourth character using last 6 bits of third byte */
-                b64_int = (this_byte & 0x3F);
-                *p++ = B64_LUT[b64_int];
-
-            /* There are only 2 bytes of input, so interpret 3rd character with
-             * a "0x00" byte appended, and pad with an '=' character */
-            } else {
-                *p++ = B64_LUT[b64_int];
-                *p++ = '=';
-            }
+    char *b64_str = init_str(BYTE2B64_LEN(nbyte));
+    byte2b64_into(b64_str, byte, nbyte);
+    return b64_str;
+}
 
-        /* There is only 1 byte of input, so interpret 2nd character with two
-         * "0x00" bytes appended, and pad with two '=' characters */
-        } else {
-            *p++ = B64_LUT[b64_int];
-            strncat(b64_str, "==", 2);
-        }
-    }
+ssize_t byte2b64_into(char *b64, const BYTE *byte, size_t nbyte)
+{
+    /* 3 bytes in ==> 4 chars out, the last group padded with '=' */
+    STATS_START(t0);
+    size_t nchar = b64_encode(b64, byte, nbyte);
+    STATS_STOP(STAT_B64, t0, nbyte);
+    return nchar;
+}
 
+char *byte2b64_wrap(const BYTE *byte, size_t nbyte, size_t width)
+{
+    if (!byte) { return NULL; }
+
+    char *b64_str = init_str(B64_WRAP_LEN(nbyte, width));
+    STATS_START(t0);
+    if (b64_encode_wrap(b64_str, byte, nbyte, width) < 0) {
+        ERROR("Line width must be positive!");
+    }
+    STATS_STOP(STAT_B64, t0, nbyte);
     return b64_str;
 }
 
@@ -126,61 +79,35 @@ char *byte2b64(const BYTE *byte, size_t nbyte)
  *----------------------------------------------------------------------------*/
 size_t b642byte(BYTE **byte, const char *b64)
 {
-    size_t nchar,
-           nbyte;
-
     /* Input checking */
-    if (b64) {
-        nchar = strlen(b64);
-    } else {
-        return 0;
-    }
+    if (!b64) { return 0; }
+    size_t nchar = strlen(b64);
 
     /* Require padding by '=' signs */
     if (nchar % 4) {
         ERROR("Input string is not a valid b64 string! nchar = %zu\n", nchar);
-    } else {
-        /* 4 b64 chars * 6 bits/char == 24 bits / 8 bits/byte == 3 bytes */
-        /* check for "=" padding in b64 string -- will have 0, 1, or 2 */
-        char *s = strchr(b64, '=');
-        nbyte = nchar*3/4 - (s ? (nchar - (s - b64)) : 0);
     }
 
     /* Check that we actually have bytes to convert */
-    if (nbyte == 0) { return 0; }
+    if (nchar == 0) { return 0; }
 
     /* Initialize output */
-    *byte = init_byte(nbyte);
-    BYTE *p = *byte;
-
-    size_t n = 0;
-    /* Operate in chunks of 4 bytes in ==> 3 bytes out */
-    for (size_t i = 0; i < nchar; i+=4) {
-        /* Get 4 bytes of input */
-        int b64_int[4];
-
-        for (int j = 0; j < 4; j++) {
-            /* Lookup table of b64 indices */
-            int b = (int)indexof(B64_LUT, b64[i+j]);
-
-            if (0 <= b && b < 65) {
-                b64_int[j] = b;
-            } else {
-                ERROR("Input string is not a valid b64 string! got index %d\n", b);
-            }
-        }
-
-        /* Assign bytes to array -- always */
-        *p++ = ((b64_int[0] << 2) & 0xFF) | (b64_int[1] >> 4); /* 1st byte */
-        n++;
-
-        if (n++ >= nbyte) { break; }
-        *p++ = ((b64_int[1] << 4) & 0xFF) | (b64_int[2] >> 2); /* 2nd byte */
+    BYTE *out = init_byte(B642BYTE_LEN(nchar));
+    ssize_t nbyte = b642byte_into(out, b64, nchar);
+    if (nbyte < 0) { ERROR("Input string is not a valid b64 string!\n"); }
+    if (nbyte == 0) { free(out); return 0; }
 
-        if (n++ >= nbyte) { break; }
-        *p++ = ((b64_int[2] << 6) & 0xFF) |  b64_int[3];       /* 3rd byte */
-    }
+    *byte = out;
+    return nbyte;
+}
 
+ssize_t b642byte_into(BYTE *byte, const char *b64, size_t nchar)
+{
+    /* 4 b64 chars * 6 bits/char == 24 bits / 8 bits/byte == 3 bytes, less
+     * 0, 1, or 2 for "=" padding */
+    STATS_START(t0);
+    ssize_t nbyte = b64_decode(byte, b64, nchar);
+    if (nbyte >= 0) { STATS_STOP(STAT_B64, t0, nbyte); }
     return nbyte;
 }
 
@@ -190,18 +117,30 @@ size_t b642byte(BYTE **byte, const char *b64)
 BYTE *fixed_xor(const BYTE *a, const BYTE *b, size_t nbyte)
 {
     BYTE *xor = init_byte(nbyte);
-    /* XOR each byte in the input array */
-    for (int i = 0; i < nbyte; i++) {
-       *(xor+i) = *(a+i) ^ *(b+i);
-    }
+    fixed_xor_into(xor, a, b, nbyte);
     return xor;
 }
 
+ssize_t fixed_xor_into(BYTE *xor, const BYTE *a, const BYTE *b, size_t nbyte)
+{
+    STATS_START(t0);
+    xor_buf(xor, a, b, nbyte);
+    STATS_STOP(STAT_XOR, t0, nbyte);
+    return nbyte;
+}
+
 /*------------------------------------------------------------------------------
  *         Get character frequency score of string
  *----------------------------------------------------------------------------*/
-/* TODO include spaces and punctuation! 1st and ~4th in order */
 float char_freq_score(const BYTE *byte, size_t nbyte)
+{
+    size_t hist[NUM_BYTES];
+    count_bytes(hist, byte, nbyte);
+    return char_freq_score_hist(hist, 0, nbyte);
+}
+
+/* TODO include spaces and punctuation! 1st and ~4th in order */
+float char_freq_score_hist(const size_t *hist, BYTE key, size_t nbyte)
 {
     /* <https://en.wikipedia.org/wiki/Letter_frequency> */
     /* Indexed [A-Z] - 'A' == 0 -- 25 */
@@ -232,8 +171,13 @@ float char_freq_score(const BYTE *byte, size_t nbyte)
           chi_sq = 0.0;
     const float TOL = 1e-16;
 
-    /* Count frequency of each letter in string */
-    int *cf = count_chars(byte, nbyte);
+    /* Count frequency of each letter in the plaintext: byte c of the
+     * plaintext is byte c ^ key of the input */
+    size_t cf[NUM_LETTERS];
+    for (int j = 0; j < NUM_LETTERS - 1; j++) {
+        cf[j] = hist[('A' + j) ^ key] + hist[('a' + j) ^ key];
+    }
+    cf[NUM_LETTERS - 1] = hist[' ' ^ key];
 
     /* Calculate score via chi-squared test */
     N = (float)nbyte; /* all chars in array */
@@ -245,7 +189,6 @@ float char_freq_score(const BYTE *byte, size_t nbyte)
 
     /* Fraction of string that is just letters and spaces */
     if ((letter_frac = Nl/N) < TOL) {  /* no letters present */
-        free(cf);
         return score; 
     }
 
@@ -271,72 +214,131 @@ float char_freq_score(const BYTE *byte, size_t nbyte)
     /* Weight strings with more letter in them (vs non-letter chars) */
     score = chi_sq / (letter_frac*letter_frac);
 
-    free(cf);
     return score;
 }
 
 /*------------------------------------------------------------------------------
  *         Allocate memory and initialize an XOR_NODE
  *----------------------------------------------------------------------------*/
-XOR_NODE *init_xor_node(void)
-{
-    XOR_NODE *out = NULL;
+/* Bytes of a node with its key and plaintext, each with a NUL */
+#define XOR_NODE_SIZE(key_len, nbyte) \
+    (sizeof(XOR_NODE) + (key_len) + 1 + (nbyte) + 1)
 
-    /* Allocate memory for the output */
-    out = NEW(XOR_NODE);
-    MALLOC_CHECK(out);
-    BZERO(out, sizeof(XOR_NODE));
+/* Lay out zeroed memory of XOR_NODE_SIZE bytes as a node */
+static XOR_NODE *xor_node_at(void *mem, size_t key_len, size_t nbyte)
+{
+    XOR_NODE *out = mem;
 
     /* Initialize fields */
-    BZERO(out->key, sizeof(out->key));
-    BZERO(out->plaintext, sizeof(out->plaintext));
+    out->key       = (BYTE *)(out + 1);
+    out->plaintext = out->key + key_len + 1;
     out->key_byte  = 0;
+    out->nbyte     = nbyte;
     out->score     = FLT_MAX; /* initialize to large number */
     out->file_line = 0;
 
     return out;
 }
 
+XOR_NODE *init_xor_node(size_t key_len, size_t nbyte)
+{
+    void *mem = calloc(1, XOR_NODE_SIZE(key_len, nbyte));
+    MALLOC_CHECK(mem);
+    return xor_node_at(mem, key_len, nbyte);
+}
+
+XOR_NODE *arena_xor_node(ARENA *a, size_t key_len, size_t nbyte)
+{
+    size_t size = XOR_NODE_SIZE(key_len, nbyte);
+    void *mem = arena_alloc(a, size);
+    BZERO(mem, size);
+    return xor_node_at(mem, key_len, nbyte);
+}
+
 /*------------------------------------------------------------------------------
  *         Challenge 3: Decode a string XOR'd against a single character
  *----------------------------------------------------------------------------*/
 XOR_NODE *single_byte_xor_decode(const BYTE *byte, size_t nbyte)
 {
-    XOR_NODE *out = init_xor_node();
-    float cfreq_score = FLT_MAX; /* initialize large value */
+    XOR_NODE *out = init_xor_node(1, nbyte);
+    single_byte_xor_decode_into(out, byte, nbyte);
+    return out;
+}
+
+int single_byte_xor_decode_into(XOR_NODE *out, const BYTE *byte,
+        size_t nbyte)
+{
+    TOPK top;
+    topk_init(&top, 1);
+    if (!single_byte_xor_rank(&top, byte, nbyte)) { return 0; }
+
+    /* include null-terminator in output for ease of use */
+    out->key[0]   = (BYTE)top.item[0].value;
+    out->key[1]   = '\0';
+    out->key_byte = 1;
+    out->score    = top.item[0].score;
+
+    /* Decode input with the winning key only */
+    repeating_key_xor_into(out->plaintext, byte, out->key, nbyte, 1);
+    out->plaintext[nbyte] = '\0';
+    out->nbyte = nbyte;
+    return 1;
+}
+
+/* Language model scoring candidate plaintexts, or NULL for chi-squared */
+static const NGRAM *xor_model = NULL;
+
+void set_xor_model(const NGRAM *model)
+{
+    xor_model = model;
+}
+
+/* Rank keys with model, or chi-squared if it is NULL */
+static size_t rank_single_byte(TOPK *top, const BYTE *byte, size_t nbyte,
+        const NGRAM *model)
+{
+    /* XOR with a key only permutes the byte histogram, so count the input
+     * once and score every key from its permuted counts */
+    size_t hist[NUM_BYTES];
+    BYTE seen[NUM_BYTES];       /* distinct bytes of the input */
+    int printable[NUM_BYTES];
+    size_t n_seen = 0;
+
+    count_bytes(hist, byte, nbyte);
+    for (int b = 0; b < NUM_BYTES; b++) {
+        if (hist[b]) { seen[n_seen++] = (BYTE)b; }
+        /* No NULL chars, and printable */
+        printable[b] = b && ispchar((char)b);
+    }
 
     /* test each possible character byte */
     for (int keyi = 0x01; keyi < 0x100; keyi++) {
         BYTE key = (BYTE)keyi;  /* cast to char (char always < 0x100) */
 
-        /* Decode input with single-byte key */
-        BYTE *ptext = repeating_key_xor(byte, &key, nbyte, 1);
+        /* Every byte of the plaintext must be printable */
+        size_t i = 0;
+        while (i < n_seen && printable[seen[i] ^ key]) { i++; }
+        if (i < n_seen) { continue; }
 
-        /* Make sure string does not contain NULL chars, and is printable */
-        /* strlen(ptext) could break. BYTE not guaranteed null-terminated */
-        if (isprintable(ptext, nbyte)) {
-            /* calculate string score */
-            cfreq_score = char_freq_score(ptext, nbyte);
+        /* calculate string score */
+        float cfreq_score = model ? ngram_score_xor(model, byte, nbyte, key)
+                                  : char_freq_score_hist(hist, key, nbyte);
 
 #ifdef VERBOSE
-            printf("%.2X\t%s\t%10.4e\n", key, ptext, cfreq_score);
+        printf("%.2X\t%10.4e\n", key, cfreq_score);
 #endif
-            /* Track minimum chi-squared score and actual key */
-            if (cfreq_score < out->score) {
-                out->score = cfreq_score;
-                /* include null-terminator in output for ease of use */
-                BZERO(out->key, 2);
-                memcpy(out->key, &key, 1);
-                BZERO(out->plaintext, nbyte+1);
-                memcpy(out->plaintext, ptext, nbyte);
-                out->key_byte = 1;
-            }
+        /* No letters at all scores FLT_MAX, which never wins */
+        if (cfreq_score < FLT_MAX) {
+            topk_push(top, cfreq_score, key);
         }
-
-        free(ptext);
     }
 
-    return out;
+    return topk_sort(top);
+}
+
+size_t single_byte_xor_rank(TOPK *top, const BYTE *byte, size_t nbyte)
+{
+    return rank_single_byte(top, byte, nbyte, xor_model);
 }
 
 /*------------------------------------------------------------------------------
@@ -344,22 +346,27 @@ XOR_NODE *single_byte_xor_decode(const BYTE *byte, size_t nbyte)
  *----------------------------------------------------------------------------*/
 BYTE *repeating_key_xor(const BYTE *byte, const BYTE *key_byte, size_t nbyte, size_t key_len)
 {
-    /* XOR each byte in the ciphertext with the key */
-    BYTE *key_arr = bytenrepeat(key_byte, key_len, nbyte);
-    BYTE *xor = fixed_xor(byte, key_arr, nbyte);
-    free(key_arr);
+    BYTE *xor = init_byte(nbyte);
+    repeating_key_xor_into(xor, byte, key_byte, nbyte, key_len);
     return xor;
 }
 
+ssize_t repeating_key_xor_into(BYTE *xor, const BYTE *byte,
+        const BYTE *key_byte, size_t nbyte, size_t key_len)
+{
+    STATS_START(t0);
+    /* The repeated key is never built */
+    xor_repeat(xor, byte, nbyte, key_byte, key_len, 0);
+    STATS_STOP(STAT_XOR, t0, nbyte);
+    return nbyte;
+}
+
 /*------------------------------------------------------------------------------
  *         Compute Hamming distance between strings
  *----------------------------------------------------------------------------*/
 size_t hamming_dist(const BYTE *a, const BYTE *b, size_t nbyte)
 {
-    BYTE *xor = fixed_xor(a, b, nbyte); /* XOR returns differing bits */
-    size_t weight = hamming_weight(xor, nbyte);
-    free(xor);
-    return weight;
+    return hamming_xor(a, b, nbyte);    /* popcount of a ^ b */
 }
 
 /*------------------------------------------------------------------------------
@@ -399,59 +406,105 @@ float norm_mean_hamming(const BYTE *byte, size_t nbyte, size_t k)
  *         Get most probable key length of repeating XOR 
  *----------------------------------------------------------------------------*/
 size_t get_key_length(const BYTE *byte, size_t nbyte)
+{
+    TOPK top;
+    topk_init(&top, 1);
+    return get_key_lengths(&top, byte, nbyte) ? top.item[0].value : 0;
+}
+
+size_t get_key_lengths(TOPK *top, const BYTE *byte, size_t nbyte)
+{
+    return rank_key_lengths(top, byte, nbyte, XOR_MAX_KEY_LEN);
+}
+
+size_t rank_key_lengths(TOPK *top, const BYTE *byte, size_t nbyte,
+        size_t max_len)
 {
     size_t min_samples = 10;  /* ensure high accuracy */
-    size_t key_byte = 0;
-    float min_mean_dist = FLT_MAX;
 
-    /* key length in bytes */
-    size_t max_key_len = (size_t)MIN(40.0, (float)nbyte/min_samples);
+    if (max_len > HAMMING_MAX_SHIFT) {
+        ERROR("Key length %zu over %d!", max_len, HAMMING_MAX_SHIFT);
+    }
+    max_len = MIN(max_len, nbyte / min_samples);
+
+    /* Bytes a whole key length apart were XOR-ed with the same key byte, so
+     * they are equal as often as plaintext bytes are: far more often than
+     * bytes under different key bytes. One pass counts every shift. */
+    uint64_t same[HAMMING_MAX_SHIFT + 1];
+    coincidence_autocorr(same, byte, nbyte, max_len);
+
+    uint64_t all_same = 0,
+             all_pairs = 0;
+    for (size_t s = 1; s <= max_len; s++) {
+        all_same += same[s];
+        all_pairs += nbyte - s;
+    }
 
 #ifdef VERBOSE
-    printf("%3s\t%8s\t%8s\n", "Key", "Mean", "Norm");
+    printf("%3s\t%8s\t%8s\n", "Key", "Score", "Rank");
 #endif
-    for (size_t k = 3; k <= max_key_len; k++) {
-        /* Get mean Hamming distance of all samples */
-        float norm_mean = norm_mean_hamming(byte, nbyte, k);
-
-        /* Take key with minimum mean Hamming distance. */
-        if (norm_mean < min_mean_dist) {
-            min_mean_dist = norm_mean;
-            key_byte = k;
+    float score[HAMMING_MAX_SHIFT + 1];
+    for (size_t k = XOR_MIN_KEY_LEN; k <= max_len; k++) {
+        /* Pool the shifts by multiples of k. A multiple of the key length
+         * pools shifts of the right kind too, but leaves some among the
+         * others, so score by how far the two pools differ. */
+        uint64_t on_same = 0,
+                 on_pairs = 0;
+        for (size_t s = k; s <= max_len; s += k) {
+            on_same += same[s];
+            on_pairs += nbyte - s;
+        }
+        score[k] = (float)(all_same - on_same) / (all_pairs - on_pairs)
+                 - (float)on_same / on_pairs;
+
+        /* The right length scores at least as well as its multiples, and
+         * a divisor m times too short only about 1/m as well. A multiple
+         * of a length explaining most of its score ranks behind it. */
+        float rank = score[k];
+        for (size_t d = XOR_MIN_KEY_LEN; d <= k / 2; d++) {
+            if (k % d == 0 && score[d] <= XOR_DIVISOR_RATIO * score[k]) {
+                rank = fmaxf(rank, score[d]);
+            }
         }
-    }
-
 #ifdef VERBOSE
-    printf("key_byte  = %zu\n",   key_byte);
-    printf("min_dist  = %6.4f\n", min_mean_dist);
+        printf("%3zu\t%8.4f\t%8.4f\n", k, score[k], rank);
 #endif
+        topk_push(top, rank, k);
+    }
 
-    return key_byte;
+    return topk_sort(top);
 }
 
 /*------------------------------------------------------------------------------
  *         Challenge 6: Break repeating key XOR cipher
  *----------------------------------------------------------------------------*/
-XOR_NODE *break_repeating_xor(const BYTE *byte, const size_t nbyte, 
-                              int key_byte)
+/* Decode with a key of key_byte bytes, scoring the whole plaintext. Returns
+ * the number of columns no key byte decodes to printable text; if any, the
+ * key is incomplete and the score is FLT_MAX. */
+static size_t break_key_length(XOR_NODE *out, const BYTE *byte, size_t nbyte,
+        size_t key_byte)
 {
-    if (key_byte < 0) {
-        /* Get most probable key length */
-        /* TODO return sorted list of possible key sizes */
-        key_byte = get_key_length(byte, nbyte);
-    }
-
     /* Maximum number of bytes in each substring 
      * (may run out of chars on repeated key application) */
     size_t nbyte_t = (nbyte + (key_byte - (nbyte % key_byte))) / key_byte;
 
-    XOR_NODE *out = init_xor_node();
+    /* Every column reuses the same buffer */
+    BYTE *byte_t = init_byte(nbyte_t);
+
+    /* Neighbours in a column are key_byte bytes apart in the plaintext, so
+     * only the single byte frequencies of a model apply */
+    NGRAM col_model;
+    const NGRAM *model = NULL;
+    if (xor_model) {
+        col_model = *xor_model;
+        col_model.order = 1;
+        model = &col_model;
+    }
 
     /* For each byte of the key, transpose input and decode */
+    size_t n_failed = 0;
     for (size_t k = 0; k < key_byte; k++) {
-        /* TODO refactor this block into a function */
         /* Transpose input into every kth chunk */
-        BYTE *byte_t = init_byte(nbyte_t);
         size_t count_byte = 0, ind = 0;
         for (size_t i = 0; i < nbyte_t; i++) {
             /* Make sure we're not at end of input */
@@ -467,27 +520,117 @@ XOR_NODE *break_repeating_xor(const BYTE *byte, const size_t nbyte,
 #ifdef VERBOSE
         printf("---------- k = %zu\n", k);
 #endif
-        /* Run single byte xor on each chunk */
-        XOR_NODE *temp = single_byte_xor_decode(byte_t, count_byte);
-        *(out->key+k) = *(temp->key);
-
-        free(temp);
-        free(byte_t);
+        /* Run single byte xor on each chunk; only the key is needed */
+        TOPK top;
+        topk_init(&top, 1);
+        if (rank_single_byte(&top, byte_t, count_byte, model)) {
+            out->key[k] = (BYTE)top.item[0].value;
+        } else {
+            out->key[k] = 0;
+            n_failed++;
+        }
     }
 
-    if (*out->key) {
-        /* XOR original string with found key! */
-        BYTE *ptext = repeating_key_xor(byte, out->key, nbyte, key_byte);
-        memcpy(out->plaintext, ptext, nbyte);
-        out->key_byte = key_byte;
-        free(ptext);
+    free(byte_t);
+
+    /* XOR original string with found key! */
+    out->key_byte = key_byte;
+    out->nbyte = nbyte;
+    repeating_key_xor_into(out->plaintext, byte, out->key, nbyte, key_byte);
+    if (n_failed) {
+        out->score = FLT_MAX;
+    } else if (xor_model) {
+        out->score = ngram_score(xor_model, out->plaintext, nbyte);
     } else {
-        ERROR("Key not found!");
+        out->score = char_freq_score(out->plaintext, nbyte);
+    }
+    return n_failed;
+}
+
+/* Arguments shared by every key length worker */
+typedef struct _XOR_JOB {
+    const BYTE *byte;
+    size_t nbyte;
+    const TOPK *lens;       /* key lengths to try, best first */
+    XOR_NODE **node;        /* one result per key length */
+    size_t *n_failed;       /* columns of each left without a key byte */
+} XOR_JOB;
+
+static void break_key_range(size_t start, size_t end, void *arg)
+{
+    XOR_JOB *job = (XOR_JOB *)arg;
+    for (size_t i = start; i < end; i++) {
+        size_t key_byte = job->lens->item[i].value;
+        job->node[i] = init_xor_node(key_byte, job->nbyte);
+        job->n_failed[i] = break_key_length(job->node[i], job->byte,
+                job->nbyte, key_byte);
+    }
+}
+
+XOR_NODE *break_repeating_xor(const BYTE *byte, const size_t nbyte, 
+                              int key_byte)
+{
+    if (key_byte < 0) {
+        return break_repeating_xor_top(byte, nbyte, XOR_TOP_K);
     }
 
+    XOR_NODE *out = init_xor_node(key_byte, nbyte);
+    if (break_key_length(out, byte, nbyte, key_byte)) {
+        ERROR("Key not found!");
+    }
     return out;
 }
 
+XOR_NODE *break_repeating_xor_top(const BYTE *byte, size_t nbyte,
+        size_t n_len)
+{
+    size_t min_column = 80;   /* bytes per column to compete on score */
+
+    /* Most probable key lengths */
+    TOPK lens;
+    topk_init(&lens, n_len);
+    if (!get_key_lengths(&lens, byte, nbyte)) {
+        ERROR("Input too short to find the key length!");
+    }
+
+    /* Past the likeliest, only lengths leaving enough bytes per column can
+     * compete on score: a longer key fits short columns better whether or
+     * not it is right */
+    size_t n = 1;
+    for (size_t i = 1; i < lens.n; i++) {
+        if (nbyte / lens.item[i].value >= min_column) {
+            lens.item[n++] = lens.item[i];
+        }
+    }
+    lens.n = n;
+
+    /* Break each candidate length at once */
+    XOR_NODE *node[TOPK_MAX];
+    size_t n_failed[TOPK_MAX];
+    XOR_JOB job = { byte, nbyte, &lens, node, n_failed };
+    parallel_for(lens.n, 1, util_nthreads(), break_key_range, &job);
+
+    /* Keep the plaintext that reads most like English, from the lengths
+     * with a key byte for every column. A multiple of the key length decodes
+     * the same text, so ties go to the shorter key. */
+    size_t best = 0;
+    for (size_t i = 1; i < lens.n; i++) {
+        if (n_failed[i]) { continue; }
+        if (n_failed[best]
+                || node[i]->score < node[best]->score
+                || (node[i]->score == node[best]->score
+                    && node[i]->key_byte < node[best]->key_byte)) {
+            best = i;
+        }
+    }
+    for (size_t i = 0; i < lens.n; i++) {
+        if (i != best) { free(node[i]); }
+    }
+
+    if (n_failed[best]) { ERROR("Key not found!"); }
+    return node[best];
+}
+
 /*------------------------------------------------------------------------------
  *         Look for blocks with 0 Hamming distance
  *----------------------------------------------------------------------------*/
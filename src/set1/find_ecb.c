@@ -43,6 +43,7 @@ int find_AES_ECB(BYTE **out, const char *hex_filename)
     int file_line = -1;
     FILE *fp = NULL;
     char buffer[MAX_WORD_LEN];
+    BYTE byte[HEX2BYTE_LEN(MAX_WORD_LEN)];
     char message[2*MAX_LINE_LEN];
     BZERO(buffer, MAX_WORD_LEN);
     BZERO(message, 2*MAX_LINE_LEN);
@@ -58,11 +59,11 @@ int find_AES_ECB(BYTE **out, const char *hex_filename)
     /* float min_mean_dist = FLT_MAX; */
 
     while ( fgets(buffer, sizeof(buffer), fp) ) {
-        buffer[strcspn(buffer, "\n")] = '\0';  /* remove trailing '\n' */
+        size_t nchar = strcspn(buffer, "\n");   /* drop trailing '\n' */
 
         /* Convert to byte array */
-        BYTE *byte = NULL;
-        size_t nbyte = hex2byte(&byte, buffer);
+        ssize_t nbyte = hex2byte_into(byte, buffer, nchar);
+        if (nbyte < 0) { ERROR("Line %d is not valid hex!", fl); }
 
         /* initialize output only for first line */
         if (fl == 1) { *out = init_byte(nbyte); }
@@ -85,7 +86,6 @@ int find_AES_ECB(BYTE **out, const char *hex_filename)
 /*             file_line = fl; */
 /*         } */
 
-        free(byte);
         fl++;
     }
 
@@ -46,15 +46,17 @@ int main(int argc, char **argv)
  *----------------------------------------------------------------------------*/
 XOR_NODE *find_single_byte_xor(const char *filename)
 {
-    XOR_NODE *out = NULL;
+    XOR_NODE *best = NULL;
     FILE *fp = NULL;
     char buffer[MAX_WORD_LEN];
+    BYTE byte[HEX2BYTE_LEN(MAX_WORD_LEN)];
     char message[2*MAX_LINE_LEN];
     BZERO(buffer, MAX_WORD_LEN);
     BZERO(message, 2*MAX_LINE_LEN);
 
-    /* initialize output */
-    out = init_xor_node();
+    /* Each line's result is a view into the arena, kept only while it is
+     * the best so far */
+    ARENA *arena = init_arena(MAX_WORD_LEN, 0);
 
     /* open file stream */
     fp = fopen(filename, "r");
@@ -66,33 +68,30 @@ XOR_NODE *find_single_byte_xor(const char *filename)
 
     /* For each line, run single_byte_xor_decode, return {key, string, score} */
     while ( fgets(buffer, sizeof(buffer), fp) ) {
-        /* Buffer is hex, so OK to treat as string */
-        buffer[strcspn(buffer, "\n")] = '\0';  /* remove trailing '\n' */
-        BYTE *byte = NULL;
-        size_t nbyte = hex2byte(&byte, buffer);
+        /* Decode up to the trailing '\n' */
+        size_t nchar = strcspn(buffer, "\n");
+        ssize_t nbyte = hex2byte_into(byte, buffer, nchar);
+        if (nbyte < 0) { ERROR("Line %d is not valid hex!", file_line); }
 
 #ifdef VERBOSE
         printf("---------- Line: %3d\n", file_line);
 #endif
 
         /* Find most likely key for this line */
-        XOR_NODE *temp = single_byte_xor_decode(byte, nbyte);
-        if (*temp->plaintext) {
-            /* Track {key, string, score} by lowest score */
-            if (temp->score < out->score) {
-                BZERO(out->key, sizeof(out->key));
-                memcpy(out->key, temp->key, strlen((char *)temp->key));
-                BZERO(out->plaintext, sizeof(out->plaintext));
-                memcpy(out->plaintext, temp->plaintext, strlen((char *)temp->plaintext));
-                out->score = temp->score;
-                out->file_line = file_line;
-            }
+        ARENA_MARK mark = arena_push(arena);
+        XOR_NODE *temp = arena_xor_node(arena, 1, nbyte);
+        int found = single_byte_xor_decode_into(temp, byte, nbyte);
+
+        /* Track {key, string, score} by lowest score */
+        if (found && (!best || temp->score < best->score)) {
+            temp->file_line = file_line;
+            best = temp;
+        } else {
+            arena_pop(arena, mark); /* clean-up */
         }
 #ifdef VERBOSE
-        else { printf("\x1B[A\r"); /* move cursor up and overwrite */ }
+        if (!found) { printf("\x1B[A\r"); /* move cursor up and overwrite */ }
 #endif
-        free(byte);
-        free(temp); /* clean-up */
         file_line++;
     }
 
@@ -100,6 +99,18 @@ XOR_NODE *find_single_byte_xor(const char *filename)
     printf("\x1B[A\r\n\n"); /* erase last title line */
 #endif
     fclose(fp);
+
+    /* Copy the winner out of the arena */
+    XOR_NODE *out = init_xor_node(1, best ? best->nbyte : 0);
+    if (best) {
+        memcpy(out->key, best->key, best->key_byte);
+        memcpy(out->plaintext, best->plaintext, best->nbyte);
+        out->key_byte  = best->key_byte;
+        out->score     = best->score;
+        out->file_line = best->file_line;
+    }
+
+    free_arena(arena);
     return out;
 }
 
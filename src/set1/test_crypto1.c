@@ -155,6 +155,83 @@ int B64Convert2()
     END_TEST_CASE;
 }
 
+/* Caller-buffer base64 codecs match the allocating ones at every padding */
+int B64Into1()
+{
+    START_TEST_CASE;
+    BYTE x[40], y[B642BYTE_LEN(BYTE2B64_LEN(40))];
+    char b64[BYTE2B64_LEN(40)];
+    for (size_t i = 0; i < sizeof(x); i++) { x[i] = 3*i + 1; }
+    for (size_t n = 0; n <= sizeof(x); n++) {
+        char *ref = byte2b64(x, n);
+        ssize_t nchar = byte2b64_into(b64, x, n);
+        SHOULD_BE(nchar == (ssize_t)strlen(ref));
+        SHOULD_BE(!strcmp(b64, ref));
+        SHOULD_BE(b642byte_into(y, b64, nchar) == (ssize_t)n);
+        SHOULD_BE(!memcmp(y, x, n));
+        free(ref);
+    }
+    /* bad characters and unpadded input are errors, not exits */
+    SHOULD_BE(b642byte_into(y, "TW*u", 4) == B64_ECHAR);
+    SHOULD_BE(b642byte_into(y, "TWFu", 3) == B64_ELEN);
+    END_TEST_CASE;
+}
+
+/* Incremental base64 decoding over line-wrapped input fed in random chunks
+ * matches decoding the whole string at once */
+int B64Stream1()
+{
+    START_TEST_CASE;
+    for (size_t t = 0; t < 50; t++) {
+        size_t nbyte = RAND_RANGE(0, 300);
+        BYTE *byte = rand_byte(nbyte);
+        char *b64 = byte2b64(byte, nbyte);
+        size_t nchar = strlen(b64);
+
+        /* Wrap at 60 columns like the data files */
+        char *wrapped = init_str(nchar + nchar/60 + 2);
+        size_t nw = 0;
+        for (size_t i = 0; i < nchar; i++) {
+            wrapped[nw++] = b64[i];
+            if (i % 60 == 59) { wrapped[nw++] = '\n'; }
+        }
+        wrapped[nw++] = '\n';
+
+        B64_STREAM s;
+        b64_stream_init(&s);
+        BYTE *out = init_byte(B64_STREAM_LEN(nw));
+        size_t nout = 0;
+        for (size_t i = 0; i < nw; ) {
+            size_t n = RAND_RANGE(1, 17);
+            n = MIN(n, nw - i);
+            ssize_t got = b64_stream_update(&s, out + nout, wrapped + i, n);
+            SHOULD_BE(got >= 0 && got <= B64_STREAM_LEN(n));
+            nout += got;
+            i += n;
+        }
+        SHOULD_BE(b64_stream_final(&s) == 0);
+        SHOULD_BE(nout == nbyte);
+        SHOULD_BE(!memcmp(out, byte, nbyte));
+
+        free(byte);
+        free(b64);
+        free(wrapped);
+        free(out);
+    }
+
+    /* Bad characters, data after padding, and a dangling partial quad */
+    B64_STREAM s;
+    BYTE out[B64_STREAM_LEN(8)];
+    b64_stream_init(&s);
+    SHOULD_BE(b64_stream_update(&s, out, "SGk*", 4) == B64_ECHAR);
+    b64_stream_init(&s);
+    SHOULD_BE(b64_stream_update(&s, out, "SGk=SGk=", 8) == B64_EPAD);
+    b64_stream_init(&s);
+    SHOULD_BE(b64_stream_update(&s, out, "SGkh\nSG", 7) == 3);
+    SHOULD_BE(b64_stream_final(&s) == B64_ELEN);
+    END_TEST_CASE;
+}
+
 /* Challenge 2: This tests the XOR of two hex-encoded strings, as well as printing their
  * ASCII conversions */
 int FixedXOR1()
@@ -236,6 +313,34 @@ int SingleByte1()
     END_TEST_CASE;
 }
 
+/* Scoring the permuted histogram is the same as decrypting and scoring */
+int SingleByte2()
+{
+    START_TEST_CASE;
+    BYTE str1[] = "Anything less than the best is a felony.";
+    size_t nbyte = strlen((char *)str1);
+    BYTE ctext[sizeof(str1)], ptext[sizeof(str1)];
+    size_t hist[NUM_BYTES];
+
+    BYTE key = 0x37;
+    repeating_key_xor_into(ctext, str1, &key, nbyte, 1);
+    count_bytes(hist, ctext, nbyte);
+
+    for (int k = 0; k < 0x100; k++) {
+        BYTE kb = (BYTE)k;
+        repeating_key_xor_into(ptext, ctext, &kb, nbyte, 1);
+        float expect = char_freq_score(ptext, nbyte),
+              test = char_freq_score_hist(hist, kb, nbyte);
+        SHOULD_BE(test == expect || (isnan(test) && isnan(expect)));
+    }
+
+    XOR_NODE *out = single_byte_xor_decode(ctext, nbyte);
+    SHOULD_BE(*out->key == key);
+    SHOULD_BE(!strcmp((char *)out->plaintext, (char *)str1));
+    free(out);
+    END_TEST_CASE;
+}
+
 /* Challenge 5: This function tests the implementation of repeating-key XOR */
 int RepeatingKeyXOR1()
 {
@@ -250,6 +355,9 @@ int RepeatingKeyXOR1()
     size_t nbyte = hex2byte(&expect, hexpect);
     BYTE *xor = repeating_key_xor(input, key, strlen((char *)input), strlen((char *)key));
     SHOULD_BE(!memcmp(xor, expect, nbyte));
+    /* in place, into the caller's buffer */
+    SHOULD_BE(repeating_key_xor_into(input, input, key, nbyte, 3) == nbyte);
+    SHOULD_BE(!memcmp(input, expect, nbyte));
 #ifdef LOGSTATUS
     char *hexor = byte2hex(xor, nbyte);
     printf("Got:    %s\nExpect: %s\n", hexor, hexpect);
@@ -289,7 +397,7 @@ int BreakRepeatingXOR1()
     XOR_NODE *out = break_repeating_xor(input_byte, nbyte, -1);
     SHOULD_BE(!memcmp(out->key, key, out->key_byte));
     SHOULD_BE(!memcmp(out->plaintext, expect, nbyte));
-    SHOULD_BE(out->score == FLT_MAX); /* unchanged */
+    SHOULD_BE(out->score == char_freq_score(out->plaintext, nbyte));
     SHOULD_BE(out->file_line == 0);   /* unchanged */
 #ifdef LOGSTATUS
     char *key_hex = byte2hex(out->key, out->key_byte);
@@ -302,6 +410,99 @@ int BreakRepeatingXOR1()
     END_TEST_CASE;
 }
 
+/* Ranked keys and key lengths, best first */
+int RankXOR1()
+{
+    START_TEST_CASE;
+    BYTE str1[] = "Anything less than the best is a felony.";
+    size_t nbyte = strlen((char *)str1);
+    BYTE ctext[sizeof(str1)];
+    BYTE key = 0x37;
+    repeating_key_xor_into(ctext, str1, &key, nbyte, 1);
+
+    TOPK top;
+    topk_init(&top, 5);
+    size_t n = single_byte_xor_rank(&top, ctext, nbyte);
+    SHOULD_BE(n == 5);
+    SHOULD_BE(top.item[0].value == key);
+    for (size_t i = 1; i < n; i++) {
+        SHOULD_BE(top.item[i-1].score <= top.item[i].score);
+    }
+
+    /* Challenge 6 data: the key is 29 bytes */
+    BYTE *byte = NULL;
+    ssize_t len = b64_file2byte(&byte, "../../data/6.txt");
+    SHOULD_BE(len > 0);
+    topk_init(&top, XOR_TOP_K);
+    n = get_key_lengths(&top, byte, len);
+    SHOULD_BE(n == XOR_TOP_K);
+    SHOULD_BE(top.item[0].value == get_key_length(byte, len));
+    int found = 0;
+    for (size_t i = 0; i < n; i++) { found |= (top.item[i].value == 29); }
+    SHOULD_BE(found);
+
+    XOR_NODE *out = break_repeating_xor_top(byte, len, XOR_TOP_K);
+    SHOULD_BE(out->key_byte == 29);
+    SHOULD_BE(!memcmp(out->key, "Terminator X: Bring the noise", 29));
+    free(out);
+    free(byte);
+
+    /* Lengths past XOR_MAX_KEY_LEN, with the multiples of the key among
+     * them ranked behind it */
+    char *text = NULL;
+    size_t n_text = file2str(&text, "../../data/play_that_funky_music.txt");
+    BYTE long_key[] = "Vanilla Ice is sellin' and you people are buyin'";
+    size_t key_len = strlen((char *)long_key);
+    BYTE *long_ctext = init_byte(n_text);
+    repeating_key_xor_into(long_ctext, (BYTE *)text, long_key, n_text,
+            key_len);
+    topk_init(&top, XOR_TOP_K);
+    SHOULD_BE(rank_key_lengths(&top, long_ctext, n_text, 200) == XOR_TOP_K);
+    SHOULD_BE(top.item[0].value == key_len);
+    free(text);
+    free(long_ctext);
+    END_TEST_CASE;
+}
+
+/* Results are sized to their input, past the old 16 KB limit */
+int XORNode1()
+{
+    START_TEST_CASE;
+    XOR_NODE *node = init_xor_node(3, 5);
+    SHOULD_BE(node->key_byte == 0);
+    SHOULD_BE(node->nbyte == 5);
+    SHOULD_BE(node->score == FLT_MAX);
+    SHOULD_BE(node->key[3] == '\0' && node->plaintext[5] == '\0');
+    SHOULD_BE(node->plaintext > node->key + 3);
+    free(node);
+
+    ARENA *arena = init_arena(64, 0);
+    node = arena_xor_node(arena, 1, 100);
+    SHOULD_BE(node->nbyte == 100 && node->plaintext[100] == '\0');
+    free_arena(arena);
+
+    /* Repeat the challenge 6 text out to 40000 bytes */
+    char *text = NULL;
+    size_t n_text = file2str(&text, "../../data/play_that_funky_music.txt");
+    size_t nbyte = 40000;
+    BYTE *ptext = init_byte(nbyte),
+         *ctext = init_byte(nbyte);
+    for (size_t i = 0; i < nbyte; i++) { ptext[i] = text[i % n_text]; }
+
+    BYTE key[] = "Terminator X: Bring the noise";
+    repeating_key_xor_into(ctext, ptext, key, nbyte, 29);
+    XOR_NODE *out = break_repeating_xor(ctext, nbyte, 29);
+    SHOULD_BE(out->nbyte == nbyte);
+    SHOULD_BE(!memcmp(out->key, key, 29));
+    SHOULD_BE(!memcmp(out->plaintext, ptext, nbyte));
+
+    free(out);
+    free(text);
+    free(ptext);
+    free(ctext);
+    END_TEST_CASE;
+}
+
 /* Test all AES en/decrypt cases */
 int AESDecrypt1()
 {
@@ -357,6 +558,79 @@ int AESDecrypt_test(BYTE *ptext)
     END_TEST_CASE;
 }
 
+/* Test AES in ECB mode in-place en/decryption matches allocating version */
+int AESInPlace1()
+{
+    START_TEST_CASE;
+    BYTE ptext[] = "I was a terror since the public school era.";
+    size_t ptext_len = strlen((char *)ptext);
+    BYTE key[] = "YELLOW SUBMARINE";
+    /* Encrypt with the allocating version */
+    BYTE *ctext = NULL;
+    size_t ctext_len = 0;
+    (void)aes_128_ecb_cipher(&ctext, &ctext_len, ptext, ptext_len, key, 1);
+    /* Encrypt in-place */
+    size_t buf_len = AES_ECB_LEN(ptext_len);
+    SHOULD_BE(buf_len == ctext_len);
+    BYTE buf[buf_len];
+    memcpy(buf, ptext, ptext_len);
+    SHOULD_BE(aes_128_ecb_cipher_into(buf, buf, ptext_len, key, 1) == buf_len);
+    SHOULD_BE(!memcmp(buf, ctext, ctext_len));
+    /* Decrypt in-place */
+    SHOULD_BE(aes_128_ecb_cipher_into(buf, buf, buf_len, key, 0) == ptext_len);
+    SHOULD_BE(!memcmp(buf, ptext, ptext_len));
+    free(ctext);
+    END_TEST_CASE;
+}
+
+/* Streaming ECB in random chunks matches the one-shot cipher both ways */
+int AESStream1()
+{
+    START_TEST_CASE;
+    BYTE key[] = "YELLOW SUBMARINE";
+    for (size_t t = 0; t < 50; t++) {
+        size_t x_len = RAND_RANGE(0, 200);
+        BYTE *x = rand_byte(x_len);
+        BYTE *y = init_byte(AES_ECB_LEN(x_len)),
+             *z = init_byte(AES_ECB_LEN(x_len));
+        ssize_t ref_len[2];
+        ref_len[1] = aes_128_ecb_cipher_into(y, x, x_len, key, 1);
+        ref_len[0] = aes_128_ecb_cipher_into(z, y, ref_len[1], key, 0);
+        BYTE *ref[2] = { z, y };
+
+        for (int enc = 1; enc >= 0; enc--) {
+            const BYTE *in = enc ? x : y;
+            size_t in_len = enc ? x_len : (size_t)ref_len[1],
+                   n_out = 0;
+            BYTE *out = init_byte(in_len + BLOCK_SIZE);
+            AES_STREAM *s = init_aes_stream(key, NULL, enc);
+            for (size_t i = 0; i < in_len; ) {
+                size_t n = RAND_RANGE(1, 40);
+                n = MIN(n, in_len - i);
+                n_out += aes_stream_update(s, out + n_out, in + i, n);
+                i += n;
+            }
+            ssize_t n_last = aes_stream_final(s, out + n_out);
+            if (ref_len[enc] >= 0) {
+                SHOULD_BE(n_last >= 0);
+                n_out += n_last;
+                SHOULD_BE(n_out == ref_len[enc]);
+                SHOULD_BE(!memcmp(out, ref[enc], n_out));
+            } else {
+                /* Random plaintext that doesn't end in valid padding */
+                SHOULD_BE(n_last == -1);
+            }
+            free_aes_stream(s);
+            free(out);
+        }
+
+        free(x);
+        free(y);
+        free(z);
+    }
+    END_TEST_CASE;
+}
+
 /* Test ECB mode detection */
 int ECBDetect1()
 {
@@ -379,13 +653,20 @@ int main(void)
     RUN_TEST(HexConvert4,       "              hex2b64() 3              ");
     RUN_TEST(B64Convert1,       "              b642hex() 1              ");
     RUN_TEST(B64Convert2,       "              b642hex() 2              ");
+    RUN_TEST(B64Into1,          "              b642byte_into()          ");
+    RUN_TEST(B64Stream1,        "              b64_stream_update()      ");
     RUN_TEST(FixedXOR1,         "Challenge  2: fixed_xor()              ");
     /* RUN_TEST(CharFreqScore1,    "Challenge  3: char_freq_score()        "); */
     RUN_TEST(SingleByte1,       "              single_byte_xor_decode() ");
+    RUN_TEST(SingleByte2,       "              char_freq_score_hist()   ");
     RUN_TEST(RepeatingKeyXOR1,  "Challenge  5: repeating_key_xor()      ");
     RUN_TEST(HammingDist1,      "Challenge  6: hamming_dist()           ");
     RUN_TEST(BreakRepeatingXOR1,"              break_repeating_xor()    ");
+    RUN_TEST(RankXOR1,          "              get_key_lengths()        ");
+    RUN_TEST(XORNode1,          "              init_xor_node()          ");
     RUN_TEST(AESDecrypt1,       "Challenge  7: aes_128_ecb_cipher()     ");
+    RUN_TEST(AESInPlace1,       "              aes_128_ecb_cipher_into()");
+    RUN_TEST(AESStream1,        "              aes_stream_update()      ");
     RUN_TEST(ECBDetect1,        "Challenge  8: find_AES_ECB() 1         ");
 
     /* Count errors */
@@ -3,7 +3,8 @@
  *  Created: 07/28/2017, 15:35
  *   Author: Bernie Roesler
  *
- *  Description: 
+ *  Description: Decrypt a base64 file encrypted in AES 128-bit CBC mode,
+ *      streaming it a chunk at a time in constant memory.
  *
  *============================================================================*/
 #include <stdio.h>
@@ -14,6 +15,19 @@
 #include "crypto1.h"
 #include "crypto2.h"
 
+/* Decrypt each chunk of decoded bytes and print it as it comes */
+typedef struct _SINK {
+    AES_STREAM *aes;
+    BYTE *out;              /* B64_EMIT_MAX + BLOCK_SIZE bytes */
+} SINK;
+
+static int cipher_chunk(void *arg, const BYTE *byte, size_t nbyte)
+{
+    SINK *sink = arg;
+    printall(sink->out, aes_stream_update(sink->aes, sink->out, byte, nbyte));
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     char *b64_file = NULL;
@@ -26,32 +40,32 @@ int main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
-    /* Read file into memory */
-    char *b64 = NULL;
-    (void)file2str(&b64, b64_file);
-    char *b64_clean = strrmchr(b64, "\n");  /* strip newlines */
-
-    /* Convert to byte array for decryption */
-    BYTE *byte = NULL;
-    size_t nbyte = b642byte(&byte, b64_clean);
+    FILE *fp = fopen(b64_file, "r");
+    if (!fp) { ERROR("File %s could not be read!", b64_file); }
 
     /* Define the key -- 16 byte == 128 bit key */
     BYTE key[] = "YELLOW SUBMARINE";
-    BYTE *plaintext = NULL;
-    size_t plaintext_len = 0;
     BYTE iv[BLOCK_SIZE] = "";   /* BLOCK_SIZE-length array of '\0' chars */
 
+    /* Constant memory: one chunk of bytes and their plaintext at a time */
+    BYTE *plaintext = init_byte(B64_EMIT_MAX + BLOCK_SIZE);
+    AES_STREAM *aes = init_aes_stream(key, iv, 0);
+    SINK sink = { aes, plaintext };
+
     /*---------- Break the code! ----------*/
-    aes_128_cbc_decrypt(&plaintext, &plaintext_len, byte, nbyte, key, iv);
+    if (b64_decode_file(fp, cipher_chunk, &sink) < 0) {
+        ERROR("Could not decode %s!", b64_file);
+    }
 
-    /* Write to stdout */
-    printall(plaintext, plaintext_len); /* works even for non-printables */
+    /* The last block carries the padding */
+    ssize_t n_last = aes_stream_final(aes, plaintext);
+    if (n_last < 0) { ERROR("Invalid padding!"); }
+    printall(plaintext, n_last);   /* works even for non-printables */
 
     /* Clean up */
-    free(b64);
-    free(b64_clean);
-    free(byte);
+    free_aes_stream(aes);
     free(plaintext);
+    fclose(fp);
     return 0;
 }
 
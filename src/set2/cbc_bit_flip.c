@@ -101,6 +101,7 @@ int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len)
                   n_append = 0;
 
     *y_len = 0;
+    STATS_START(t0);
 
     /* Escape ';' and '=' before encrypting */
     char *x_clean = strescchr((char *)x, ";=", 1);
@@ -140,6 +141,7 @@ int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len)
     free(xa);
     free(x_clean);
 
+    STATS_STOP(STAT_ORACLE, t0, x_len);
     return 0;
 }
 
@@ -148,6 +150,8 @@ int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len)
  *----------------------------------------------------------------------------*/
 int decrypt_and_checkadmin(BYTE *y, size_t y_len)
 {
+    STATS_COUNT(STAT_ORACLE, y_len);
+
     /* Decrypt ciphertext */
     BYTE *x = NULL;
     size_t x_len = 0;
@@ -16,49 +16,165 @@
  *----------------------------------------------------------------------------*/
 int aes_128_cbc_encrypt(BYTE **y, size_t *y_len, BYTE *x, size_t x_len, BYTE *key, BYTE *iv)
 {
-    size_t len = 0;     /* intermediate length */
-    BYTE *xp = NULL,    /* intermediate value of xor'd bytes */
-         *xi = NULL,    /* one block plaintext input */
-         *yi = NULL,    /* one block output of AES encryption */
-         *yim1 = NULL;  /* "previous" ciphertext block */
-    *y_len = 0;         /* output length */
+    /* initialize output byte array with one extra block */
+    *y = init_byte(AES_CBC_LEN(x_len) + BLOCK_SIZE);
+    *y_len = aes_128_cbc_encrypt_into(*y, x, x_len, key, iv);
+    return 0;
+}
 
-    /* Number of blocks needed */
-    size_t n_blocks = x_len / BLOCK_SIZE;
-    if (x_len % BLOCK_SIZE) { n_blocks++; }
-    size_t tot_len = BLOCK_SIZE * n_blocks;
+ssize_t aes_128_cbc_encrypt_into(BYTE *y, const BYTE *x, size_t x_len,
+        const BYTE *key, const BYTE *iv)
+{
+    BYTE xp[BLOCK_SIZE];    /* intermediate value of xor'd bytes */
+    const BYTE *yim1 = iv;  /* "previous" ciphertext block */
 
-    /* initialize output byte array with one extra block */
-    *y = init_byte(tot_len + BLOCK_SIZE);
+    /* Number of blocks needed, the last one padded */
+    size_t n_blocks = AES_CBC_LEN(x_len) / BLOCK_SIZE;
 
-    /* pad byte array to multiple of BLOCK_SIZE */
-    BYTE *x_pad = pkcs7_pad(x, x_len, BLOCK_SIZE);
+    /* Key schedule comes from the cache, else is expanded once here */
+    AES_CTX *ctx = aes_ctx_acquire(key, 1);
 
     /* Encrypt blocks of plaintext using Chain Block Cipher (CBC) mode */
     for (size_t i = 0; i < n_blocks; i++) {
-        /* Input blocks */
-        xi = x_pad + i*BLOCK_SIZE;
-        yim1 = (i == 0) ? iv : yi; /* chain the last ciphertext into the next */
+        BYTE *yi = y + i*BLOCK_SIZE;
+
+        /* pad the final block in place of a padded copy of the input */
+        size_t n = MIN(BLOCK_SIZE, x_len - i*BLOCK_SIZE);
+        memcpy(xp, x + i*BLOCK_SIZE, n);
+        memset(xp + n, BLOCK_SIZE - n, BLOCK_SIZE - n);
 
         /* XOR plaintext block with previous ciphertext block */
-        xp = fixed_xor(xi, yim1, BLOCK_SIZE);
-        free(yi); /* a new yi is malloc'd during ECB, so free the old one */
+        for (size_t j = 0; j < BLOCK_SIZE; j++) { xp[j] ^= yim1[j]; }
 
-        /* Encrypt single block using key and AES cipher */
-        if (0 != aes_128_ecb_block(&yi, &len, xp, BLOCK_SIZE, key, 1)) {
+        /* Encrypt single block straight into the output array */
+        if (0 != aes_128_encrypt_block(ctx, yi, xp)) {
             ERROR("Encryption failed!");
         }
+        yim1 = yi;      /* chain the last ciphertext */
+    }
+
+    aes_ctx_release(ctx);
+    return n_blocks * BLOCK_SIZE;
+}
+
+/*------------------------------------------------------------------------------
+ *         Encrypt many independent messages in CBC mode, in lockstep
+ *----------------------------------------------------------------------------*/
+/* Blocks in message m, padded the same way as aes_128_cbc_encrypt */
+#define CBC_BLOCKS(m) (((m)->x_len + BLOCK_SIZE - 1) / BLOCK_SIZE)
+
+/* Advance one group of messages in lockstep; contexts and outputs are set */
+static void cbc_encrypt_group(CBC_MSG *msg, AES_CTX **ctx, size_t n_msg,
+        size_t *active, AES_CTX **step_ctx, BYTE *in, BYTE *out)
+{
+    size_t n_active = n_msg;
+
+    for (size_t j = 0; j < n_msg; j++) { active[j] = j; }
+
+    for (size_t i = 0; ; i++) {
+        /* Drop messages that have run out of blocks */
+        size_t n_keep = 0;
+        for (size_t k = 0; k < n_active; k++) {
+            if (CBC_BLOCKS(&msg[active[k]]) > i) { active[n_keep++] = active[k]; }
+        }
+        if (!(n_active = n_keep)) { break; }
+
+        /* Block i of every running message, XOR'd into its chain */
+        for (size_t k = 0; k < n_active; k++) {
+            CBC_MSG *m = &msg[active[k]];
+            BYTE *xp = in + k*BLOCK_SIZE;
+            const BYTE *prev = i ? m->y + (i-1)*BLOCK_SIZE : m->iv;
+            size_t off = i*BLOCK_SIZE,
+                   n = MIN(BLOCK_SIZE, m->x_len - off);
+
+            /* PKCS#7 pad the final partial block on the fly */
+            memcpy(xp, m->x + off, n);
+            memset(xp + n, BLOCK_SIZE - n, BLOCK_SIZE - n);
+            for (size_t b = 0; b < BLOCK_SIZE; b++) { xp[b] ^= prev[b]; }
+
+            step_ctx[k] = ctx[active[k]];
+        }
+
+        /* One call advances every chain by a block */
+        aes_128_encrypt_blocks_multi(step_ctx, out, in, n_active);
+
+        for (size_t k = 0; k < n_active; k++) {
+            memcpy(msg[active[k]].y + i*BLOCK_SIZE, out + k*BLOCK_SIZE,
+                    BLOCK_SIZE);
+        }
+    }
+}
 
-        /* Append encrypted text to output array */
-        memcpy(*y + *y_len, yi, len);
-        *y_len += len;
+/* Chain one message on its own; interleaving buys nothing when every message
+ * brings its own key schedule into cache */
+static void cbc_encrypt_one(CBC_MSG *m, AES_CTX *ctx)
+{
+    BYTE xp[BLOCK_SIZE];
+
+    for (size_t i = 0; i < CBC_BLOCKS(m); i++) {
+        const BYTE *prev = i ? m->y + (i-1)*BLOCK_SIZE : m->iv;
+        size_t off = i*BLOCK_SIZE,
+               n = MIN(BLOCK_SIZE, m->x_len - off);
 
-        free(xp);
+        memcpy(xp, m->x + off, n);
+        memset(xp + n, BLOCK_SIZE - n, BLOCK_SIZE - n);
+        for (size_t b = 0; b < BLOCK_SIZE; b++) { xp[b] ^= prev[b]; }
+
+        aes_128_encrypt_block(ctx, m->y + off, xp);
+    }
+}
+
+int aes_128_cbc_encrypt_batch(CBC_MSG *msg, size_t n_msg)
+{
+    if (!n_msg) { return 0; }
+
+    size_t *active = malloc(CBC_BATCH_GROUP*sizeof(size_t));
+    AES_CTX **ctx = malloc(CBC_BATCH_GROUP*sizeof(AES_CTX *)),
+            **step_ctx = malloc(CBC_BATCH_GROUP*sizeof(AES_CTX *));
+    BYTE *in  = init_byte(CBC_BATCH_GROUP*BLOCK_SIZE),
+         *out = init_byte(CBC_BATCH_GROUP*BLOCK_SIZE);
+    MALLOC_CHECK(active);
+    MALLOC_CHECK(ctx);
+    MALLOC_CHECK(step_ctx);
+
+    /* Groups small enough that their key schedules stay in cache across
+     * steps */
+    for (size_t g = 0; g < n_msg; g += CBC_BATCH_GROUP) {
+        CBC_MSG *grp = msg + g;
+        size_t n_grp = MIN(CBC_BATCH_GROUP, n_msg - g),
+               n_keys = 0;
+
+        /* Outputs, and one key schedule per distinct key among neighbours
+         * (the common case is one key for the whole batch) */
+        for (size_t j = 0; j < n_grp; j++) {
+            grp[j].y_len = BLOCK_SIZE * CBC_BLOCKS(&grp[j]);
+            grp[j].y = init_byte(grp[j].y_len + BLOCK_SIZE);
+            if (j && !memcmp(grp[j].key, grp[j-1].key, BLOCK_SIZE)) {
+                ctx[j] = ctx[j-1];
+            } else {
+                ctx[j] = aes_ctx_acquire(grp[j].key, 1);
+                n_keys++;
+            }
+        }
+
+        /* Lockstep only pays when messages share schedules */
+        if (2*n_keys > n_grp) {
+            for (size_t j = 0; j < n_grp; j++) { cbc_encrypt_one(&grp[j], ctx[j]); }
+        } else {
+            cbc_encrypt_group(grp, ctx, n_grp, active, step_ctx, in, out);
+        }
+
+        for (size_t j = 0; j < n_grp; j++) {
+            if (j + 1 == n_grp || ctx[j+1] != ctx[j]) { aes_ctx_release(ctx[j]); }
+        }
     }
 
     /* Clean-up */
-    free(yi);
-    free(x_pad);
+    free(active);
+    free(ctx);
+    free(step_ctx);
+    free(in);
+    free(out);
 
     return 0;
 }
@@ -66,55 +182,78 @@ int aes_128_cbc_encrypt(BYTE **y, size_t *y_len, BYTE *x, size_t x_len, BYTE *ke
 /*------------------------------------------------------------------------------
  *         Decrypt AES 128-bit cipher in CBC mode 
  *----------------------------------------------------------------------------*/
-int aes_128_cbc_decrypt(BYTE **x, size_t *x_len, BYTE *y, size_t y_len, BYTE *key, BYTE *iv)
+/* Arguments shared by every CBC decryption worker */
+typedef struct _CBC_JOB {
+    BYTE *x;                /* plaintext output */
+    const BYTE *y;          /* ciphertext input */
+    const BYTE *key;
+    const BYTE *iv;
+} CBC_JOB;
+
+/* Decrypt blocks [start, end) of the message. Each plaintext block depends
+ * only on two ciphertext blocks, so any range can be done independently. */
+static void cbc_decrypt_range(size_t start, size_t end, void *arg)
 {
-    size_t len = 0;     /* intermediate length */
-    BYTE *yp = NULL,    /* intermediate value of xor'd bytes */
-         *xi = NULL,    /* one block plaintext input */
-         *yi = NULL,    /* one block output of AES encryption */
-         *yim1 = NULL;  /* "previous" ciphertext block */
-    int n_pad = 0;
-
-    *x_len = 0;         /* output length */
-
-    /* Number of blocks needed */
-    size_t n_blocks = y_len / BLOCK_SIZE;
-    if (*x_len % BLOCK_SIZE) { n_blocks++; }
-
-    /* initialize output byte array with one extra block */
-    *x = init_byte(BLOCK_SIZE*(n_blocks+1));
+    CBC_JOB *job = (CBC_JOB *)arg;
+    AES_CTX *ctx = aes_ctx_acquire(job->key, 0);
 
-    /* Encrypt blocks of plaintext using Chain Block Cipher (CBC) mode */
-    for (size_t i = 0; i < n_blocks; i++) {
-        /* Input blocks */
-        yim1 = (i == 0) ? iv : yi;
-        yi = y + i*BLOCK_SIZE;
+    /* The first block is chained to the IV, the rest to the ciphertext */
+    if (start == 0) {
+        aes_128_decrypt_blocks_xor(ctx, job->x, job->y, job->iv, 1);
+        start++;
+    }
 
-        /* Decrypt single block using key and AES cipher */
-        if (0 != aes_128_ecb_block(&yp, &len, yi, BLOCK_SIZE, key, 0)) {
+    /* All remaining blocks through the interleaved AES pipeline at once */
+    if (end > start) {
+        if (0 != aes_128_decrypt_blocks_xor(ctx, job->x + start*BLOCK_SIZE,
+                    job->y + start*BLOCK_SIZE, job->y + (start-1)*BLOCK_SIZE,
+                    end - start)) {
             ERROR("Decryption failed!");
         }
+    }
 
-        /* XOR decrypted ciphertext block with previous ciphertext block */
-        xi = fixed_xor(yp, yim1, BLOCK_SIZE);
+    aes_ctx_release(ctx);
+}
 
-        /* Append decrypted text to output array */
-        memcpy(*x + *x_len, xi, len);
-        *x_len += len;
+void aes_128_cbc_decrypt_blocks(BYTE *x, const BYTE *y, size_t n_blocks,
+        const BYTE *key, const BYTE *iv, int n_threads)
+{
+    CBC_JOB job = { x, y, key, iv };
+    parallel_for(n_blocks, CBC_MIN_THREAD_BLOCKS, n_threads,
+            cbc_decrypt_range, &job);
+}
 
-        free(yp);
-        free(xi); /* could parallelize because x doesn't depend on xi */
-    }
+int aes_128_cbc_decrypt(BYTE **x, size_t *x_len, BYTE *y, size_t y_len, BYTE *key, BYTE *iv)
+{
+    /* initialize output byte array with one extra block */
+    *x = init_byte(y_len + BLOCK_SIZE);
+    *x_len = y_len - y_len % BLOCK_SIZE;
 
     /* Remove any padding from output, or error code if invalid */
-    if ((n_pad = pkcs7_rmpad(*x, *x_len, BLOCK_SIZE)) < 0) {
-        return -1;
-    }
+    ssize_t len = aes_128_cbc_decrypt_into(*x, y, y_len, key, iv);
+    if (len < 0) { return -1; }
 
-    *x_len -= n_pad;
+    int n_pad = *x_len - len;
+    *x_len = len;
     return n_pad;
 }
 
+ssize_t aes_128_cbc_decrypt_into(BYTE *x, const BYTE *y, size_t y_len,
+        const BYTE *key, const BYTE *iv)
+{
+    /* Number of blocks needed */
+    size_t n_blocks = y_len / BLOCK_SIZE;
+    size_t x_len = BLOCK_SIZE*n_blocks;
+    if (x_len == 0) { return 0; }
+
+    /* Decrypt every block straight into the output, in parallel */
+    aes_128_cbc_decrypt_blocks(x, y, n_blocks, key, iv, util_nthreads());
+
+    /* Remove any padding from output once at the end */
+    int n_pad = pkcs7_rmpad(x, x_len, BLOCK_SIZE);
+    return n_pad < 0 ? -1 : (ssize_t)(x_len - n_pad);
+}
+
 /*------------------------------------------------------------------------------
  *          Test if we're encrypting in ECB mode or not
  *----------------------------------------------------------------------------*/
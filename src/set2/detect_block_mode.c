@@ -51,6 +51,7 @@ int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len)
         heads;
 
     *y_len = 0;
+    STATS_START(t0);
 
     /* Randomly generate 5-10 bytes to pre-/append to input */
     n_prepend = RAND_RANGE(5,10);
@@ -113,6 +114,7 @@ int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len)
     free(key);
     free(x_aug);
 
+    STATS_STOP(STAT_ORACLE, t0, x_len);
     return 0;
 }
 
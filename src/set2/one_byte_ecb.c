@@ -17,6 +17,9 @@
 
 #define SRAND_INIT 56
 
+/* Chunk size of the arena for per-guess temporaries */
+#define ARENA_SIZE 1024
+
 /* Mode of operation (easy or hard) */
 static int mode = 0;
 
@@ -25,6 +28,9 @@ static BYTE *global_key = NULL;
 static BYTE *global_prepend = NULL;
 static BYTE *global_append = NULL;
 
+/* Scratch memory for the oracle and decodeNextByte, popped every call */
+static ARENA *global_arena = NULL;
+
 /* Take input of the form (your-string||unknown-string, random-key), and decrypt
  * the unknown string */
 int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len);
@@ -65,6 +71,8 @@ int main(int argc, char **argv)
     /* initialize PRNG */
     srand(SRAND_INIT);
 
+    global_arena = init_arena(ARENA_SIZE, ARENA_POISON);
+
     /* Detect block size */
     block_size = get_block_size(encryption_oracle, &count, &n);
     size_t n_prepend = n*block_size - unk_len - count;
@@ -87,6 +95,7 @@ int main(int argc, char **argv)
     free(global_key);
     free(global_append);
     if (mode) { free(global_prepend); }
+    free_arena(global_arena);
     return 0;
 }
 
@@ -101,6 +110,7 @@ int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len)
     BYTE *x_aug;
 
     *y_len = 0;
+    STATS_START(t0);
 
     /* Convert to byte array */
     if (!global_append) {
@@ -116,8 +126,9 @@ int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len)
     }
 
     /* Build actual input to oracle */
+    ARENA_MARK mark = arena_push(global_arena);
     x_aug_len = n_prepend + x_len + n_append;
-    x_aug = init_byte(x_aug_len);
+    x_aug = arena_byte(global_arena, x_aug_len);
 
     /* Move pointer along each chunk of bytes */
     memcpy(x_aug,                     global_prepend, n_prepend);
@@ -133,7 +144,8 @@ int encryption_oracle(BYTE **y, size_t *y_len, BYTE *x, size_t x_len)
     aes_128_ecb_cipher(y, y_len, x_aug, x_aug_len, global_key, 1);
 
     /* Clean-up */
-    free(x_aug);
+    arena_pop(global_arena, mark);
+    STATS_STOP(STAT_ORACLE, t0, x_len);
     return 0;
 }
 
@@ -159,7 +171,8 @@ BYTE decodeNextByte(int (*encrypt)(BYTE**, size_t*, BYTE*, size_t), const BYTE *
     x_len = block_size - (y_len     % block_size) - 1;
     in_len = x_len + p_len + y_len + 1;  /* == n*block_size */
 
-    in = init_byte(in_len);
+    ARENA_MARK mark = arena_push(global_arena);
+    in = arena_byte(global_arena, in_len);
     for (i = 0; i < (x_len + p_len); i++) { *(in+i) = 'A'; }
     memcpy(in + x_len + p_len, y, y_len);   /* include all known bytes */
 
@@ -190,7 +203,7 @@ BYTE decodeNextByte(int (*encrypt)(BYTE**, size_t*, BYTE*, size_t), const BYTE *
 
     /* Clean-up */
     free(t);
-    free(in);
+    arena_pop(global_arena, mark);
     freeDictionary(dict);
 
     return b;
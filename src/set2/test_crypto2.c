@@ -144,6 +144,167 @@ int CBCencrypt_test(BYTE *ptext)
     END_TEST_CASE;
 }
 
+/* Streaming CBC in random chunks matches the one-shot cipher both ways */
+int CBCstream1()
+{
+    START_TEST_CASE;
+    for (size_t t = 0; t < 50; t++) {
+        size_t x_len = RAND_RANGE(1, 200);
+        BYTE *x = rand_byte(x_len);
+        BYTE *key = rand_byte(BLOCK_SIZE);
+        BYTE *iv = rand_byte(BLOCK_SIZE);
+        BYTE *y = NULL,
+             *z = NULL;
+        size_t y_len = 0,
+               z_len = 0;
+        aes_128_cbc_encrypt(&y, &y_len, x, x_len, key, iv);
+        int n_pad = aes_128_cbc_decrypt(&z, &z_len, y, y_len, key, iv);
+
+        for (int enc = 1; enc >= 0; enc--) {
+            const BYTE *in = enc ? x : y;
+            size_t in_len = enc ? x_len : y_len,
+                   n_out = 0;
+            BYTE *out = init_byte(in_len + BLOCK_SIZE);
+            AES_STREAM *s = init_aes_stream(key, iv, enc);
+            for (size_t i = 0; i < in_len; ) {
+                size_t n = RAND_RANGE(1, 40);
+                n = MIN(n, in_len - i);
+                n_out += aes_stream_update(s, out + n_out, in + i, n);
+                i += n;
+            }
+            ssize_t n_last = aes_stream_final(s, out + n_out);
+            if (enc || n_pad >= 0) {
+                SHOULD_BE(n_last >= 0);
+                n_out += n_last;
+                SHOULD_BE(n_out == (enc ? y_len : z_len));
+                SHOULD_BE(!memcmp(out, enc ? y : z, n_out));
+            } else {
+                /* Random plaintext that doesn't end in valid padding */
+                SHOULD_BE(n_last == -1);
+            }
+            free_aes_stream(s);
+            free(out);
+        }
+
+        free(x);
+        free(y);
+        free(z);
+        free(key);
+        free(iv);
+    }
+    END_TEST_CASE;
+}
+
+/* Multi-threaded CBC decryption matches single-threaded, across thread and
+ * chunk boundaries */
+/* Caller-buffer CBC matches the allocating version and round-trips */
+int CBCinto1()
+{
+    START_TEST_CASE;
+    BYTE *key = rand_byte(BLOCK_SIZE);
+    BYTE *iv = rand_byte(BLOCK_SIZE);
+    BYTE x[PKCS7_LEN(50, BLOCK_SIZE)],
+         y[AES_CBC_LEN(sizeof(x))],
+         z[sizeof(y)];
+    for (size_t n = 0; n <= 50; n++) {
+        for (size_t i = 0; i < n; i++) { x[i] = 'a' + i % 26; }
+        BYTE *ref = NULL;
+        size_t ref_len = 0;
+        aes_128_cbc_encrypt(&ref, &ref_len, x, n, key, iv);
+        SHOULD_BE(aes_128_cbc_encrypt_into(y, x, n, key, iv) == (ssize_t)ref_len);
+        SHOULD_BE(!memcmp(y, ref, ref_len));
+        free(ref);
+        /* pad in place so the ciphertext carries its own padding */
+        ssize_t x_len = pkcs7_pad_into(x, x, n, BLOCK_SIZE);
+        SHOULD_BE(x_len == PKCS7_LEN(n, BLOCK_SIZE));
+        ssize_t y_len = aes_128_cbc_encrypt_into(y, x, x_len, key, iv);
+        SHOULD_BE(y_len == x_len);
+        SHOULD_BE(aes_128_cbc_decrypt_into(z, y, y_len, key, iv) == (ssize_t)n);
+        SHOULD_BE(!memcmp(z, x, n));
+        /* break the padding by flipping a bit of the second-to-last pad */
+        if (y_len > BLOCK_SIZE && n % BLOCK_SIZE != BLOCK_SIZE - 1) {
+            y[y_len - BLOCK_SIZE - 2] ^= 0x01;
+            SHOULD_BE(aes_128_cbc_decrypt_into(z, y, y_len, key, iv) == -1);
+        }
+    }
+    free(key);
+    free(iv);
+    END_TEST_CASE;
+}
+
+int CBCdecrypt2()
+{
+    START_TEST_CASE;
+    size_t n_blocks = 3*CBC_MIN_THREAD_BLOCKS + 37,
+           ptext_len = n_blocks*BLOCK_SIZE - 5;
+    BYTE *ptext = rand_byte(ptext_len);
+    BYTE *key = rand_byte(BLOCK_SIZE);
+    BYTE *iv = rand_byte(BLOCK_SIZE);
+    BYTE *ctext = NULL;
+    size_t ctext_len = 0;
+    aes_128_cbc_encrypt(&ctext, &ctext_len, ptext, ptext_len, key, iv);
+    SHOULD_BE(ctext_len == n_blocks*BLOCK_SIZE);
+    BYTE *x1 = init_byte(ctext_len),
+         *x4 = init_byte(ctext_len);
+    aes_128_cbc_decrypt_blocks(x1, ctext, n_blocks, key, iv, 1);
+    aes_128_cbc_decrypt_blocks(x4, ctext, n_blocks, key, iv, 4);
+    SHOULD_BE(!memcmp(x1, ptext, ptext_len));
+    SHOULD_BE(!memcmp(x1, x4, ctext_len));
+    /* Padding is checked once, on the whole output */
+    BYTE *dtext = NULL;
+    size_t dtext_len = 0;
+    SHOULD_BE(aes_128_cbc_decrypt(&dtext, &dtext_len, ctext, ctext_len, key, iv) == 5);
+    SHOULD_BE(dtext_len == ptext_len);
+    SHOULD_BE(!memcmp(dtext, ptext, ptext_len));
+    free(ptext);
+    free(key);
+    free(iv);
+    free(ctext);
+    free(x1);
+    free(x4);
+    free(dtext);
+    END_TEST_CASE;
+}
+
+/* Batch encryption matches encrypting each message alone, on every backend,
+ * with assorted lengths. Mostly shared keys take the lockstep path, mostly
+ * distinct keys the serial one. */
+int CBCencryptBatch1()
+{
+    START_TEST_CASE;
+    size_t n_msg = 50;
+    CBC_MSG msg[n_msg];
+    BYTE *shared_key = rand_byte(BLOCK_SIZE);
+    AES_BACKEND orig = aes_default_backend();
+    for (int t = 0; t < 2*AES_BACKEND_COUNT; t++) {
+        if (aes_set_default_backend(t / 2)) { continue; }
+        for (size_t j = 0; j < n_msg; j++) {
+            int shared = (t % 2) ? !(j % 3) : (j % 7);
+            msg[j].x_len = RAND_RANGE(0, 100);
+            msg[j].x = rand_byte(msg[j].x_len);
+            msg[j].key = shared ? shared_key : rand_byte(BLOCK_SIZE);
+            msg[j].iv = rand_byte(BLOCK_SIZE);
+        }
+        SHOULD_BE(aes_128_cbc_encrypt_batch(msg, n_msg) == 0);
+        for (size_t j = 0; j < n_msg; j++) {
+            BYTE *y = NULL;
+            size_t y_len = 0;
+            aes_128_cbc_encrypt(&y, &y_len, (BYTE *)msg[j].x, msg[j].x_len,
+                    (BYTE *)msg[j].key, (BYTE *)msg[j].iv);
+            SHOULD_BE(msg[j].y_len == y_len);
+            SHOULD_BE(!memcmp(msg[j].y, y, y_len));
+            free(y);
+            free(msg[j].y);
+            free((BYTE *)msg[j].x);
+            free((BYTE *)msg[j].iv);
+            if (msg[j].key != shared_key) { free((BYTE *)msg[j].key); }
+        }
+    }
+    aes_set_default_backend(orig);
+    free(shared_key);
+    END_TEST_CASE;
+}
+
 /* Generate a random AES key */
 int RandByte1()
 {
@@ -236,6 +397,10 @@ int main(void)
     RUN_TEST(PKCS74,           "              pkcs7() 4                ");
     RUN_TEST(PKCS75,           "              pkcs7() 5                ");
     RUN_TEST(CBCencrypt1,      "Challenge 10: aes_128_cbc_encrypt() 1  ");
+    RUN_TEST(CBCdecrypt2,      "              aes_128_cbc_decrypt() 2  ");
+    RUN_TEST(CBCinto1,         "              aes_128_cbc_decrypt_into ");
+    RUN_TEST(CBCencryptBatch1, "              aes_128_cbc_encrypt_batch");
+    RUN_TEST(CBCstream1,       "              aes_stream_update() CBC  ");
     RUN_TEST(RandByte1,        "Challenge 11: randByte() 1             ");
     RUN_TEST(KVParse1,         "Challenge 12: kv_parse()               ");
     RUN_TEST(KVEncode1,        "              kv_encode()              ");
@@ -0,0 +1,40 @@
+/*==============================================================================
+ *     File: aes_ctr_file.c
+ *  Created: 10/17/2026, 17:20
+ *   Author: Bernie Roesler
+ *
+ *  Description: Encrypt or decrypt a file with AES 128-bit CTR mode, key
+ *      "YELLOW SUBMARINE" and nonce 0, using all cores.
+ *
+ *============================================================================*/
+#include <limits.h>
+
+#include "header.h"
+#include "aes_openssl.h"
+#include "crypto_util.h"
+#include "crypto3.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s in_file out_file [threads]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    int n_threads = util_nthreads();
+    if (argc > 3) {
+        char *end;
+        long n = strtol(argv[3], &end, 10);
+        if (end == argv[3] || *end || n < 1 || n > INT_MAX) {
+            ERROR("Thread count '%s' is not a positive integer!", argv[3]);
+        }
+        n_threads = (int)n;
+    }
+    BYTE key[] = "YELLOW SUBMARINE";
+    BYTE nonce[BLOCK_SIZE/2] = {0};
+
+    return aes_128_ctr_file(argv[2], argv[1], key, nonce, n_threads);
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -10,7 +10,6 @@
 
 /* User-defined headers */
 #include "header.h"
-#include "fmemopen.h"
 #include "crypto_util.h"
 #include "aes_openssl.h"
 #include "crypto1.h"
@@ -58,32 +57,21 @@ size_t read_and_encrypt_file(char *b64_file, BYTE **y_lines, int *y_lens)
     while (fgets(line, MAX_LINE_LEN, fp)) 
     {
         n_lines++;
-        char *b64_clean = strrmchr(line, "\n");  /* strip newlines */
+        size_t nchar = strcspn(line, "\n");     /* skip the newline */
 
         /* Convert to byte array for encryption */
-        BYTE *byte = NULL;
-        size_t nbyte = b642byte(&byte, b64_clean);
-
-        /* Encrypt using CTR with fixed nonce and key */
-        FILE *xs = fmemopen(byte, nbyte, "r");
-        FILE *ys = tmpfile();
-        if (aes_128_ctr(ys, xs, key, nonce)) {
-            ERROR("Encryption failed!\n    line = '%s'", b64_clean);
+        BYTE *byte = init_byte(B642BYTE_LEN(nchar));
+        ssize_t nbyte = b642byte_into(byte, line, nchar);
+        if (nbyte < 0) { ERROR("Invalid base64!\n    line = '%s'", line); }
+
+        /* Encrypt in place using CTR with fixed nonce and key, and keep the
+         * encrypted bytes */
+        if (aes_128_ctr_buf(byte, byte, nbyte, key, nonce)) {
+            ERROR("Encryption failed!\n    line = '%s'", line);
         }
 
-        /* Store encrypted bytes in array */
-        BYTE *yb = init_byte(nbyte);
-        if (!fread(yb, 1, nbyte, ys)) {
-            ERROR("File read error!\n    line = '%s'", b64_clean);
-        }
-
-        *yl++ = yb;
+        *yl++ = byte;
         *yn++ = nbyte;
-
-        free(byte);
-        free(b64_clean);
-        fclose(xs);
-        fclose(ys);
     } /* end read from file */
 
     free(line);
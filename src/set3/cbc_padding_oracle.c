@@ -9,6 +9,17 @@
 
 #include "cbc_padding_oracle.h"
 
+/*------------------------------------------------------------------------------
+ *         Scratch arena for per-block temporaries, created ONCE
+ *----------------------------------------------------------------------------*/
+static ARENA *scratch_arena(void)
+{
+    if (!global_arena) {
+        global_arena = init_arena(ORACLE_ARENA_SIZE, ARENA_POISON);
+    }
+    return global_arena;
+}
+
 /*------------------------------------------------------------------------------
  *         Decrypt a block of CBC-encrypted ciphertext 
  *----------------------------------------------------------------------------*/
@@ -25,9 +36,11 @@ int block_decrypt(BYTE **Dy, BYTE *y) {
     size_t n_found = 0;
     last_byte(Dy, &n_found, y);
 
-    BYTE *rf = rand_byte(b);  /* fixed random input ciphertext */
-    BYTE *r  = init_byte(b);
-    BYTE *ry = init_byte(2*b);
+    ARENA *a = scratch_arena();
+    ARENA_MARK mark = arena_push(a);
+    BYTE *rf = arena_rand_byte(a, b);  /* fixed random input ciphertext */
+    BYTE *r  = arena_byte(a, b);
+    BYTE *ry = arena_byte(a, 2*b);
 
     /* for each remaining byte in the block */
     for (size_t j = b - n_found; j > 0; j--) {
@@ -65,9 +78,7 @@ int block_decrypt(BYTE **Dy, BYTE *y) {
         }
     }
 
-    free(rf);
-    free(r);
-    free(ry);
+    arena_pop(a, mark);
     return 0;
 }
 
@@ -87,11 +98,13 @@ int last_byte(BYTE **Dy, size_t *n_found, BYTE *y)
     /* Initialize output array */
     *Dy = init_byte(b);
 
-    BYTE *rf = rand_byte(b);  /* fixed random input ciphertext */
-    BYTE *r  = init_byte(b); /* temp  random input ciphertext */
-    memcpy(r, rf, b);        /* copy rf values into r */
+    ARENA *a = scratch_arena();
+    ARENA_MARK mark = arena_push(a);
+    BYTE *rf = arena_rand_byte(a, b);  /* fixed random input ciphertext */
+    BYTE *r  = arena_byte(a, b);       /* temp  random input ciphertext */
+    memcpy(r, rf, b);                  /* copy rf values into r */
 
-    BYTE *ry = init_byte(2*b);  /* composite (r||y) for pass to oracle */
+    BYTE *ry = arena_byte(a, 2*b);  /* composite (r||y) for pass to oracle */
 
     /* Guess last byte to give correct padding */
     for (size_t i = 0; i < 0x100; i++) { 
@@ -143,9 +156,7 @@ int last_byte(BYTE **Dy, size_t *n_found, BYTE *y)
             for (size_t j = b-n; j < b; j++) {
                 (*Dy)[j] = rf[j] ^ n;
             }
-            free(rf);
-            free(r);
-            free(ry);
+            arena_pop(a, mark);
             return 0;
         }
     }
@@ -154,9 +165,7 @@ int last_byte(BYTE **Dy, size_t *n_found, BYTE *y)
     *n_found = 1;
     (*Dy)[b-1] = rf[b-1] ^ 1;
 
-    free(rf);
-    free(r);
-    free(ry);
+    arena_pop(a, mark);
     return 0;
 }
 
@@ -174,6 +183,7 @@ int encryption_oracle(BYTE **y, size_t *y_len, int choice)
     size_t x_len = b642byte(&x, x_b64);
 
     *y_len = 0;
+    STATS_START(t0);
 
     /* Generate a random key ONCE */
     if (!global_key) {
@@ -188,6 +198,7 @@ int encryption_oracle(BYTE **y, size_t *y_len, int choice)
     /* Encrypt using CBC mode */
     aes_128_cbc_encrypt(y, y_len, x, x_len, global_key, global_iv);
     free(x);
+    STATS_STOP(STAT_ORACLE, t0, x_len);
     return 0;
 }
 
@@ -197,11 +208,11 @@ int encryption_oracle(BYTE **y, size_t *y_len, int choice)
 int padding_oracle(BYTE *y, size_t y_len)
 {
     /* Decrypt y report if padding is valid or not, but do not return x */
-    BYTE *x = NULL;
-    size_t x_len = 0;
-    int test = aes_128_cbc_decrypt(&x, &x_len, y, y_len, global_key, global_iv);
-    free(x);
-    return test;
+    STATS_START(t0);
+    BYTE x[y_len + 1];      /* +1 so an empty y is still a valid array */
+    ssize_t x_len = aes_128_cbc_decrypt_into(x, y, y_len, global_key, global_iv);
+    STATS_STOP(STAT_ORACLE, t0, y_len);
+    return x_len < 0 ? -1 : (int)(y_len - y_len % BLOCK_SIZE - x_len);
 }
 
 /*==============================================================================
@@ -14,6 +14,7 @@
 /* Global key, iv used in tests */
 BYTE *global_key = NULL;
 BYTE *global_iv  = NULL;
+ARENA *global_arena = NULL;
 
 int main(int argc, char **argv)
 {
@@ -44,14 +45,10 @@ int main(int argc, char **argv)
             /* IV assumed known */
             BYTE *yim1 = (i == 0) ? global_iv : (y + im1);
 
-            /* x = D(y) ^ y_{n-1} */
-            BYTE *xg = fixed_xor(Dy, yim1, BLOCK_SIZE);
-            n_pad = pkcs7_rmpad(xg, BLOCK_SIZE, BLOCK_SIZE);
-
-            /* Store in output array */
-            memcpy(x + idx, xg, BLOCK_SIZE);
+            /* x = D(y) ^ y_{n-1}, straight into the output array */
+            fixed_xor_into(x + idx, Dy, yim1, BLOCK_SIZE);
+            n_pad = pkcs7_rmpad(x + idx, BLOCK_SIZE, BLOCK_SIZE);
             free(Dy);
-            free(xg);
         }
 
         /* print result */
@@ -65,6 +62,7 @@ int main(int argc, char **argv)
 
     free(global_key);
     free(global_iv);
+    free_arena(global_arena);
     return 0;
 }
 
@@ -7,6 +7,10 @@
  *
  *============================================================================*/
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "header.h"
 #include "aes_openssl.h"
 #include "crypto1.h"
@@ -15,10 +19,42 @@
 
 
 /* Challenge 18: Implement AES CTR Mode */
-int aes_128_ctr(FILE *y, FILE *x, BYTE *key, BYTE *nonce)
+int aes_128_ctr_buf(BYTE *y, const BYTE *x, size_t len, const BYTE *key,
+        const BYTE *nonce)
 {
     /* Block -> Stream Cipher implementation
      * NOTE encryption and decryption are the same operation!!
+     * y     : output buffer of len bytes (may be x)
+     * x     : input buffer of len bytes
+     * key   : 128-bit AES key
+     * nonce : 64-bit unsigned little endian
+     *
+     * returns : integer 0 on success, non-zero on failure
+     */
+    return aes_128_ctr_at(y, x, len, 0, key, nonce);
+}
+
+int aes_128_ctr_at(BYTE *y, const BYTE *x, size_t len, uint64_t off,
+        const BYTE *key, const BYTE *nonce)
+{
+    /* Encrypt/decrypt bytes [off, off+len) of a CTR stream
+     * y     : output buffer of len bytes (may be x)
+     * x     : input buffer of len bytes, starting at stream byte off
+     * off   : offset of x[0] in the stream; need not be block aligned
+     * key   : 128-bit AES key
+     * nonce : 64-bit unsigned little endian
+     *
+     * returns : integer 0 on success, non-zero on failure
+     */
+    AES_CTX *ctx = aes_ctx_acquire(key, 1);
+    int out = aes_128_ctr_xor(ctx, y, x, len, nonce, off);
+    aes_ctx_release(ctx);
+    return out;
+}
+
+int aes_128_ctr(FILE *y, FILE *x, BYTE *key, BYTE *nonce)
+{
+    /* Stream version of aes_128_ctr_buf
      * y     : output stream
      * x     : input stream
      * key   : 128-bit AES key
@@ -26,29 +62,103 @@ int aes_128_ctr(FILE *y, FILE *x, BYTE *key, BYTE *nonce)
      *
      * returns : integer 0 on success, non-zero on failure
      */
-    int c;
-    BYTE *counter = init_byte(BLOCK_SIZE/2);
+    BYTE *buf = init_byte(CTR_CHUNK);
+    uint64_t pos = 0;
+    size_t n;
 
-    do {
-        BYTE *keystream = get_keystream_block(key, nonce, counter);
+    /* Key schedule comes from the cache, else is expanded once here */
+    AES_CTX *ctx = aes_ctx_acquire(key, 1);
 
-        /* Write x ^ keystream to y */
-        int n = 0;
-        while ((n < BLOCK_SIZE) && ((c = fgetc(x)) != EOF))
-        {
-            fputc(c ^ keystream[n++], y);
+    while ((n = fread(buf, 1, CTR_CHUNK, x)) > 0) {
+        if (0 != aes_128_ctr_xor(ctx, buf, buf, n, nonce, pos)) {
+            ERROR("Encryption failed!");
         }
+        if (fwrite(buf, 1, n, y) != n) { ERROR("Write error in output stream!"); }
+        pos += n;
+    }
 
-        if (ferror(x)) { ERROR("Read error in input stream!"); }
-
-        /* Increment counter for next block */
-        assert(inc64le(counter) == 0);
-        free(keystream);
-    } while (!feof(x));
+    if (ferror(x)) { ERROR("Read error in input stream!"); }
 
     /* Rewind output stream before returning */
     REWIND_CHECK(y);
-    free(counter);
+    aes_ctx_release(ctx);
+    free(buf);
+    return 0;
+}
+
+/*------------------------------------------------------------------------------
+ *         Multi-threaded CTR over memory-mapped files
+ *----------------------------------------------------------------------------*/
+typedef struct _CTR_JOB {
+    BYTE *y;                /* output mapping */
+    const BYTE *x;          /* input mapping */
+    size_t len;             /* bytes in each */
+    const BYTE *key;
+    const BYTE *nonce;
+} CTR_JOB;
+
+/* Blocks [start, end) of the file. The stream offset gives each range its own
+ * starting counter, so the ranges are independent. */
+static void ctr_file_range(size_t start, size_t end, void *arg)
+{
+    CTR_JOB *job = (CTR_JOB *)arg;
+    size_t off = start*BLOCK_SIZE,
+           len = MIN(end*BLOCK_SIZE, job->len) - off;
+
+    /* One context per thread: OpenSSL's can't be shared */
+    AES_CTX *ctx = aes_ctx_acquire(job->key, 1);
+    if (0 != aes_128_ctr_xor(ctx, job->y + off, job->x + off, len, job->nonce,
+                off)) {
+        ERROR("Encryption failed!");
+    }
+    aes_ctx_release(ctx);
+}
+
+int aes_128_ctr_file(const char *out_file, const char *in_file,
+        const BYTE *key, const BYTE *nonce, int n_threads)
+{
+    /* Encrypt/decrypt a whole file in CTR mode
+     * out_file  : output path, created or truncated to the input's size; may
+     *             be in_file itself, which is then en/decrypted in place
+     * in_file   : input path
+     * key       : 128-bit AES key
+     * nonce     : 64-bit unsigned little endian
+     * n_threads : most threads to use
+     *
+     * returns : integer 0 on success, non-zero on failure
+     */
+    struct stat st, st_out;
+    int fdx = open(in_file, O_RDONLY);
+    if (fdx < 0) { ERROR("File %s could not be read!", in_file); }
+    if (fstat(fdx, &st)) { ERROR("Could not stat %s!", in_file); }
+
+    /* Not truncated on open: out_file may be in_file under another name */
+    int fdy = open(out_file, O_RDWR | O_CREAT, 0644);
+    if (fdy < 0) { ERROR("File %s could not be written!", out_file); }
+    if (fstat(fdy, &st_out)) { ERROR("Could not stat %s!", out_file); }
+    int in_place = (st.st_dev == st_out.st_dev && st.st_ino == st_out.st_ino);
+
+    /* Size the output up front so it can be mapped and written anywhere */
+    size_t len = st.st_size;
+    if (!in_place && ftruncate(fdy, len)) {
+        ERROR("Could not size %s!", out_file);
+    }
+
+    if (len) {
+        BYTE *y = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fdy, 0),
+             *x = in_place ? y : mmap(NULL, len, PROT_READ, MAP_SHARED, fdx, 0);
+        if (x == MAP_FAILED || y == MAP_FAILED) { ERROR("mmap failed!"); }
+
+        CTR_JOB job = { y, x, len, key, nonce };
+        parallel_for((len + BLOCK_SIZE - 1) / BLOCK_SIZE, CTR_MIN_THREAD_BLOCKS,
+                n_threads, ctr_file_range, &job);
+
+        if (!in_place) { munmap(x, len); }
+        munmap(y, len);
+    }
+
+    close(fdx);
+    close(fdy);
     return 0;
 }
 
@@ -61,23 +171,36 @@ BYTE *get_keystream_block(BYTE *key, BYTE *nonce, BYTE *counter)
      *
      * returns : pointer to keystream
      */
-    BYTE *keystream = NULL;
-    BYTE *nc = init_byte(BLOCK_SIZE);
-    size_t len = 0;
+    BYTE *keystream = init_byte(BLOCK_SIZE);
+    BYTE nc[BLOCK_SIZE];
 
     /* Create (nonce || counter) */
     memcpy(nc, nonce, BLOCK_SIZE/2);
     memcpy(nc+BLOCK_SIZE/2, counter, BLOCK_SIZE/2);
 
     /* Encrypt single block to get keystream */
-    if (0 != aes_128_ecb_block(&keystream, &len, nc, BLOCK_SIZE, key, 1)) {
+    AES_CTX *ctx = aes_ctx_acquire(key, 1);
+    if (0 != aes_128_encrypt_block(ctx, keystream, nc)) {
         ERROR("Encryption failed!");
     }
 
-    free(nc);
+    aes_ctx_release(ctx);
     return keystream;
 }
 
+size_t ctr_seek(BYTE *counter, uint64_t off)
+{
+    /* Position a keystream counter at an arbitrary stream offset
+     * counter : 64-bit unsigned little endian counter (output)
+     * off     : byte offset into the stream
+     *
+     * returns : offset of byte off within its keystream block
+     */
+    uint64_t block = off / BLOCK_SIZE;
+    for (size_t b = 0; b < BLOCK_SIZE/2; b++) { counter[b] = block >> 8*b; }
+    return off % BLOCK_SIZE;
+}
+
 int inc64le(BYTE *counter)
 {
     /* Increment little-endian counter
@@ -19,6 +19,7 @@
 BYTE *global_key = (BYTE *)"BUSINESS CASUAL";
 BYTE *global_iv  = (BYTE *)"\x99\x99\x99\x99\x99\x99\x99\x99" \
                            "\x99\x99\x99\x99\x99\x99\x99\x99";
+ARENA *global_arena = NULL;
 
 /*------------------------------------------------------------------------------
  *        Define test functions
@@ -207,6 +208,8 @@ int main(void)
     RUN_TEST(BLOCKDECR1, "block_decrypt() 1 ");
     RUN_TEST(BLOCKDECR2, "block_decrypt() 2 ");
 
+    free_arena(global_arena);
+
     /* Count errors */
     if (!fails) {
         printf("\033[0;32mAll %d tests passed!\033[0m\n", total); 
@@ -121,6 +121,178 @@ int CTRENC1()
     END_TEST_CASE;
 }
 
+/* Buffer CTR matches one keystream block at a time, in place and across
+ * several FILE chunks */
+int CTRBUF1()
+{
+    START_TEST_CASE;
+    size_t x_len = 3*CTR_CHUNK + 37;
+    BYTE *x = rand_byte(x_len);
+    BYTE *key = rand_byte(BLOCK_SIZE);
+    BYTE *nonce = rand_byte(BLOCK_SIZE/2);
+    BYTE *counter = init_byte(BLOCK_SIZE/2);
+
+    /* Reference: block by block */
+    BYTE *y_ref = init_byte(x_len);
+    for (size_t i = 0; i < x_len; i += BLOCK_SIZE) {
+        BYTE *ks = get_keystream_block(key, nonce, counter);
+        for (size_t j = i; j < MIN(x_len, i + BLOCK_SIZE); j++) {
+            y_ref[j] = x[j] ^ ks[j - i];
+        }
+        inc64le(counter);
+        free(ks);
+    }
+
+    BYTE *y = init_byte(x_len);
+    SHOULD_BE(aes_128_ctr_buf(y, x, x_len, key, nonce) == 0);
+    SHOULD_BE(!memcmp(y, y_ref, x_len));
+
+    /* In place */
+    BYTE *z = init_byte(x_len);
+    memcpy(z, x, x_len);
+    SHOULD_BE(aes_128_ctr_buf(z, z, x_len, key, nonce) == 0);
+    SHOULD_BE(!memcmp(z, y_ref, x_len));
+
+    /* Stream wrapper */
+    FILE *xs = fmemopen(x, x_len, "r");
+    FILE *ys = tmpfile();
+    SHOULD_BE(aes_128_ctr(ys, xs, key, nonce) == 0);
+    SHOULD_BE(fread(y, 1, x_len, ys) == x_len);
+    SHOULD_BE(!memcmp(y, y_ref, x_len));
+
+    free(x);
+    free(y);
+    free(z);
+    free(y_ref);
+    free(key);
+    free(nonce);
+    free(counter);
+    fclose(xs);
+    fclose(ys);
+    END_TEST_CASE;
+}
+
+/* Any range of the stream, aligned or not, matches the same bytes of a full
+ * pass; far offsets agree with ctr_seek/get_keystream_block */
+int CTRSEEK1()
+{
+    START_TEST_CASE;
+    size_t x_len = 5000;
+    BYTE *x = rand_byte(x_len);
+    BYTE *key = rand_byte(BLOCK_SIZE);
+    BYTE *nonce = rand_byte(BLOCK_SIZE/2);
+    BYTE *y_ref = init_byte(x_len);
+    BYTE *y = init_byte(x_len);
+    SHOULD_BE(aes_128_ctr_buf(y_ref, x, x_len, key, nonce) == 0);
+
+    for (size_t t = 0; t < 200; t++) {
+        size_t off = RAND_RANGE(0, x_len - 1),
+               len = RAND_RANGE(0, x_len - off);
+        SHOULD_BE(aes_128_ctr_at(y, x + off, len, off, key, nonce) == 0);
+        SHOULD_BE(!memcmp(y, y_ref + off, len));
+    }
+
+    /* Past 2^32 blocks the high counter word is in play too */
+    uint64_t far = ((uint64_t)1 << 36) + 16*12345 + 7;
+    BYTE *counter = init_byte(BLOCK_SIZE/2);
+    size_t skip = ctr_seek(counter, far);
+    SHOULD_BE(skip == 7);
+    BYTE *ks0 = get_keystream_block(key, nonce, counter);
+    inc64le(counter);
+    BYTE *ks1 = get_keystream_block(key, nonce, counter);
+    BYTE ks[2*BLOCK_SIZE];
+    memcpy(ks, ks0, BLOCK_SIZE);
+    memcpy(ks + BLOCK_SIZE, ks1, BLOCK_SIZE);
+    BYTE zero[BLOCK_SIZE] = {0};
+    SHOULD_BE(aes_128_ctr_at(y, zero, BLOCK_SIZE, far, key, nonce) == 0);
+    SHOULD_BE(!memcmp(y, ks + skip, BLOCK_SIZE));
+
+    free(x);
+    free(y);
+    free(y_ref);
+    free(key);
+    free(nonce);
+    free(counter);
+    free(ks0);
+    free(ks1);
+    END_TEST_CASE;
+}
+
+/* Memory-mapped, threaded file mode matches the buffer API, including empty
+ * files, tails that aren't whole blocks and output to the input file */
+int CTRFILE1()
+{
+    START_TEST_CASE;
+    size_t sizes[] = { 0, 1, 15, 17, 4096, 3*CTR_MIN_THREAD_BLOCKS*BLOCK_SIZE + 9 };
+    char in_file[] = "/tmp/test_ctr_in.XXXXXX",
+         out_file[] = "/tmp/test_ctr_out.XXXXXX";
+    int fdx = mkstemp(in_file),
+        fdy = mkstemp(out_file);
+    SHOULD_BE(fdx >= 0 && fdy >= 0);
+    BYTE *key = rand_byte(BLOCK_SIZE);
+    BYTE *nonce = rand_byte(BLOCK_SIZE/2);
+
+    for (size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        size_t x_len = sizes[i];
+        BYTE *x = rand_byte(x_len);
+        BYTE *y_ref = init_byte(x_len);
+        BYTE *y = init_byte(x_len);
+        SHOULD_BE(aes_128_ctr_buf(y_ref, x, x_len, key, nonce) == 0);
+
+        FILE *fp = fopen(in_file, "w");
+        SHOULD_BE(fwrite(x, 1, x_len, fp) == x_len);
+        fclose(fp);
+
+        for (int t = 1; t <= 4; t *= 4) {
+            SHOULD_BE(aes_128_ctr_file(out_file, in_file, key, nonce, t) == 0);
+            fp = fopen(out_file, "r");
+            SHOULD_BE(fread(y, 1, x_len + 1, fp) == x_len);
+            fclose(fp);
+            SHOULD_BE(!memcmp(y, y_ref, x_len));
+        }
+
+        free(x);
+        free(y);
+        free(y_ref);
+    }
+
+    /* The same file as input and output, also through a second name: in
+     * place, not truncated first */
+    char link_file[] = "/tmp/test_ctr_link.XXXXXX";
+    SHOULD_BE(mkstemp(link_file) >= 0);
+    remove(link_file);
+    SHOULD_BE(link(in_file, link_file) == 0);
+
+    size_t x_len = 3*CTR_MIN_THREAD_BLOCKS*BLOCK_SIZE + 9;
+    BYTE *x = rand_byte(x_len),
+         *y = init_byte(x_len),
+         *y_ref = init_byte(x_len);
+    SHOULD_BE(aes_128_ctr_buf(y_ref, x, x_len, key, nonce) == 0);
+    const char *out_name[] = { in_file, link_file };
+    for (int k = 0; k < 2; k++) {
+        FILE *fp = fopen(in_file, "w");
+        SHOULD_BE(fwrite(x, 1, x_len, fp) == x_len);
+        fclose(fp);
+        SHOULD_BE(aes_128_ctr_file(out_name[k], in_file, key, nonce, 4) == 0);
+        fp = fopen(in_file, "r");
+        SHOULD_BE(fread(y, 1, x_len + 1, fp) == x_len);
+        fclose(fp);
+        SHOULD_BE(!memcmp(y, y_ref, x_len));
+    }
+    free(x);
+    free(y);
+    free(y_ref);
+
+    close(fdx);
+    close(fdy);
+    remove(in_file);
+    remove(out_file);
+    remove(link_file);
+    free(key);
+    free(nonce);
+    END_TEST_CASE;
+}
+
 /*------------------------------------------------------------------------------
  *        Run tests
  *----------------------------------------------------------------------------*/
@@ -134,6 +306,9 @@ int main(void)
     RUN_TEST(INCLE2,  "inc64le() 2     ");
     RUN_TEST(CTRDEC1, "aes_128_ctr() 1 ");
     RUN_TEST(CTRENC1, "aes_128_ctr() 2 ");
+    RUN_TEST(CTRBUF1, "aes_128_ctr_buf()");
+    RUN_TEST(CTRSEEK1,"aes_128_ctr_at() ");
+    RUN_TEST(CTRFILE1,"aes_128_ctr_file()");
 
     /* Count errors */
     if (!fails) {
@@ -6,6 +6,10 @@
  *  Description: AES encryption functions using OpenSSL library
  *
  *============================================================================*/
+#include <limits.h>
+#include <pthread.h>
+#include <openssl/crypto.h>
+
 #include "header.h"
 #include "aes_openssl.h"
 #include "crypto_util.h"
@@ -34,66 +38,557 @@ void handleErrors(void)
 }
 
 /*------------------------------------------------------------------------------
- *          General encryption/decryption function for one block
+ *          Backend selection
+ *----------------------------------------------------------------------------*/
+static const char *backend_names[AES_BACKEND_COUNT] = {
+    "openssl", "aesni", "bitslice"
+};
+
+static AES_BACKEND default_backend = AES_BACKEND_OPENSSL;
+
+int aes_backend_available(AES_BACKEND backend)
+{
+    switch (backend) {
+        case AES_BACKEND_OPENSSL:  return 1;
+        case AES_BACKEND_AESNI:    return aesni_available();
+        case AES_BACKEND_BITSLICE: return 1;
+        default:                   return 0;
+    }
+}
+
+const char *aes_backend_name(AES_BACKEND backend)
+{
+    return (backend < AES_BACKEND_COUNT) ? backend_names[backend] : "unknown";
+}
+
+AES_BACKEND aes_default_backend(void)
+{
+    return default_backend;
+}
+
+int aes_set_default_backend(AES_BACKEND backend)
+{
+    if (!aes_backend_available(backend)) { return -1; }
+    default_backend = backend;
+    return 0;
+}
+
+/* Pick the fastest available backend before main() runs, unless the
+ * environment asks for a specific one */
+__attribute__((constructor))
+static void aes_select_backend(void)
+{
+    const char *env = getenv(AES_BACKEND_ENV);
+
+    default_backend = aesni_available() ? AES_BACKEND_AESNI : AES_BACKEND_OPENSSL;
+
+    if (!env || !*env) { return; }
+
+    for (int b = 0; b < AES_BACKEND_COUNT; b++) {
+        if (!strcmp(env, backend_names[b])) {
+            if (aes_set_default_backend(b)) {
+                WARNING("%s=%s not available, using %s.", AES_BACKEND_ENV,
+                        env, backend_names[default_backend]);
+            }
+            return;
+        }
+    }
+
+    WARNING("Unknown %s=%s, using %s.", AES_BACKEND_ENV, env,
+            backend_names[default_backend]);
+}
+
+/*------------------------------------------------------------------------------
+ *          Allocate and key an AES context
  *----------------------------------------------------------------------------*/
 /* Set enc to 1 for encryption, 0 for decryption */
+AES_CTX *init_aes_ctx(const BYTE *key, int enc)
+{
+    return init_aes_ctx_backend(key, enc, default_backend);
+}
+
+AES_CTX *init_aes_ctx_backend(const BYTE *key, int enc, AES_BACKEND backend)
+{
+    if (!aes_backend_available(backend)) {
+        ERROR("AES backend %s not available!", aes_backend_name(backend));
+    }
+
+    AES_CTX *ctx = NEW(AES_CTX);
+    MALLOC_CHECK(ctx);
+    ctx->backend = backend;
+    ctx->enc = enc ? 1 : 0;
+    ctx->evp = NULL;
+    memcpy(ctx->key, key, BLOCK_SIZE);
+
+    if (backend == AES_BACKEND_AESNI) {
+        /* Only the schedule for our direction is needed */
+        aesni_expand_key(ctx->enc ? ctx->rk : NULL, ctx->enc ? NULL : ctx->rk,
+                key);
+        return ctx;
+    }
+
+    if (backend == AES_BACKEND_BITSLICE) {
+        bitslice_expand_key(ctx->bs_rk, key);
+        return ctx;
+    }
+
+    /* Initialize the context */
+    if (!(ctx->evp = EVP_CIPHER_CTX_new())) { handleErrors(); }
+
+    /* Expand the key schedule ONCE. No IV needed for ECB */
+    if (1 != EVP_CipherInit_ex(ctx->evp, EVP_aes_128_ecb(), NULL, key, NULL,
+                ctx->enc)) {
+        handleErrors(); 
+    }
+
+    /* Turn off automatic padding always, so every update is whole blocks in,
+     * whole blocks out and no EVP_CipherFinal_ex is ever needed */
+    if (1 != EVP_CIPHER_CTX_set_padding(ctx->evp, 0)) { handleErrors(); }
+
+    return ctx;
+}
+
+/*------------------------------------------------------------------------------
+ *          Free an AES context
+ *----------------------------------------------------------------------------*/
+void free_aes_ctx(AES_CTX *ctx)
+{
+    if (!ctx) { return; }
+    if (ctx->evp) { EVP_CIPHER_CTX_free(ctx->evp); }
+    /* Don't leave the key or its schedule in freed memory. A memset
+     * just before free is a dead store the compiler drops; OPENSSL_cleanse
+     * is not. */
+    OPENSSL_cleanse(ctx->key, sizeof(ctx->key));
+    OPENSSL_cleanse(ctx->rk, sizeof(ctx->rk));
+    OPENSSL_cleanse(ctx->bs_rk, sizeof(ctx->bs_rk));
+    free(ctx);
+}
+
+/*------------------------------------------------------------------------------
+ *          Cache of keyed contexts
+ *----------------------------------------------------------------------------*/
+/* Contexts not in use, each stamped with its last release; evicted and
+ * flushed ones go through free_aes_ctx, which wipes the key. An acquired
+ * context leaves the cache, so no two threads ever share one. */
+static AES_CTX *ctx_cache[AES_CTX_CACHE_SIZE];
+static unsigned long ctx_stamp[AES_CTX_CACHE_SIZE],
+                     ctx_clock = 0;
+static size_t ctx_hits = 0,
+              ctx_misses = 0;
+static int ctx_cache_on = 1;
+static pthread_mutex_t ctx_lock = PTHREAD_MUTEX_INITIALIZER;
+
+AES_CTX *aes_ctx_acquire(const BYTE *key, int enc)
+{
+    AES_CTX *ctx = NULL;
+    int best = -1;
+
+    pthread_mutex_lock(&ctx_lock);
+    if (ctx_cache_on) {
+        /* Most recently released match */
+        for (int i = 0; i < AES_CTX_CACHE_SIZE; i++) {
+            AES_CTX *c = ctx_cache[i];
+            if (c && c->enc == !!enc && c->backend == default_backend
+                    && !memcmp(c->key, key, BLOCK_SIZE)
+                    && (best < 0 || ctx_stamp[i] > ctx_stamp[best])) {
+                best = i;
+            }
+        }
+        if (best >= 0) {
+            ctx = ctx_cache[best];
+            ctx_cache[best] = NULL;
+            ctx_hits++;
+        } else {
+            ctx_misses++;
+        }
+    }
+    pthread_mutex_unlock(&ctx_lock);
+
+    return ctx ? ctx : init_aes_ctx(key, enc);
+}
+
+void aes_ctx_release(AES_CTX *ctx)
+{
+    AES_CTX *victim = ctx;
+    int slot = 0;
+
+    if (!ctx) { return; }
+
+    pthread_mutex_lock(&ctx_lock);
+    if (ctx_cache_on) {
+        /* An empty slot, else the least recently used */
+        for (int i = 0; i < AES_CTX_CACHE_SIZE; i++) {
+            if (!ctx_cache[i]) { slot = i; break; }
+            if (ctx_stamp[i] < ctx_stamp[slot]) { slot = i; }
+        }
+        victim = ctx_cache[slot];
+        ctx_cache[slot] = ctx;
+        ctx_stamp[slot] = ++ctx_clock;
+    }
+    pthread_mutex_unlock(&ctx_lock);
+
+    free_aes_ctx(victim);
+}
+
+void aes_ctx_cache_stats(size_t *hits, size_t *misses)
+{
+    pthread_mutex_lock(&ctx_lock);
+    if (hits) { *hits = ctx_hits; }
+    if (misses) { *misses = ctx_misses; }
+    pthread_mutex_unlock(&ctx_lock);
+}
+
+void aes_ctx_cache_flush(void)
+{
+    pthread_mutex_lock(&ctx_lock);
+    for (int i = 0; i < AES_CTX_CACHE_SIZE; i++) {
+        free_aes_ctx(ctx_cache[i]);
+        ctx_cache[i] = NULL;
+        ctx_stamp[i] = 0;
+    }
+    ctx_hits = ctx_misses = 0;
+    pthread_mutex_unlock(&ctx_lock);
+}
+
+void aes_ctx_cache_enable(int on)
+{
+    if (!on) { aes_ctx_cache_flush(); }
+    pthread_mutex_lock(&ctx_lock);
+    ctx_cache_on = on;
+    pthread_mutex_unlock(&ctx_lock);
+}
+
+/*------------------------------------------------------------------------------
+ *          Run n_blocks through a keyed context
+ *----------------------------------------------------------------------------*/
+static int aes_128_blocks(AES_CTX *ctx, BYTE *out, const BYTE *in,
+        size_t n_blocks, int enc)
+{
+    /* EVP lengths are int, so feed very large buffers in chunks */
+    static const size_t max_chunk = (INT_MAX / BLOCK_SIZE) * BLOCK_SIZE;
+    size_t nbyte = n_blocks * BLOCK_SIZE;
+    int len = 0;
+
+    if (ctx->enc != enc) {
+        ERROR("AES context keyed for %scryption!", ctx->enc ? "en" : "de");
+    }
+
+    STATS_START(t0);
+
+    if (ctx->backend == AES_BACKEND_AESNI) {
+        if (enc) {
+            aesni_encrypt_blocks(ctx->rk, out, in, n_blocks);
+        } else {
+            aesni_decrypt_blocks(ctx->rk, out, in, n_blocks);
+        }
+        STATS_STOP(STAT_AES, t0, nbyte);
+        return 0;
+    }
+
+    if (ctx->backend == AES_BACKEND_BITSLICE) {
+        if (enc) {
+            bitslice_encrypt_blocks(ctx->bs_rk, out, in, n_blocks);
+        } else {
+            bitslice_decrypt_blocks(ctx->bs_rk, out, in, n_blocks);
+        }
+        STATS_STOP(STAT_AES, t0, nbyte);
+        return 0;
+    }
+
+    while (nbyte) {
+        size_t chunk = MIN(nbyte, max_chunk);
+
+        /* No padding, so output length always equals input length */
+        if (1 != EVP_CipherUpdate(ctx->evp, out, &len, in, (int)chunk)) {
+            handleErrors(); 
+        }
+
+        out   += chunk;
+        in    += chunk;
+        nbyte -= chunk;
+    }
+
+    STATS_STOP(STAT_AES, t0, n_blocks * BLOCK_SIZE);
+    return 0;
+}
+
+int aes_128_encrypt_blocks(AES_CTX *ctx, BYTE *out, const BYTE *in, size_t n_blocks)
+{
+    return aes_128_blocks(ctx, out, in, n_blocks, 1);
+}
+
+int aes_128_decrypt_blocks(AES_CTX *ctx, BYTE *out, const BYTE *in, size_t n_blocks)
+{
+    return aes_128_blocks(ctx, out, in, n_blocks, 0);
+}
+
+/*------------------------------------------------------------------------------
+ *          Encrypt blocks under a context each
+ *----------------------------------------------------------------------------*/
+/* Blocks handed to the AES-NI multi-key kernel per call */
+#define MULTI_BATCH 64
+
+int aes_128_encrypt_blocks_multi(AES_CTX **ctx, BYTE *out, const BYTE *in,
+        size_t n_blocks)
+{
+    size_t i = 0;
+
+    while (i < n_blocks) {
+        size_t n = 0;
+
+        /* AES-NI interleaves blocks whatever their keys */
+        if (ctx[i]->backend == AES_BACKEND_AESNI) {
+            const BYTE *ek[MULTI_BATCH];
+            while (i + n < n_blocks && n < MULTI_BATCH
+                    && ctx[i + n]->backend == AES_BACKEND_AESNI) {
+                if (!ctx[i + n]->enc) {
+                    ERROR("AES context keyed for decryption!");
+                }
+                ek[n] = ctx[i + n]->rk;
+                n++;
+            }
+            STATS_START(t0);
+            aesni_encrypt_blocks_multikey(ek, out + i*BLOCK_SIZE,
+                    in + i*BLOCK_SIZE, n);
+            STATS_STOP(STAT_AES, t0, n * BLOCK_SIZE);
+            i += n;
+            continue;
+        }
+
+        /* Others: one bulk call per run of blocks under the same context */
+        do { n++; } while (i + n < n_blocks && ctx[i + n] == ctx[i]);
+        aes_128_blocks(ctx[i], out + i*BLOCK_SIZE, in + i*BLOCK_SIZE, n, 1);
+        i += n;
+    }
+
+    return 0;
+}
+
+/*------------------------------------------------------------------------------
+ *          Decrypt and XOR with a mask stream (CBC decryption)
+ *----------------------------------------------------------------------------*/
+int aes_128_decrypt_blocks_xor(AES_CTX *ctx, BYTE *out, const BYTE *in,
+        const BYTE *mask, size_t n_blocks)
+{
+    if (ctx->enc) { ERROR("AES context keyed for encryption!"); }
+
+    /* AES-NI does the XOR in registers on the way out */
+    if (ctx->backend == AES_BACKEND_AESNI) {
+        STATS_START(t0);
+        aesni_decrypt_blocks_xor(ctx->rk, out, in, mask, n_blocks);
+        STATS_STOP(STAT_AES, t0, n_blocks * BLOCK_SIZE);
+        return 0;
+    }
+
+    /* Everyone else: decrypt a cache-sized chunk, then XOR it while hot */
+    for (size_t i = 0; i < n_blocks; i += AES_XOR_CHUNK_BLOCKS) {
+        size_t n = MIN(AES_XOR_CHUNK_BLOCKS, n_blocks - i);
+        aes_128_blocks(ctx, out + i*BLOCK_SIZE, in + i*BLOCK_SIZE, n, 0);
+        xor_buf(out + i*BLOCK_SIZE, out + i*BLOCK_SIZE, mask + i*BLOCK_SIZE,
+                n*BLOCK_SIZE);
+    }
+
+    return 0;
+}
+
+/* Store v as 8 little-endian bytes, as inc64le keeps the CTR counter */
+static inline void store_le64(BYTE *p, uint64_t v)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+int aes_128_ctr_xor(AES_CTX *ctx, BYTE *out, const BYTE *in, size_t len,
+        const BYTE *nonce, uint64_t pos)
+{
+    BYTE nc[AES_CTR_BATCH_BLOCKS*BLOCK_SIZE],   /* (nonce || counter) blocks */
+         ks[AES_CTR_BATCH_BLOCKS*BLOCK_SIZE];   /* keystream */
+    uint64_t counter = pos / BLOCK_SIZE;        /* block holding byte pos */
+    size_t skip = pos % BLOCK_SIZE;             /* keystream bytes before pos */
+
+    if (!ctx->enc) { ERROR("AES context keyed for decryption!"); }
+
+    /* The nonce halves never change */
+    for (size_t k = 0; k < AES_CTR_BATCH_BLOCKS; k++) {
+        memcpy(nc + k*BLOCK_SIZE, nonce, BLOCK_SIZE/2);
+    }
+
+    for (size_t done = 0; done < len; ) {
+        size_t n = MIN(sizeof(ks) - skip, len - done),
+               n_blocks = (skip + n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        for (size_t k = 0; k < n_blocks; k++, counter++) {
+            store_le64(nc + k*BLOCK_SIZE + BLOCK_SIZE/2, counter);
+        }
+        aes_128_blocks(ctx, ks, nc, n_blocks, 1);
+
+        /* Only the first batch can start mid-block */
+        xor_buf(out + done, in + done, ks + skip, n);
+        done += n;
+        skip = 0;
+    }
+
+    return 0;
+}
+
+int aes_128_encrypt_block(AES_CTX *ctx, BYTE *out, const BYTE *in)
+{
+    return aes_128_blocks(ctx, out, in, 1, 1);
+}
+
+int aes_128_decrypt_block(AES_CTX *ctx, BYTE *out, const BYTE *in)
+{
+    return aes_128_blocks(ctx, out, in, 1, 0);
+}
+
+/*------------------------------------------------------------------------------
+ *          General encryption/decryption function for one block
+ *----------------------------------------------------------------------------*/
+/* Set enc to 1 for encryption, 0 for decryption.
+ * NOTE one-shot convenience: the schedule comes from the context cache, but
+ * loops over many blocks should still hold an AES_CTX. */
 int aes_128_ecb_block(BYTE **out, size_t *out_len, BYTE *in, size_t in_len, 
         BYTE *key, int enc)
 {
-    EVP_CIPHER_CTX *ctx = NULL;
-    int len = -1;
     *out_len = 0;
 
     if (in_len != BLOCK_SIZE) { ERROR("Input must be multiple of BLOCK_SIZE!"); }
 
     /* Initialize output buffer -- save room for null-termination */
-    *out = init_byte(in_len + BLOCK_SIZE + 1);
+    *out = init_byte(in_len);
 
-    /* Initialize the context */
-    if (!(ctx = EVP_CIPHER_CTX_new())) { handleErrors(); }
+    AES_CTX *ctx = aes_ctx_acquire(key, enc);
+    aes_128_blocks(ctx, *out, in, 1, ctx->enc);
+    *out_len = BLOCK_SIZE;
 
-    /* Initialise the en/decryption operation. No IV needed for ECB */
-    if (1 != EVP_CipherInit_ex(ctx, EVP_aes_128_ecb(), NULL, key, NULL, enc)) { 
-        handleErrors(); 
+    /* Clean up */
+    aes_ctx_release(ctx);
+    return 0;
+}
+
+/*------------------------------------------------------------------------------
+ *         Streaming ECB/CBC
+ *----------------------------------------------------------------------------*/
+AES_STREAM *init_aes_stream(const BYTE *key, const BYTE *iv, int enc)
+{
+    AES_STREAM *s = calloc(1, sizeof(AES_STREAM));
+    MALLOC_CHECK(s);
+    s->ctx = aes_ctx_acquire(key, enc);
+    s->enc = enc;
+    s->cbc = (iv != NULL);
+    if (iv) { memcpy(s->chain, iv, BLOCK_SIZE); }
+    return s;
+}
+
+void free_aes_stream(AES_STREAM *s)
+{
+    if (!s) { return; }
+    aes_ctx_release(s->ctx);
+    free(s);
+}
+
+/* Run n_blocks whole blocks of in through the stream's mode */
+static void aes_stream_blocks(AES_STREAM *s, BYTE *out, const BYTE *in,
+        size_t n_blocks)
+{
+    if (!n_blocks) { return; }
+
+    if (!s->cbc) {
+        aes_128_blocks(s->ctx, out, in, n_blocks, s->enc);
+        return;
+    }
+
+    if (s->enc) {
+        /* Each block chains on the one before */
+        BYTE xp[BLOCK_SIZE];
+        for (size_t i = 0; i < n_blocks; i++) {
+            xor_buf(xp, in + i*BLOCK_SIZE, s->chain, BLOCK_SIZE);
+            aes_128_blocks(s->ctx, out + i*BLOCK_SIZE, xp, 1, 1);
+            memcpy(s->chain, out + i*BLOCK_SIZE, BLOCK_SIZE);
+        }
+    } else {
+        /* Decryption only needs the ciphertext, so the run goes in bulk */
+        aes_128_decrypt_blocks_xor(s->ctx, out, in, s->chain, 1);
+        aes_128_decrypt_blocks_xor(s->ctx, out + BLOCK_SIZE, in + BLOCK_SIZE,
+                in, n_blocks - 1);
+        memcpy(s->chain, in + (n_blocks-1)*BLOCK_SIZE, BLOCK_SIZE);
     }
+}
 
-    /* Turn off automatic padding always */
-    if (1 != EVP_CIPHER_CTX_set_padding(ctx, 0)) { handleErrors(); }
+size_t aes_stream_update(AES_STREAM *s, BYTE *out, const BYTE *in, size_t n)
+{
+    size_t total = s->n_buf + n,
+           /* Bytes left over afterwards: decryption always keeps 1..16 */
+           keep = s->enc ? total % BLOCK_SIZE
+                         : (total ? (total - 1) % BLOCK_SIZE + 1 : 0),
+           n_blocks = (total - keep) / BLOCK_SIZE,
+           n_out = n_blocks * BLOCK_SIZE;
 
-    /* Provide the message, and obtain the output.
-     * EVP_CipherUpdate can be called multiple times if necessary */
-    if (1 != EVP_CipherUpdate(ctx, *out, &len, in, in_len)) {
-        handleErrors(); 
+    /* Finish the buffered block first */
+    if (n_blocks && s->n_buf) {
+        size_t fill = BLOCK_SIZE - s->n_buf;
+        memcpy(s->buf + s->n_buf, in, fill);
+        aes_stream_blocks(s, out, s->buf, 1);
+        in += fill;
+        n -= fill;
+        out += BLOCK_SIZE;
+        n_blocks--;
+        s->n_buf = 0;
     }
-    *out_len = len;
 
-    /* Finalise the operation. Further out bytes may be written. Provide pointer
-     * to end of output array (out+len) */
-    if (1 != EVP_CipherFinal_ex(ctx, *out + len, &len)) { handleErrors(); }
-    *out_len += len;
+    /* Then straight from the input */
+    aes_stream_blocks(s, out, in, n_blocks);
+    in += n_blocks*BLOCK_SIZE;
+    n -= n_blocks*BLOCK_SIZE;
 
-    /* Clean up */
-    EVP_CIPHER_CTX_free(ctx);
-    return 0;
+    memcpy(s->buf + s->n_buf, in, n);
+    s->n_buf += n;
+    return n_out;
+}
+
+ssize_t aes_stream_final(AES_STREAM *s, BYTE *out)
+{
+    if (!s->n_buf) { return 0; }
+
+    if (s->enc) {
+        /* PKCS#7 pad the last partial block */
+        memset(s->buf + s->n_buf, BLOCK_SIZE - s->n_buf, BLOCK_SIZE - s->n_buf);
+        aes_stream_blocks(s, out, s->buf, 1);
+        s->n_buf = 0;
+        return BLOCK_SIZE;
+    }
+
+    if (s->n_buf != BLOCK_SIZE) { return -1; }
+
+    aes_stream_blocks(s, out, s->buf, 1);
+    s->n_buf = 0;
+    int n_pad = pkcs7_rmpad(out, BLOCK_SIZE, BLOCK_SIZE);
+    return n_pad < 0 ? -1 : BLOCK_SIZE - n_pad;
 }
 
 /*------------------------------------------------------------------------------
  *         Challenge 9: PKCS#7 padding to block size 
  *----------------------------------------------------------------------------*/
 BYTE *pkcs7_pad(const BYTE *byte, size_t nbyte, size_t block_size)
+{
+    BYTE *out = init_byte(PKCS7_LEN(nbyte, block_size));
+    pkcs7_pad_into(out, byte, nbyte, block_size);
+    return out;
+}
+
+ssize_t pkcs7_pad_into(BYTE *out, const BYTE *byte, size_t nbyte,
+        size_t block_size)
 {
     BYTE n_pad = block_size - (nbyte % block_size);
 
-    BYTE *out = init_byte(nbyte + n_pad);
-    memcpy(out, byte, nbyte);
-    BYTE *p = out + nbyte;      /* start at end of original byte array */
+    if (out != byte) { memmove(out, byte, nbyte); }
 
-    /* Add N-bytes of char N */
-    for (int i = 0; i < n_pad; i++) {
-        *p++ = n_pad;
-    }
+    /* Add N-bytes of char N, starting at end of original byte array */
+    memset(out + nbyte, n_pad, n_pad);
 
-    return out;
+    return nbyte + n_pad;
 }
 
 /*------------------------------------------------------------------------------
@@ -0,0 +1,50 @@
+/*==============================================================================
+ *     File: make_ngram.c
+ *  Created: 10/17/2026, 22:40
+ *   Author: Bernie Roesler
+ *
+ *  Description: Train the n-gram tables on a corpus of plain text files and
+ *      write them for ngram_load. data/english.ngram was made from the
+ *      distinct license texts of /usr/share/common-licenses (Apache-2.0,
+ *      Artistic, BSD, CC0-1.0, GFDL-1.2, GFDL-1.3, GPL-1, GPL-2, GPL-3,
+ *      LGPL-2, LGPL-2.1, LGPL-3, MPL-1.1, MPL-2.0), about 240 KB of English:
+ *
+ *          ./make_ngram ../../data/english.ngram /usr/share/common-licenses/...
+ *
+ *      None of the challenge plaintexts are in the corpus.
+ *
+ *============================================================================*/
+#include "header.h"
+#include "crypto_util.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s out.ngram corpus.txt...\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Join the files, so n-grams span only the seams between them */
+    BYTE *corpus = NULL;
+    size_t nbyte = 0;
+    for (int i = 2; i < argc; i++) {
+        char *text = NULL;
+        size_t n = file2str(&text, argv[i]);
+        corpus = realloc(corpus, nbyte + n);
+        MALLOC_CHECK(corpus);
+        memcpy(corpus + nbyte, text, n);
+        nbyte += n;
+        free(text);
+    }
+
+    if (ngram_train(argv[1], corpus, nbyte)) {
+        ERROR("Could not write %s!", argv[1]);
+    }
+    printf("%s: %zu bytes of corpus\n", argv[1], nbyte);
+
+    free(corpus);
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -14,6 +14,15 @@
 #include "aes_openssl.h"
 #include "crypto_util.h"
 #include "unit_test.h"
+#include "bench.h"
+
+/* Timing samples per class, and the Welch t above which timing is taken to
+ * depend on the key. This is a smoke check, not a constant-time proof: a few
+ * thousand wall-clock samples, often under a sanitizer, are too noisy for
+ * dudect's 4.5 (meant for ~10^6 cycle-counted samples) without false
+ * failures, so the bound only catches gross key-dependent timing. */
+#define TIMING_SAMPLES 2000
+#define TIMING_MAX_T 10.0
 
 /*------------------------------------------------------------------------------
  *        Define test functions
@@ -58,6 +67,277 @@ int AESDecrypt1()
     END_TEST_CASE;
 }
 
+/* Test keyed AES context on many blocks against the one-shot block function */
+int AESCtx1()
+{
+    START_TEST_CASE;
+    BYTE key[] = "YELLOW SUBMARINE";
+    size_t n_blocks = 4;
+    BYTE *ptext = rand_byte(n_blocks*BLOCK_SIZE);
+    BYTE ctext[n_blocks*BLOCK_SIZE];
+    /*---------- Encrypt all blocks in one call ----------*/
+    AES_CTX *ctx = init_aes_ctx(key, 1);
+    SHOULD_BE(aes_128_encrypt_blocks(ctx, ctext, ptext, n_blocks) == 0);
+    free_aes_ctx(ctx);
+    /* Each block should match the one-shot encryption */
+    for (size_t i = 0; i < n_blocks; i++) {
+        BYTE *yi = NULL;
+        size_t yi_len = 0;
+        aes_128_ecb_block(&yi, &yi_len, ptext + i*BLOCK_SIZE, BLOCK_SIZE, key, 1);
+        SHOULD_BE(!memcmp(yi, ctext + i*BLOCK_SIZE, BLOCK_SIZE));
+        free(yi);
+    }
+    /*---------- Decrypt in-place, one block per call ----------*/
+    ctx = init_aes_ctx(key, 0);
+    for (size_t i = 0; i < n_blocks; i++) {
+        BYTE *p = ctext + i*BLOCK_SIZE;
+        SHOULD_BE(aes_128_decrypt_block(ctx, p, p) == 0);
+    }
+    free_aes_ctx(ctx);
+    SHOULD_BE(!memcmp(ptext, ctext, n_blocks*BLOCK_SIZE));
+    free(ptext);
+    END_TEST_CASE;
+}
+
+/* Every available backend against the FIPS-197 Appendix C.1 vector */
+int AESBackend1()
+{
+    START_TEST_CASE;
+    BYTE *key = NULL, *ptext = NULL, *expect = NULL;
+    hex2byte(&key,    "000102030405060708090a0b0c0d0e0f");
+    hex2byte(&ptext,  "00112233445566778899aabbccddeeff");
+    hex2byte(&expect, "69c4e0d86a7b0430d8cdb78070b4c55a");
+    for (int b = 0; b < AES_BACKEND_COUNT; b++) {
+        if (!aes_backend_available(b)) { continue; }
+        BYTE ctext[BLOCK_SIZE], dtext[BLOCK_SIZE];
+        AES_CTX *ctx = init_aes_ctx_backend(key, 1, b);
+        SHOULD_BE(ctx->backend == b);
+        aes_128_encrypt_block(ctx, ctext, ptext);
+        free_aes_ctx(ctx);
+        SHOULD_BE(!memcmp(ctext, expect, BLOCK_SIZE));
+        ctx = init_aes_ctx_backend(key, 0, b);
+        aes_128_decrypt_block(ctx, dtext, ctext);
+        free_aes_ctx(ctx);
+        SHOULD_BE(!memcmp(dtext, ptext, BLOCK_SIZE));
+    }
+    free(key);
+    free(ptext);
+    free(expect);
+    END_TEST_CASE;
+}
+
+/* Every available backend against OpenSSL on random keys and lengths, covering
+ * both the interleaved main loop and the single-block tail */
+int AESBackend2()
+{
+    START_TEST_CASE;
+    for (int trial = 0; trial < 64; trial++) {
+        size_t n_blocks = RAND_RANGE(1, 37);
+        size_t nbyte = n_blocks*BLOCK_SIZE;
+        BYTE *key = rand_byte(BLOCK_SIZE);
+        BYTE *ptext = rand_byte(nbyte);
+        BYTE expect[nbyte], ctext[nbyte];
+        AES_CTX *ref = init_aes_ctx_backend(key, 1, AES_BACKEND_OPENSSL);
+        aes_128_encrypt_blocks(ref, expect, ptext, n_blocks);
+        free_aes_ctx(ref);
+        for (int b = 0; b < AES_BACKEND_COUNT; b++) {
+            if (!aes_backend_available(b)) { continue; }
+            AES_CTX *ctx = init_aes_ctx_backend(key, 1, b);
+            aes_128_encrypt_blocks(ctx, ctext, ptext, n_blocks);
+            free_aes_ctx(ctx);
+            SHOULD_BE(!memcmp(ctext, expect, nbyte));
+            /* Decrypt in place */
+            ctx = init_aes_ctx_backend(key, 0, b);
+            aes_128_decrypt_blocks(ctx, ctext, ctext, n_blocks);
+            free_aes_ctx(ctx);
+            SHOULD_BE(!memcmp(ctext, ptext, nbyte));
+        }
+        free(key);
+        free(ptext);
+    }
+    END_TEST_CASE;
+}
+
+/* Fused decrypt+XOR on every backend matches decrypt followed by XOR */
+int AESDecryptXor1()
+{
+    START_TEST_CASE;
+    for (int trial = 0; trial < 16; trial++) {
+        size_t n_blocks = RAND_RANGE(1, 2*AES_XOR_CHUNK_BLOCKS + 9);
+        size_t nbyte = n_blocks*BLOCK_SIZE;
+        BYTE *key = rand_byte(BLOCK_SIZE);
+        BYTE *y = rand_byte(nbyte);
+        BYTE *mask = rand_byte(nbyte);
+        BYTE *expect = init_byte(nbyte),
+             *x = init_byte(nbyte);
+        AES_CTX *ref = init_aes_ctx_backend(key, 0, AES_BACKEND_OPENSSL);
+        aes_128_decrypt_blocks(ref, expect, y, n_blocks);
+        free_aes_ctx(ref);
+        for (size_t i = 0; i < nbyte; i++) { expect[i] ^= mask[i]; }
+        for (int b = 0; b < AES_BACKEND_COUNT; b++) {
+            if (!aes_backend_available(b)) { continue; }
+            AES_CTX *ctx = init_aes_ctx_backend(key, 0, b);
+            SHOULD_BE(aes_128_decrypt_blocks_xor(ctx, x, y, mask, n_blocks) == 0);
+            free_aes_ctx(ctx);
+            SHOULD_BE(!memcmp(x, expect, nbyte));
+        }
+        free(key);
+        free(y);
+        free(mask);
+        free(expect);
+        free(x);
+    }
+    END_TEST_CASE;
+}
+
+/* Known-answer test for the challenge key, default backend vs OpenSSL */
+int AESBackend3()
+{
+    START_TEST_CASE;
+    BYTE key[] = "YELLOW SUBMARINE";
+    BYTE ptext[] = "Firetruck races!";
+    BYTE y0[BLOCK_SIZE], y1[BLOCK_SIZE];
+    AES_CTX *ctx = init_aes_ctx(key, 1);
+    SHOULD_BE(ctx->backend == aes_default_backend());
+    aes_128_encrypt_block(ctx, y0, ptext);
+    free_aes_ctx(ctx);
+    ctx = init_aes_ctx_backend(key, 1, AES_BACKEND_OPENSSL);
+    aes_128_encrypt_block(ctx, y1, ptext);
+    free_aes_ctx(ctx);
+    SHOULD_BE(!memcmp(y0, y1, BLOCK_SIZE));
+    /* Forcing an available backend works, an unknown one does not */
+    AES_BACKEND orig = aes_default_backend();
+    SHOULD_BE(aes_set_default_backend(AES_BACKEND_OPENSSL) == 0);
+    SHOULD_BE(aes_default_backend() == AES_BACKEND_OPENSSL);
+    SHOULD_BE(aes_set_default_backend(AES_BACKEND_COUNT) == -1);
+    aes_set_default_backend(orig);
+#ifdef LOGSTATUS
+    printf("Default AES backend: %s\n", aes_backend_name(orig));
+#endif
+    END_TEST_CASE;
+}
+
+/* Context cache: repeat keys hit, a new key or direction misses, the least
+ * recently used schedule is evicted, and cached contexts still encrypt right */
+int AESCtxCache1()
+{
+    START_TEST_CASE;
+    BYTE key[AES_CTX_CACHE_SIZE + 1][BLOCK_SIZE];
+    BYTE ptext[] = "Firetruck races!";
+    BYTE y0[BLOCK_SIZE], y1[BLOCK_SIZE];
+    size_t hits = 0, misses = 0;
+    for (size_t i = 0; i <= AES_CTX_CACHE_SIZE; i++) {
+        memset(key[i], (int)i, BLOCK_SIZE);
+    }
+
+    aes_ctx_cache_flush();
+    AES_CTX *ctx = aes_ctx_acquire(key[0], 1);
+    aes_128_encrypt_block(ctx, y0, ptext);
+    aes_ctx_release(ctx);
+    ctx = aes_ctx_acquire(key[0], 1);       /* hit */
+    aes_128_encrypt_block(ctx, y1, ptext);
+    aes_ctx_release(ctx);
+    SHOULD_BE(!memcmp(y0, y1, BLOCK_SIZE));
+    aes_ctx_release(aes_ctx_acquire(key[0], 0));     /* other direction */
+    aes_ctx_cache_stats(&hits, &misses);
+    SHOULD_BE(hits == 1 && misses == 2);
+
+    /* Held contexts aren't handed out twice */
+    AES_CTX *a = aes_ctx_acquire(key[0], 1),
+            *b = aes_ctx_acquire(key[0], 1);
+    SHOULD_BE(a != b);
+    aes_ctx_release(a);
+    aes_ctx_release(b);
+
+    /* Filling the cache with new keys pushes out key[0] */
+    aes_ctx_cache_flush();
+    for (size_t i = 0; i <= AES_CTX_CACHE_SIZE; i++) {
+        aes_ctx_release(aes_ctx_acquire(key[i], 1));
+    }
+    aes_ctx_release(aes_ctx_acquire(key[AES_CTX_CACHE_SIZE], 1));
+    aes_ctx_release(aes_ctx_acquire(key[0], 1));
+    aes_ctx_cache_stats(&hits, &misses);
+    SHOULD_BE(hits == 1 && misses == AES_CTX_CACHE_SIZE + 2);
+
+    /* Switched off, nothing is kept */
+    aes_ctx_cache_enable(0);
+    aes_ctx_release(aes_ctx_acquire(key[1], 1));
+    aes_ctx_cache_stats(&hits, &misses);
+    SHOULD_BE(hits == 0 && misses == 0);
+    aes_ctx_cache_enable(1);
+    END_TEST_CASE;
+}
+
+/* Compare doubles for qsort */
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Bitsliced key schedule + batch encryption: time one fixed random key
+ * against fresh random keys in random order and check the two timing
+ * distributions are not grossly apart (fixed-vs-random Welch t-test, as in
+ * dudect, at the smoke bound above) */
+int AESBitsliceTiming()
+{
+    START_TEST_CASE;
+    size_t n = 2*TIMING_SAMPLES;
+    double *dt = malloc(n*sizeof(double)),
+           *sorted = malloc(n*sizeof(double));
+    int *cls = malloc(n*sizeof(int));
+    BYTE *keys = rand_byte(n*BLOCK_SIZE);
+    BYTE *x = rand_byte(BITSLICE_BLOCKS*BLOCK_SIZE);
+    BYTE y[BITSLICE_BLOCKS*BLOCK_SIZE];
+    BYTE *fixed = rand_byte(BLOCK_SIZE);
+    uint64_t rk[BITSLICE_RK_WORDS];
+    /* Class 0 uses the fixed key */
+    for (size_t i = 0; i < n; i++) {
+        cls[i] = rand() & 1;
+        if (!cls[i]) { memcpy(keys + i*BLOCK_SIZE, fixed, BLOCK_SIZE); }
+    }
+    for (size_t i = 0; i < n; i++) {
+        double t0, t1;
+        BENCH_NOW(t0);
+        bitslice_expand_key(rk, keys + i*BLOCK_SIZE);
+        bitslice_encrypt_blocks(rk, y, x, BITSLICE_BLOCKS);
+        BENCH_NOW(t1);
+        dt[i] = t1 - t0;
+    }
+    /* Crop the slowest 10% -- interrupts and page faults, not the cipher */
+    memcpy(sorted, dt, n*sizeof(double));
+    qsort(sorted, n, sizeof(double), cmp_double);
+    double crop = sorted[(size_t)(0.9*n)];
+    double sum[2] = {0}, sum2[2] = {0};
+    size_t cnt[2] = {0};
+    for (size_t i = 0; i < n; i++) {
+        if (dt[i] > crop) { continue; }
+        sum[cls[i]]  += dt[i];
+        sum2[cls[i]] += dt[i]*dt[i];
+        cnt[cls[i]]++;
+    }
+    double mean[2], var[2];
+    for (int c = 0; c < 2; c++) {
+        mean[c] = sum[c] / cnt[c];
+        var[c]  = (sum2[c] - cnt[c]*mean[c]*mean[c]) / (cnt[c] - 1);
+    }
+    double t = (mean[0] - mean[1]) / sqrt(var[0]/cnt[0] + var[1]/cnt[1]);
+    SHOULD_BE(cnt[0] > 100 && cnt[1] > 100);
+    SHOULD_BE(fabs(t) < TIMING_MAX_T);
+#ifdef LOGSTATUS
+    printf("fixed key:  %zu samples, mean %.3f us\n", cnt[0], 1e6*mean[0]);
+    printf("random key: %zu samples, mean %.3f us\n", cnt[1], 1e6*mean[1]);
+    printf("Welch t = %.2f\n", t);
+#endif
+    free(dt);
+    free(sorted);
+    free(cls);
+    free(keys);
+    free(fixed);
+    free(x);
+    END_TEST_CASE;
+}
+
 /*------------------------------------------------------------------------------
  *        Run tests
  *----------------------------------------------------------------------------*/
@@ -67,6 +347,13 @@ int main(void)
     int total = 0;
 
     RUN_TEST(AESDecrypt1,    "aes_128_ecb_block() ");
+    RUN_TEST(AESCtx1,        "AES_CTX blocks      ");
+    RUN_TEST(AESBackend1,    "AES backends FIPS197");
+    RUN_TEST(AESBackend2,    "AES backends random ");
+    RUN_TEST(AESDecryptXor1, "AES decrypt + XOR   ");
+    RUN_TEST(AESBackend3,    "AES default backend ");
+    RUN_TEST(AESCtxCache1,   "AES context cache   ");
+    RUN_TEST(AESBitsliceTiming, "bitslice time smoke ");
 
     /* Count errors */
     if (!fails) {
@@ -0,0 +1,299 @@
+/*==============================================================================
+ *     File: test_util_base64.c
+ *  Created: 10/17/2026, 18:52
+ *   Author: Bernie Roesler
+ *
+ *  Description: Test the base64 kernels, vector paths against scalar
+ *
+ *============================================================================*/
+
+/* User-defined headers */
+#include "header.h"
+#include "crypto_util.h"
+#include "unit_test.h"
+
+/* Long enough for several AVX2 iterations plus a scalar tail */
+#define MAX_TEST_LEN 300
+
+/* Tests run from src/util/ */
+#define DATA_PATH "../../data/"
+
+static const char ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Reference encoder, one bit at a time */
+static size_t encode_ref(char *b64, const BYTE *byte, size_t nbyte)
+{
+    size_t n = 0;
+    for (size_t bit = 0; bit < 8*nbyte; bit += 6) {
+        int v = 0;
+        for (int j = 0; j < 6; j++) {
+            size_t k = bit + j;
+            int b = (k < 8*nbyte) ? (byte[k/8] >> (7 - k%8)) & 1 : 0;
+            v = (v << 1) | b;
+        }
+        b64[n++] = ALPHABET[v];
+    }
+    while (n % 4) { b64[n++] = '='; }
+    b64[n] = '\0';
+    return n;
+}
+
+/*------------------------------------------------------------------------------
+ *        Define test functions
+ *----------------------------------------------------------------------------*/
+int Encode1()
+{
+    START_TEST_CASE;
+    char out[9];
+    SHOULD_BE(b64_encode(out, (BYTE *)"Man", 3) == 4);
+    SHOULD_BE(!strcmp(out, "TWFu"));
+    SHOULD_BE(b64_encode(out, (BYTE *)"Ma", 2) == 4);
+    SHOULD_BE(!strcmp(out, "TWE="));
+    SHOULD_BE(b64_encode(out, (BYTE *)"M", 1) == 4);
+    SHOULD_BE(!strcmp(out, "TQ=="));
+    SHOULD_BE(b64_encode(out, (BYTE *)"", 0) == 0);
+    SHOULD_BE(!strcmp(out, ""));
+    END_TEST_CASE;
+}
+
+/* Every length, exactly B64_ENCODE_LEN + 1 chars written */
+int EncodeRandom1()
+{
+    START_TEST_CASE;
+    char ref[B64_ENCODE_LEN(MAX_TEST_LEN) + 1],
+         out[B64_ENCODE_LEN(MAX_TEST_LEN) + 2];
+
+    for (size_t n = 0; n <= MAX_TEST_LEN; n++) {
+        BYTE *x = rand_byte(n);
+        size_t nchar = encode_ref(ref, x, n);
+        SHOULD_BE(nchar == B64_ENCODE_LEN(n));
+
+        memset(out, '#', sizeof(out));
+        SHOULD_BE(b64_encode(out, x, n) == nchar);
+        SHOULD_BE(!strcmp(out, ref));
+        SHOULD_BE(out[nchar + 1] == '#');
+
+        memset(out, '#', sizeof(out));
+        SHOULD_BE(b64_encode_scalar(out, x, n) == nchar);
+        SHOULD_BE(!strcmp(out, ref));
+        SHOULD_BE(out[nchar + 1] == '#');
+        free(x);
+    }
+    END_TEST_CASE;
+}
+
+/* Decoding a data file and wrapping it again gives back the file */
+static int rewrap(const char *filename)
+{
+    char *text = NULL;
+    size_t n_text = file2str(&text, filename);
+
+    /* Strip the newlines */
+    char *b64 = init_str(n_text);
+    size_t nchar = 0;
+    for (size_t i = 0; i < n_text; i++) {
+        if (text[i] != '\n') { b64[nchar++] = text[i]; }
+    }
+
+    BYTE *byte = init_byte(3*nchar/4);
+    ssize_t nbyte = b64_decode(byte, b64, nchar);
+
+    char *wrap = init_str(B64_WRAP_LEN(nbyte, B64_WIDTH_DATA));
+    ssize_t n_wrap = b64_encode_wrap(wrap, byte, nbyte, B64_WIDTH_DATA);
+    int same = (nbyte > 0) && (n_wrap == (ssize_t)n_text)
+               && !strcmp(wrap, text);
+
+    free(text);
+    free(b64);
+    free(byte);
+    free(wrap);
+    return same;
+}
+
+int EncodeWrap1()
+{
+    START_TEST_CASE;
+    SHOULD_BE(rewrap(DATA_PATH "6.txt"));
+    SHOULD_BE(rewrap(DATA_PATH "7.txt"));
+    SHOULD_BE(rewrap(DATA_PATH "10.txt"));
+
+    /* 57 bytes is exactly one MIME line; one more starts another */
+    BYTE x[58] = {0};
+    char out[B64_WRAP_LEN(58, B64_WIDTH_MIME)];
+    SHOULD_BE(b64_encode_wrap(out, x, 57, B64_WIDTH_MIME) == 77);
+    SHOULD_BE(out[76] == '\n' && out[77] == '\0');
+    SHOULD_BE(b64_encode_wrap(out, x, 58, B64_WIDTH_MIME) == 82);
+    SHOULD_BE(!strcmp(out + 77, "AA==\n"));
+    SHOULD_BE(sizeof(out) == 83);
+    SHOULD_BE(b64_encode_wrap(out, x, 0, B64_WIDTH_MIME) == 0);
+    SHOULD_BE(b64_encode_wrap(out, x, 58, 0) == B64_ELEN);
+
+    /* Lines need not be whole groups */
+    SHOULD_BE(b64_encode_wrap(out, (BYTE *)"Man", 3, 3) == 6);
+    SHOULD_BE(!strcmp(out, "TWF\nu\n"));
+    END_TEST_CASE;
+}
+
+int Decode1()
+{
+    START_TEST_CASE;
+    BYTE out[4];
+    SHOULD_BE(b64_decode(out, "TWFu", 4) == 3);
+    SHOULD_BE(!memcmp(out, "Man", 3));
+    SHOULD_BE(b64_decode(out, "TWE=", 4) == 2);
+    SHOULD_BE(!memcmp(out, "Ma", 2));
+    SHOULD_BE(b64_decode(out, "TQ==", 4) == 1);
+    SHOULD_BE(out[0] == 'M');
+    SHOULD_BE(b64_decode(out, "", 0) == 0);
+    END_TEST_CASE;
+}
+
+/* Every length, so each path ends at every offset */
+int DecodeRandom1()
+{
+    START_TEST_CASE;
+    char b64[4*MAX_TEST_LEN/3 + 5];
+    BYTE out[MAX_TEST_LEN + 3],
+         ref[MAX_TEST_LEN + 3];
+
+    for (size_t n = 0; n <= MAX_TEST_LEN; n++) {
+        BYTE *x = rand_byte(n);
+        size_t nchar = encode_ref(b64, x, n);
+
+        SHOULD_BE(b64_decode(out, b64, nchar) == (ssize_t)n);
+        SHOULD_BE(!memcmp(out, x, n));
+        SHOULD_BE(b64_decode_scalar(ref, b64, nchar) == (ssize_t)n);
+        SHOULD_BE(!memcmp(ref, x, n));
+        free(x);
+    }
+    END_TEST_CASE;
+}
+
+/* Each error is caught wherever it falls */
+int DecodeErrors1()
+{
+    START_TEST_CASE;
+    char b64[4*MAX_TEST_LEN/3 + 5];
+    BYTE out[MAX_TEST_LEN + 3];
+    BYTE *x = rand_byte(MAX_TEST_LEN);
+    size_t nchar = encode_ref(b64, x, MAX_TEST_LEN);
+
+    SHOULD_BE(b64_decode(out, b64, nchar - 1) == B64_ELEN);
+    SHOULD_BE(b64_decode_scalar(out, b64, nchar - 2) == B64_ELEN);
+
+    const char bad[] = { '\0', ' ', '\n', '-', '_', '.', ':', '@', '[', '`',
+                         '{', 0x7F, 0x80, 0xAB, 0xFF };
+    for (size_t i = 0; i < nchar; i++) {
+        char c = b64[i];
+        for (size_t k = 0; k < sizeof(bad); k++) {
+            b64[i] = bad[k];
+            SHOULD_BE(b64_decode(out, b64, nchar) == B64_ECHAR);
+            SHOULD_BE(b64_decode_scalar(out, b64, nchar) == B64_ECHAR);
+        }
+
+        /* '=' is only valid as the last one or two characters */
+        b64[i] = '=';
+        if (i < nchar - 2) {
+            SHOULD_BE(b64_decode(out, b64, nchar) == B64_EPAD);
+            SHOULD_BE(b64_decode_scalar(out, b64, nchar) == B64_EPAD);
+        }
+        b64[i] = c;
+    }
+
+    SHOULD_BE(b64_decode(out, "TW=u", 4) == B64_EPAD);
+    SHOULD_BE(b64_decode(out, "T===", 4) == B64_EPAD);
+    SHOULD_BE(b64_decode(out, "TQ==TWFu", 8) == B64_EPAD);
+    free(x);
+    END_TEST_CASE;
+}
+
+/* Padding split across lines, and nothing after it */
+int DecodeStream1()
+{
+    START_TEST_CASE;
+    B64_STREAM s;
+    BYTE out[B64_STREAM_LEN(16)];
+
+    b64_stream_init(&s);
+    SHOULD_BE(b64_stream_update(&s, out, "TWFu\r\nTQ=", 9) == 3);
+    SHOULD_BE(b64_stream_update(&s, out + 3, "\n=\n", 3) == 1);
+    SHOULD_BE(b64_stream_final(&s) == 0);
+    SHOULD_BE(!memcmp(out, "ManM", 4));
+    SHOULD_BE(b64_stream_update(&s, out, " \t\n", 3) == 0);
+    SHOULD_BE(b64_stream_update(&s, out, "TWFu", 4) == B64_EPAD);
+
+    b64_stream_init(&s);
+    SHOULD_BE(b64_stream_update(&s, out, "TQ==\nTWFu", 9) == B64_EPAD);
+    b64_stream_init(&s);
+    SHOULD_BE(b64_stream_update(&s, out, "TW\n=u", 5) == B64_EPAD);
+    END_TEST_CASE;
+}
+
+/* Stop after the first chunk */
+static int emit_stop(void *arg, const BYTE *byte, size_t nbyte)
+{
+    (void)arg; (void)byte; (void)nbyte;
+    return 1;
+}
+
+/* A file decodes the same streamed as whole, and errors come back */
+int DecodeFile1()
+{
+    START_TEST_CASE;
+    char *text = NULL;
+    size_t n_text = file2str(&text, DATA_PATH "6.txt");
+    BYTE *ref = init_byte(B64_STREAM_LEN(n_text));
+    B64_STREAM s;
+    b64_stream_init(&s);
+    ssize_t n_ref = b64_stream_update(&s, ref, text, n_text);
+    SHOULD_BE(n_ref > 0 && b64_stream_final(&s) == 0);
+
+    BYTE *byte = NULL;
+    SHOULD_BE(b64_file2byte(&byte, DATA_PATH "6.txt") == n_ref);
+    SHOULD_BE(!memcmp(byte, ref, n_ref));
+
+    FILE *fp = fopen(DATA_PATH "6.txt", "r");
+    SHOULD_BE(b64_decode_file(fp, emit_stop, NULL) == B64_ESTOP);
+    fclose(fp);
+
+    /* Not base64 at all */
+    BYTE *bad = NULL;
+    SHOULD_BE(b64_file2byte(&bad, DATA_PATH "play_that_funky_music.txt") < 0);
+    SHOULD_BE(bad == NULL);
+
+    free(text);
+    free(ref);
+    free(byte);
+    END_TEST_CASE;
+}
+
+/*------------------------------------------------------------------------------
+ *        Run tests
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    int fails = 0;
+    int total = 0;
+
+    RUN_TEST(Encode1,        "b64_encode()        ");
+    RUN_TEST(EncodeRandom1,  "b64_encode() random ");
+    RUN_TEST(EncodeWrap1,    "b64_encode_wrap()   ");
+    RUN_TEST(Decode1,        "b64_decode()        ");
+    RUN_TEST(DecodeRandom1,  "b64_decode() random ");
+    RUN_TEST(DecodeErrors1,  "b64_decode() errors ");
+    RUN_TEST(DecodeStream1,  "b64_stream_update() ");
+    RUN_TEST(DecodeFile1,    "b64_decode_file()   ");
+
+    /* Count errors */
+    if (!fails) {
+        printf("\033[0;32mAll %d tests passed!\033[0m\n", total); 
+        return 0;
+    } else {
+        printf("\033[0;31m%d/%d tests failed!\033[0m\n", fails, total);
+        return 1;
+    }
+}
+
+/*==============================================================================
+ *============================================================================*/
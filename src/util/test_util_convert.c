@@ -65,6 +65,60 @@ int HexConvert1()
     END_TEST_CASE;
 }
 
+int HexInto1()
+{
+    START_TEST_CASE;
+    BYTE byte1[] = "Man";
+    char hex[BYTE2HEX_LEN(3)];
+    SHOULD_BE(byte2hex_into(hex, byte1, 3) == 6);
+    SHOULD_BE(!strcasecmp(hex, "4d616e"));
+    BYTE byte2[HEX2BYTE_LEN(6)];
+    SHOULD_BE(hex2byte_into(byte2, hex, 6) == 3);
+    SHOULD_BE(!memcmp(byte2, byte1, 3));
+    /* odd length and bad characters are errors, not exits */
+    SHOULD_BE(hex2byte_into(byte2, hex, 5) == -1);
+    SHOULD_BE(hex2byte_into(byte2, "4d6g6e", 6) == -1);
+    END_TEST_CASE;
+}
+
+/* Every length against printf, so the vector loop ends at every offset, and
+ * a bad character anywhere is caught */
+int HexInto2()
+{
+    START_TEST_CASE;
+    char hex[BYTE2HEX_LEN(100)],
+         ref[BYTE2HEX_LEN(100)];
+    BYTE out[100];
+
+    for (size_t n = 0; n <= 100; n++) {
+        BYTE *x = rand_byte(n);
+        for (size_t i = 0; i < n; i++) { sprintf(ref + 2*i, "%02x", x[i]); }
+        ref[2*n] = '\0';
+
+        SHOULD_BE(byte2hex_lower_into(hex, x, n) == (ssize_t)(2*n));
+        SHOULD_BE(!strcmp(hex, ref));
+        SHOULD_BE(hex2byte_into(out, hex, 2*n) == (ssize_t)n);
+        SHOULD_BE(!memcmp(out, x, n));
+
+        SHOULD_BE(byte2hex_into(hex, x, n) == (ssize_t)(2*n));
+        SHOULD_BE(!strcmp(hex, strtoupper(ref)));
+        SHOULD_BE(hex2byte_into(out, hex, 2*n) == (ssize_t)n);
+        SHOULD_BE(!memcmp(out, x, n));
+        free(x);
+    }
+
+    const char bad[] = { '/', ':', '@', 'G', '`', 'g', ' ', 0x80, 0xC6 };
+    for (size_t i = 0; i < 200; i++) {
+        char c = hex[i];
+        for (size_t k = 0; k < sizeof(bad); k++) {
+            hex[i] = bad[k];
+            SHOULD_BE(hex2byte_into(out, hex, 200) == -1);
+        }
+        hex[i] = c;
+    }
+    END_TEST_CASE;
+}
+
 /*------------------------------------------------------------------------------
  *        Run tests
  *----------------------------------------------------------------------------*/
@@ -76,6 +130,8 @@ int main(void)
     RUN_TEST(StrToUpper1,    "strtoupper()   ");
     RUN_TEST(GetHexByte1,    "get_hex_byte() ");
     RUN_TEST(HexConvert1,    "atoh(),htoa()  ");
+    RUN_TEST(HexInto1,       "hex2byte_into()");
+    RUN_TEST(HexInto2,       "byte2hex_into()");
 
     /* Count errors */
     if (!fails) {
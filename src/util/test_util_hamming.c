@@ -0,0 +1,121 @@
+/*==============================================================================
+ *     File: test_util_hamming.c
+ *  Created: 10/17/2026, 23:50
+ *   Author: Bernie Roesler
+ *
+ *  Description: Test the popcount kernels against byte-at-a-time counts
+ *
+ *============================================================================*/
+
+/* User-defined headers */
+#include "header.h"
+#include "crypto_util.h"
+#include "unit_test.h"
+
+/* Ends inside the third chunk */
+#define N_BYTES (2*HAMMING_CHUNK + 77)
+#define N_SHIFT 70
+
+static size_t bits(BYTE x)
+{
+    size_t n = 0;
+    for (; x; x >>= 1) { n += x & 1; }
+    return n;
+}
+
+/* Text-like bytes, so that equal pairs are common */
+static BYTE *rand_text(size_t nbyte)
+{
+    BYTE *byte = init_byte(nbyte);
+    for (size_t i = 0; i < nbyte; i++) { byte[i] = 'a' + rand() % 8; }
+    return byte;
+}
+
+/*------------------------------------------------------------------------------
+ *        Define test functions
+ *----------------------------------------------------------------------------*/
+/* Every length through a few vector widths, at odd alignments */
+int HammingXOR1()
+{
+    START_TEST_CASE;
+    BYTE *a = rand_byte(200),
+         *b = rand_byte(200);
+    for (size_t n = 0; n < 150; n++) {
+        size_t ref = 0;
+        for (size_t i = 0; i < n; i++) { ref += bits(a[i+3] ^ b[i+1]); }
+        SHOULD_BE(hamming_xor(a + 3, b + 1, n) == ref);
+    }
+    free(a);
+    free(b);
+    END_TEST_CASE;
+}
+
+/* Every shift against pairwise counts, across chunk boundaries */
+int Autocorr1()
+{
+    START_TEST_CASE;
+    BYTE *byte = rand_text(N_BYTES);
+    uint64_t dist[N_SHIFT + 1],
+             same[N_SHIFT + 1],
+             ref[N_SHIFT + 1];
+
+    hamming_autocorr(dist, byte, N_BYTES, N_SHIFT);
+    coincidence_autocorr(same, byte, N_BYTES, N_SHIFT);
+    SHOULD_BE(dist[0] == 0 && same[0] == 0);
+    for (size_t s = 1; s <= N_SHIFT; s++) {
+        uint64_t d = 0, e = 0;
+        for (size_t i = 0; i + s < N_BYTES; i++) {
+            d += bits(byte[i] ^ byte[i+s]);
+            e += (byte[i] == byte[i+s]);
+        }
+        SHOULD_BE(dist[s] == d);
+        SHOULD_BE(same[s] == e);
+    }
+
+    hamming_autocorr_scalar(ref, byte, N_BYTES, N_SHIFT);
+    SHOULD_BE(!memcmp(ref, dist, sizeof(dist)));
+    coincidence_autocorr_scalar(ref, byte, N_BYTES, N_SHIFT);
+    SHOULD_BE(!memcmp(ref, same, sizeof(same)));
+    free(byte);
+    END_TEST_CASE;
+}
+
+/* Shifts at and past the end of a short input pair nothing */
+int Autocorr2()
+{
+    START_TEST_CASE;
+    BYTE byte[] = "abcabca";
+    uint64_t same[10];
+    coincidence_autocorr(same, byte, 7, 9);
+    SHOULD_BE(same[3] == 4);
+    SHOULD_BE(same[6] == 1);
+    SHOULD_BE(same[1] == 0 && same[7] == 0 && same[9] == 0);
+    END_TEST_CASE;
+}
+
+/*------------------------------------------------------------------------------
+ *        Run tests
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    int fails = 0;
+    int total = 0;
+
+    srand(56);
+
+    RUN_TEST(HammingXOR1,    "hamming_xor()       ");
+    RUN_TEST(Autocorr1,      "*_autocorr() chunks ");
+    RUN_TEST(Autocorr2,      "*_autocorr() short  ");
+
+    /* Count errors */
+    if (!fails) {
+        printf("\033[0;32mAll %d tests passed!\033[0m\n", total);
+        return 0;
+    } else {
+        printf("\033[0;31m%d/%d tests failed!\033[0m\n", fails, total);
+        return 1;
+    }
+}
+
+/*==============================================================================
+ *============================================================================*/
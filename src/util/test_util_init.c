@@ -7,6 +7,8 @@
  *
  *============================================================================*/
 
+#include <stdint.h>
+
 /* User-defined headers */
 #include "header.h"
 #include "crypto_util.h"
@@ -54,6 +56,45 @@ int Strnrepeat1()
     END_TEST_CASE;
 }
 
+/* Push/pop reuses memory, spills into new chunks, and honours the flags */
+int Arena1()
+{
+    START_TEST_CASE;
+    ARENA *a = init_arena(64, ARENA_ZERO | ARENA_POISON);
+    ARENA_MARK m0 = arena_push(a);
+
+    BYTE *x = arena_byte(a, 10);
+    SHOULD_BE((uintptr_t)x % ARENA_ALIGN == 0);
+    SHOULD_BE(x[0] == 0 && x[10] == 0);
+    memset(x, 'x', 10);
+
+    /* one iteration's temporaries come back at the same address */
+    for (int i = 0; i < 3; i++) {
+        ARENA_MARK m = arena_push(a);
+        char *s = arena_str(a, 5);
+        SHOULD_BE(s[5] == '\0' && s[0] == '\0');
+        strcpy(s, "hello");
+        arena_pop(a, m);
+        SHOULD_BE(arena_push(a).used == m.used);
+    }
+
+    /* overflow the first chunk, then pop back into it */
+    ARENA_MARK m1 = arena_push(a);
+    int *n = arena_int(a, 100);
+    SHOULD_BE(a->n_chunk == 2 && n[99] == 0);
+    BYTE *r = arena_rand_byte(a, 8);
+    SHOULD_BE(r[8] == 0);
+    arena_pop(a, m1);
+    SHOULD_BE(a->head == m1.chunk);
+    SHOULD_BE(!memcmp(x, "xxxxxxxxxx", 10));
+
+    arena_pop(a, m0);
+    SHOULD_BE(a->head->used == 0);
+    SHOULD_BE(a->n_alloc == 6);
+    free_arena(a);
+    END_TEST_CASE;
+}
+
 /*------------------------------------------------------------------------------
  *        Run tests
  *----------------------------------------------------------------------------*/
@@ -64,6 +105,7 @@ int main(void)
 
     RUN_TEST(StrArray1,      "init_str_arr()      ");
     RUN_TEST(Strnrepeat1,    "strnrepeat_hex()    ");
+    RUN_TEST(Arena1,         "arena_push(),pop()  ");
 
     /* Count errors */
     if (!fails) {
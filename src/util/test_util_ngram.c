@@ -0,0 +1,152 @@
+/*==============================================================================
+ *     File: test_util_ngram.c
+ *  Created: 10/17/2026, 22:50
+ *   Author: Bernie Roesler
+ *
+ *  Description: Test n-gram training, loading and scoring
+ *
+ *============================================================================*/
+#include <float.h>
+
+/* User-defined headers */
+#include "header.h"
+#include "crypto_util.h"
+#include "unit_test.h"
+
+/* Tests run from src/util/ */
+#define DATA_PATH "../../data/"
+
+/* Shuffle bytes in place */
+static void shuffle(BYTE *byte, size_t nbyte)
+{
+    for (size_t i = nbyte - 1; i > 0; i--) {
+        size_t j = rand() % (i + 1);
+        BYTE t = byte[i];
+        byte[i] = byte[j];
+        byte[j] = t;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *        Define test functions
+ *----------------------------------------------------------------------------*/
+/* Train and load every order. The AVX2 path gives exactly the scalar score,
+ * scoring byte ^ key is scoring the XOR-ed bytes, and English beats the
+ * same bytes shuffled once context counts. */
+int NGram1()
+{
+    START_TEST_CASE;
+    char *text = NULL;
+    size_t n_text = file2str(&text, DATA_PATH "play_that_funky_music.txt");
+
+    char path[] = "/tmp/test_ngram.XXXXXX";
+    int fd = mkstemp(path);
+    SHOULD_BE(fd >= 0);
+    SHOULD_BE(ngram_train(path, (BYTE *)text, n_text) == 0);
+
+    BYTE *y = init_byte(n_text),
+         *z = init_byte(n_text);
+    for (int order = 1; order <= NGRAM_MAX_ORDER; order++) {
+        NGRAM *m = ngram_load(path, order);
+        SHOULD_BE(m != NULL);
+        if (!m) { continue; }
+
+        size_t lens[] = { 1, 2, 3, 8, 15, 16, 17, 23, 64, 301, n_text };
+        for (size_t i = 0; i < sizeof(lens)/sizeof(lens[0]); i++) {
+            size_t n = lens[i];
+            BYTE key = (BYTE)(rand() % 256);
+            xor_repeat(y, (BYTE *)text, n, &key, 1, 0);
+            float s = ngram_score_scalar(m, (BYTE *)text, n);
+            SHOULD_BE(ngram_score(m, (BYTE *)text, n) == s);
+            SHOULD_BE(ngram_score_xor(m, y, n, key) == s);
+        }
+
+        memcpy(z, text, n_text);
+        shuffle(z, n_text);
+        if (order > 1) {
+            SHOULD_BE(ngram_score(m, (BYTE *)text, n_text)
+                    < ngram_score(m, z, n_text));
+        }
+        ngram_free(m);
+    }
+
+    close(fd);
+    remove(path);
+    free(text);
+    free(y);
+    free(z);
+    END_TEST_CASE;
+}
+
+/* The shipped model loads and prefers English; bad files, including ones
+ * with byte classes out of range, do not load */
+int NGram2()
+{
+    START_TEST_CASE;
+    NGRAM *m = ngram_load(DATA_PATH "english.ngram", NGRAM_MAX_ORDER);
+    SHOULD_BE(m != NULL);
+    if (m) {
+        const char *good = "Now that the party is jumping",
+                   *bad  = "Nwo tath hte ptary si jpmugin";
+        SHOULD_BE(ngram_score(m, (BYTE *)good, strlen(good))
+                < ngram_score(m, (BYTE *)bad, strlen(bad)));
+        SHOULD_BE(ngram_score(m, (BYTE *)good, 0) == FLT_MAX);
+        ngram_free(m);
+    }
+
+    SHOULD_BE(ngram_load(DATA_PATH "no_such_file.ngram", 1) == NULL);
+    SHOULD_BE(ngram_load(DATA_PATH "6.txt", 1) == NULL);
+
+    /* Right size, wrong magic */
+    char path[] = "/tmp/test_ngram.XXXXXX";
+    int fd = mkstemp(path);
+    SHOULD_BE(fd >= 0);
+    SHOULD_BE(ngram_train(path, (BYTE *)"abc", 3) == 0);
+    FILE *fp = fopen(path, "r+b");
+    SHOULD_BE(fp != NULL);
+    SHOULD_BE(fputc('X', fp) == 'X');
+    fclose(fp);
+    SHOULD_BE(ngram_load(path, 1) == NULL);
+
+    /* Right header, a byte class past the tables */
+    SHOULD_BE(ngram_train(path, (BYTE *)"abc", 3) == 0);
+    m = ngram_load(path, 1);
+    SHOULD_BE(m != NULL);
+    ngram_free(m);
+    fp = fopen(path, "r+b");
+    SHOULD_BE(fp != NULL);
+    SHOULD_BE(fseek(fp, sizeof(NGRAM_HEADER) + 'z', SEEK_SET) == 0);
+    SHOULD_BE(fputc(NGRAM_SYMS, fp) == NGRAM_SYMS);
+    fclose(fp);
+    SHOULD_BE(ngram_load(path, 1) == NULL);
+
+    close(fd);
+    remove(path);
+    END_TEST_CASE;
+}
+
+/*------------------------------------------------------------------------------
+ *        Run tests
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    int fails = 0;
+    int total = 0;
+
+    srand(56);
+
+    RUN_TEST(NGram1,         "ngram_score() orders");
+    RUN_TEST(NGram2,         "ngram_load() files  ");
+
+    /* Count errors */
+    if (!fails) {
+        printf("\033[0;32mAll %d tests passed!\033[0m\n", total);
+        return 0;
+    } else {
+        printf("\033[0;31m%d/%d tests failed!\033[0m\n", fails, total);
+        return 1;
+    }
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -47,6 +47,25 @@ int FindFreq1()
     END_TEST_CASE;
 }
 
+/* Byte histogram, all 256 values */
+int CountBytes1()
+{
+    START_TEST_CASE;
+    BYTE str1[] = "HelLo, World!\xff";
+    size_t hist[NUM_BYTES];
+    count_bytes(hist, str1, sizeof(str1));  /* with the NUL */
+    SHOULD_BE(hist['l'] == 2);
+    SHOULD_BE(hist['L'] == 1);
+    SHOULD_BE(hist['o'] == 2);
+    SHOULD_BE(hist[0xff] == 1);
+    SHOULD_BE(hist['\0'] == 1);
+    SHOULD_BE(hist['x'] == 0);
+    size_t total = 0;
+    for (int b = 0; b < NUM_BYTES; b++) { total += hist[b]; }
+    SHOULD_BE(total == sizeof(str1));
+    END_TEST_CASE;
+}
+
 /* Test Hamming weight function */
 int HammingWeight1()
 {
@@ -125,6 +144,7 @@ int main(void)
 
     RUN_TEST(IndexOf1,       "indexof()      ");
     RUN_TEST(FindFreq1,      "count_chars()  ");
+    RUN_TEST(CountBytes1,    "count_bytes()  ");
     RUN_TEST(HammingWeight1, "hamming_dist() ");
     RUN_TEST(Strrmchr1,      "strrmchr()     ");
     RUN_TEST(Strescchr1,     "strescchr() 1  ");
@@ -0,0 +1,102 @@
+/*==============================================================================
+ *     File: test_util_topk.c
+ *  Created: 10/17/2026, 21:40
+ *   Author: Bernie Roesler
+ *
+ *  Description: Test the bounded top-k heap against a sort
+ *
+ *============================================================================*/
+#include <math.h>
+
+/* User-defined headers */
+#include "header.h"
+#include "crypto_util.h"
+#include "unit_test.h"
+
+#define N_ITEMS 200
+
+/* Best first: lower score, then lower value */
+static int cmp_item(const void *a, const void *b)
+{
+    const TOPK_ITEM *x = a, *y = b;
+    if (x->score != y->score) { return (x->score < y->score) ? -1 : 1; }
+    return (x->value > y->value) - (x->value < y->value);
+}
+
+/*------------------------------------------------------------------------------
+ *        Define test functions
+ *----------------------------------------------------------------------------*/
+/* Every k, random scores with plenty of ties */
+int TopK1()
+{
+    START_TEST_CASE;
+    TOPK_ITEM all[N_ITEMS];
+    for (size_t i = 0; i < N_ITEMS; i++) {
+        all[i].score = (float)(rand() % 50);
+        all[i].value = i;
+    }
+
+    for (size_t k = 1; k <= TOPK_MAX; k++) {
+        TOPK top;
+        topk_init(&top, k);
+        for (size_t i = 0; i < N_ITEMS; i++) {
+            topk_push(&top, all[i].score, all[i].value);
+        }
+        SHOULD_BE(topk_sort(&top) == k);
+
+        TOPK_ITEM ref[N_ITEMS];
+        memcpy(ref, all, sizeof(all));
+        qsort(ref, N_ITEMS, sizeof(TOPK_ITEM), cmp_item);
+        for (size_t i = 0; i < k; i++) {
+            SHOULD_BE(top.item[i].score == ref[i].score);
+            SHOULD_BE(top.item[i].value == ref[i].value);
+        }
+    }
+    END_TEST_CASE;
+}
+
+/* Fewer pushes than k, and NaN dropped */
+int TopK2()
+{
+    START_TEST_CASE;
+    TOPK top;
+    topk_init(&top, 5);
+    topk_push(&top, 3.0, 30);
+    topk_push(&top, NAN, 99);
+    topk_push(&top, 1.0, 10);
+    topk_push(&top, 2.0, 20);
+    SHOULD_BE(topk_sort(&top) == 3);
+    SHOULD_BE(top.item[0].value == 10);
+    SHOULD_BE(top.item[1].value == 20);
+    SHOULD_BE(top.item[2].value == 30);
+
+    topk_init(&top, 1);
+    SHOULD_BE(topk_sort(&top) == 0);
+    END_TEST_CASE;
+}
+
+/*------------------------------------------------------------------------------
+ *        Run tests
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    int fails = 0;
+    int total = 0;
+
+    srand(56);
+
+    RUN_TEST(TopK1,          "topk_push() random  ");
+    RUN_TEST(TopK2,          "topk_push() few     ");
+
+    /* Count errors */
+    if (!fails) {
+        printf("\033[0;32mAll %d tests passed!\033[0m\n", total); 
+        return 0;
+    } else {
+        printf("\033[0;31m%d/%d tests failed!\033[0m\n", fails, total);
+        return 1;
+    }
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,162 @@
+/*==============================================================================
+ *     File: test_util_xor.c
+ *  Created: 10/17/2026, 20:31
+ *   Author: Bernie Roesler
+ *
+ *  Description: Test the wide XOR kernels against a byte loop
+ *
+ *============================================================================*/
+
+/* User-defined headers */
+#include "header.h"
+#include "crypto_util.h"
+#include "unit_test.h"
+
+/* Long enough for several wide iterations plus every tail */
+#define MAX_TEST_LEN 300
+
+/* Longest key tried, past both the window and the segment code */
+#define MAX_KEY_LEN 100
+
+/* Reference repeating-key XOR, one byte at a time */
+static void repeat_ref(BYTE *dst, const BYTE *src, size_t nbyte,
+        const BYTE *key, size_t key_len, size_t phase)
+{
+    for (size_t i = 0; i < nbyte; i++) {
+        dst[i] = src[i] ^ key[(phase + i) % key_len];
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *        Define test functions
+ *----------------------------------------------------------------------------*/
+/* Every length, in place and out, with nothing written past the end */
+int XorBuf1()
+{
+    START_TEST_CASE;
+    BYTE *a = rand_byte(MAX_TEST_LEN),
+         *b = rand_byte(MAX_TEST_LEN);
+    BYTE ref[MAX_TEST_LEN], out[MAX_TEST_LEN + 1];
+
+    for (size_t n = 0; n <= MAX_TEST_LEN; n++) {
+        for (size_t i = 0; i < n; i++) { ref[i] = a[i] ^ b[i]; }
+
+        memset(out, '#', sizeof(out));
+        xor_buf(out, a, b, n);
+        SHOULD_BE(!memcmp(out, ref, n));
+        SHOULD_BE(out[n] == '#');
+
+        memcpy(out, a, n);
+        xor_buf(out, out, b, n);
+        SHOULD_BE(!memcmp(out, ref, n));
+    }
+
+    free(a);
+    free(b);
+    END_TEST_CASE;
+}
+
+/* Every key length up to MAX_KEY_LEN, and a few lengths of input */
+int XorRepeat1()
+{
+    START_TEST_CASE;
+    static const size_t LEN[] = { 0, 1, 15, 63, 64, 65, 129, MAX_TEST_LEN };
+    BYTE *src = rand_byte(MAX_TEST_LEN),
+         *key = rand_byte(MAX_KEY_LEN);
+    BYTE ref[MAX_TEST_LEN], out[MAX_TEST_LEN + 1];
+
+    for (size_t k = 1; k <= MAX_KEY_LEN; k++) {
+        for (size_t j = 0; j < sizeof(LEN) / sizeof(LEN[0]); j++) {
+            size_t n = LEN[j];
+            repeat_ref(ref, src, n, key, k, 0);
+
+            memset(out, '#', sizeof(out));
+            SHOULD_BE(xor_repeat(out, src, n, key, k, 0) == n % k);
+            SHOULD_BE(!memcmp(out, ref, n));
+            SHOULD_BE(out[n] == '#');
+
+            memcpy(out, src, n);
+            xor_repeat(out, out, n, key, k, 0);
+            SHOULD_BE(!memcmp(out, ref, n));
+        }
+    }
+
+    free(src);
+    free(key);
+    END_TEST_CASE;
+}
+
+/* A stream XOR-ed in pieces matches one call over the whole */
+int XorRepeatPhase1()
+{
+    START_TEST_CASE;
+    BYTE *src = rand_byte(MAX_TEST_LEN),
+         *key = rand_byte(MAX_KEY_LEN);
+    BYTE ref[MAX_TEST_LEN], out[MAX_TEST_LEN];
+
+    for (size_t k = 1; k <= MAX_KEY_LEN; k += 7) {
+        repeat_ref(ref, src, MAX_TEST_LEN, key, k, 3);
+
+        size_t phase = 3;
+        for (size_t i = 0, n = 1; i < MAX_TEST_LEN; i += n, n = 2*n + 1) {
+            n = MIN(n, MAX_TEST_LEN - i);
+            phase = xor_repeat(out + i, src + i, n, key, k, phase);
+        }
+        SHOULD_BE(!memcmp(out, ref, MAX_TEST_LEN));
+        SHOULD_BE(phase == (3 + MAX_TEST_LEN) % k);
+    }
+
+    free(src);
+    free(key);
+    END_TEST_CASE;
+}
+
+/* Keys longer than the input, from a phase past the start */
+int XorRepeatLong1()
+{
+    START_TEST_CASE;
+    size_t k = 1000;
+    BYTE *src = rand_byte(MAX_TEST_LEN),
+         *key = rand_byte(k);
+    BYTE ref[MAX_TEST_LEN], out[MAX_TEST_LEN];
+
+    repeat_ref(ref, src, MAX_TEST_LEN, key, k, 850);
+    SHOULD_BE(xor_repeat(out, src, MAX_TEST_LEN, key, k, 850)
+            == (850 + MAX_TEST_LEN) % k);
+    SHOULD_BE(!memcmp(out, ref, MAX_TEST_LEN));
+
+    /* A phase of key_len or more wraps */
+    SHOULD_BE(xor_repeat(out, src, MAX_TEST_LEN, key, k, k + 850)
+            == (850 + MAX_TEST_LEN) % k);
+    SHOULD_BE(!memcmp(out, ref, MAX_TEST_LEN));
+
+    free(src);
+    free(key);
+    END_TEST_CASE;
+}
+
+/*------------------------------------------------------------------------------
+ *        Run tests
+ *----------------------------------------------------------------------------*/
+int main(void)
+{
+    int fails = 0;
+    int total = 0;
+
+    RUN_TEST(XorBuf1,         "xor_buf()              ");
+    RUN_TEST(XorRepeat1,      "xor_repeat()           ");
+    RUN_TEST(XorRepeatPhase1, "xor_repeat() phase     ");
+    RUN_TEST(XorRepeatLong1,  "xor_repeat() long key  ");
+
+    /* Count errors */
+    if (!fails) {
+        printf("\033[0;32mAll %d tests passed!\033[0m\n", total); 
+        return 0;
+    } else {
+        printf("\033[0;31m%d/%d tests failed!\033[0m\n", fails, total);
+        return 1;
+    }
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,289 @@
+/*==============================================================================
+ *     File: util_aesni.c
+ *  Created: 10/17/2026, 11:24
+ *   Author: Bernie Roesler
+ *
+ *  Description: Native AES-128 block functions using the AES-NI instructions.
+ *      Everything here is compiled for the baseline target; the kernels carry
+ *      their own target attribute and are only called once CPUID says the
+ *      instructions exist.
+ *
+ *============================================================================*/
+
+#include "util_aesni.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <wmmintrin.h>
+
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+
+/* Blocks kept in flight at once: aesenc has ~4 cycles latency but issues
+ * every cycle, so independent blocks hide the latency */
+#define AESNI_WAYS 8
+
+int aesni_available(void)
+{
+    return cpu_has_aesni();
+}
+
+/*------------------------------------------------------------------------------
+ *         Key expansion
+ *----------------------------------------------------------------------------*/
+/* One round of the AES-128 key schedule, given aeskeygenassist(k, rcon) */
+AESNI_TARGET static inline __m128i expand_step(__m128i k, __m128i kg)
+{
+    kg = _mm_shuffle_epi32(kg, 0xff);
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    return _mm_xor_si128(k, kg);
+}
+
+/* aeskeygenassist needs an immediate round constant, so unroll by hand */
+#define EXPAND(i, rcon) \
+    rk[i] = expand_step(rk[i-1], _mm_aeskeygenassist_si128(rk[i-1], rcon))
+
+AESNI_TARGET void aesni_expand_key(BYTE *ek, BYTE *dk, const BYTE *key)
+{
+    __m128i rk[AES_128_ROUNDS + 1];
+
+    rk[0] = _mm_loadu_si128((const __m128i *)key);
+    EXPAND( 1, 0x01);
+    EXPAND( 2, 0x02);
+    EXPAND( 3, 0x04);
+    EXPAND( 4, 0x08);
+    EXPAND( 5, 0x10);
+    EXPAND( 6, 0x20);
+    EXPAND( 7, 0x40);
+    EXPAND( 8, 0x80);
+    EXPAND( 9, 0x1b);
+    EXPAND(10, 0x36);
+
+    if (ek) {
+        for (int i = 0; i <= AES_128_ROUNDS; i++) {
+            _mm_storeu_si128((__m128i *)ek + i, rk[i]);
+        }
+    }
+
+    /* Equivalent inverse cipher: reverse the schedule and run InvMixColumns
+     * over the inner round keys */
+    if (dk) {
+        _mm_storeu_si128((__m128i *)dk, rk[AES_128_ROUNDS]);
+        for (int i = 1; i < AES_128_ROUNDS; i++) {
+            _mm_storeu_si128((__m128i *)dk + i,
+                    _mm_aesimc_si128(rk[AES_128_ROUNDS - i]));
+        }
+        _mm_storeu_si128((__m128i *)dk + AES_128_ROUNDS, rk[0]);
+    }
+}
+
+#undef EXPAND
+
+/*------------------------------------------------------------------------------
+ *         Block kernels
+ *----------------------------------------------------------------------------*/
+/* The AESNI_WAYS lanes are spelled out so they stay in registers; gcc will
+ * not unroll the equivalent array loops and spills every round to the stack */
+#define LOAD8(p, k) do { \
+    b0 = _mm_xor_si128(_mm_loadu_si128((p) + 0), (k)); \
+    b1 = _mm_xor_si128(_mm_loadu_si128((p) + 1), (k)); \
+    b2 = _mm_xor_si128(_mm_loadu_si128((p) + 2), (k)); \
+    b3 = _mm_xor_si128(_mm_loadu_si128((p) + 3), (k)); \
+    b4 = _mm_xor_si128(_mm_loadu_si128((p) + 4), (k)); \
+    b5 = _mm_xor_si128(_mm_loadu_si128((p) + 5), (k)); \
+    b6 = _mm_xor_si128(_mm_loadu_si128((p) + 6), (k)); \
+    b7 = _mm_xor_si128(_mm_loadu_si128((p) + 7), (k)); \
+} while (0)
+
+#define ROUND8(f, k) do { \
+    b0 = f(b0, (k)); b1 = f(b1, (k)); b2 = f(b2, (k)); b3 = f(b3, (k)); \
+    b4 = f(b4, (k)); b5 = f(b5, (k)); b6 = f(b6, (k)); b7 = f(b7, (k)); \
+} while (0)
+
+#define XOR8(p) do { \
+    b0 = _mm_xor_si128(b0, _mm_loadu_si128((p) + 0)); \
+    b1 = _mm_xor_si128(b1, _mm_loadu_si128((p) + 1)); \
+    b2 = _mm_xor_si128(b2, _mm_loadu_si128((p) + 2)); \
+    b3 = _mm_xor_si128(b3, _mm_loadu_si128((p) + 3)); \
+    b4 = _mm_xor_si128(b4, _mm_loadu_si128((p) + 4)); \
+    b5 = _mm_xor_si128(b5, _mm_loadu_si128((p) + 5)); \
+    b6 = _mm_xor_si128(b6, _mm_loadu_si128((p) + 6)); \
+    b7 = _mm_xor_si128(b7, _mm_loadu_si128((p) + 7)); \
+} while (0)
+
+#define STORE8(p) do { \
+    _mm_storeu_si128((p) + 0, b0); _mm_storeu_si128((p) + 1, b1); \
+    _mm_storeu_si128((p) + 2, b2); _mm_storeu_si128((p) + 3, b3); \
+    _mm_storeu_si128((p) + 4, b4); _mm_storeu_si128((p) + 5, b5); \
+    _mm_storeu_si128((p) + 6, b6); _mm_storeu_si128((p) + 7, b7); \
+} while (0)
+
+AESNI_TARGET void aesni_encrypt_blocks(const BYTE *ek, BYTE *out, const BYTE *in,
+        size_t n_blocks)
+{
+    __m128i rk[AES_128_ROUNDS + 1];
+    const __m128i *src = (const __m128i *)in;
+    __m128i *dst = (__m128i *)out;
+
+    for (int r = 0; r <= AES_128_ROUNDS; r++) {
+        rk[r] = _mm_loadu_si128((const __m128i *)ek + r);
+    }
+
+    /* Main loop: AESNI_WAYS independent blocks per round */
+    for (; n_blocks >= AESNI_WAYS; n_blocks -= AESNI_WAYS) {
+        __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+        LOAD8(src, rk[0]);
+        for (int r = 1; r < AES_128_ROUNDS; r++) {
+            ROUND8(_mm_aesenc_si128, rk[r]);
+        }
+        ROUND8(_mm_aesenclast_si128, rk[AES_128_ROUNDS]);
+        STORE8(dst);
+        src += AESNI_WAYS;
+        dst += AESNI_WAYS;
+    }
+
+    /* Tail: one block at a time */
+    for (; n_blocks; n_blocks--) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128(src++), rk[0]);
+        for (int r = 1; r < AES_128_ROUNDS; r++) {
+            x = _mm_aesenc_si128(x, rk[r]);
+        }
+        _mm_storeu_si128(dst++, _mm_aesenclast_si128(x, rk[AES_128_ROUNDS]));
+    }
+}
+
+AESNI_TARGET void aesni_decrypt_blocks_xor(const BYTE *dk, BYTE *out,
+        const BYTE *in, const BYTE *mask, size_t n_blocks)
+{
+    __m128i rk[AES_128_ROUNDS + 1];
+    const __m128i *src = (const __m128i *)in,
+                  *msk = (const __m128i *)mask;
+    __m128i *dst = (__m128i *)out;
+
+    for (int r = 0; r <= AES_128_ROUNDS; r++) {
+        rk[r] = _mm_loadu_si128((const __m128i *)dk + r);
+    }
+
+    for (; n_blocks >= AESNI_WAYS; n_blocks -= AESNI_WAYS) {
+        __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+        LOAD8(src, rk[0]);
+        for (int r = 1; r < AES_128_ROUNDS; r++) {
+            ROUND8(_mm_aesdec_si128, rk[r]);
+        }
+        ROUND8(_mm_aesdeclast_si128, rk[AES_128_ROUNDS]);
+        if (msk) {
+            XOR8(msk);
+            msk += AESNI_WAYS;
+        }
+        STORE8(dst);
+        src += AESNI_WAYS;
+        dst += AESNI_WAYS;
+    }
+
+    for (; n_blocks; n_blocks--) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128(src++), rk[0]);
+        for (int r = 1; r < AES_128_ROUNDS; r++) {
+            x = _mm_aesdec_si128(x, rk[r]);
+        }
+        x = _mm_aesdeclast_si128(x, rk[AES_128_ROUNDS]);
+        if (msk) { x = _mm_xor_si128(x, _mm_loadu_si128(msk++)); }
+        _mm_storeu_si128(dst++, x);
+    }
+}
+
+AESNI_TARGET void aesni_decrypt_blocks(const BYTE *dk, BYTE *out, const BYTE *in,
+        size_t n_blocks)
+{
+    aesni_decrypt_blocks_xor(dk, out, in, NULL, n_blocks);
+}
+
+/* Each lane j has its own schedule ek[j]; round keys are loaded as needed */
+#define KEY(j, r) _mm_loadu_si128((const __m128i *)ek[j] + (r))
+
+#define ROUND8K(f, r) do { \
+    b0 = f(b0, KEY(0, r)); b1 = f(b1, KEY(1, r)); \
+    b2 = f(b2, KEY(2, r)); b3 = f(b3, KEY(3, r)); \
+    b4 = f(b4, KEY(4, r)); b5 = f(b5, KEY(5, r)); \
+    b6 = f(b6, KEY(6, r)); b7 = f(b7, KEY(7, r)); \
+} while (0)
+
+AESNI_TARGET void aesni_encrypt_blocks_multikey(const BYTE *const *ek,
+        BYTE *out, const BYTE *in, size_t n_blocks)
+{
+    const __m128i *src = (const __m128i *)in;
+    __m128i *dst = (__m128i *)out;
+
+    for (; n_blocks >= AESNI_WAYS; n_blocks -= AESNI_WAYS) {
+        __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+        b0 = _mm_xor_si128(_mm_loadu_si128(src + 0), KEY(0, 0));
+        b1 = _mm_xor_si128(_mm_loadu_si128(src + 1), KEY(1, 0));
+        b2 = _mm_xor_si128(_mm_loadu_si128(src + 2), KEY(2, 0));
+        b3 = _mm_xor_si128(_mm_loadu_si128(src + 3), KEY(3, 0));
+        b4 = _mm_xor_si128(_mm_loadu_si128(src + 4), KEY(4, 0));
+        b5 = _mm_xor_si128(_mm_loadu_si128(src + 5), KEY(5, 0));
+        b6 = _mm_xor_si128(_mm_loadu_si128(src + 6), KEY(6, 0));
+        b7 = _mm_xor_si128(_mm_loadu_si128(src + 7), KEY(7, 0));
+        for (int r = 1; r < AES_128_ROUNDS; r++) {
+            ROUND8K(_mm_aesenc_si128, r);
+        }
+        ROUND8K(_mm_aesenclast_si128, AES_128_ROUNDS);
+        STORE8(dst);
+        src += AESNI_WAYS;
+        dst += AESNI_WAYS;
+        ek  += AESNI_WAYS;
+    }
+
+    for (; n_blocks; n_blocks--, ek++) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128(src++), KEY(0, 0));
+        for (int r = 1; r < AES_128_ROUNDS; r++) {
+            x = _mm_aesenc_si128(x, KEY(0, r));
+        }
+        _mm_storeu_si128(dst++, _mm_aesenclast_si128(x, KEY(0, AES_128_ROUNDS)));
+    }
+}
+
+#undef KEY
+#undef ROUND8K
+#undef LOAD8
+#undef XOR8
+#undef ROUND8
+#undef STORE8
+
+#else
+/*------------------------------------------------------------------------------
+ *         Non-x86 builds: never selected, so reaching these is a bug
+ *----------------------------------------------------------------------------*/
+int aesni_available(void) { return 0; }
+
+void aesni_expand_key(BYTE *ek, BYTE *dk, const BYTE *key)
+{
+    ERROR("AES-NI not available on this architecture!");
+}
+
+void aesni_encrypt_blocks(const BYTE *ek, BYTE *out, const BYTE *in,
+        size_t n_blocks)
+{
+    ERROR("AES-NI not available on this architecture!");
+}
+
+void aesni_decrypt_blocks(const BYTE *dk, BYTE *out, const BYTE *in,
+        size_t n_blocks)
+{
+    ERROR("AES-NI not available on this architecture!");
+}
+
+void aesni_decrypt_blocks_xor(const BYTE *dk, BYTE *out, const BYTE *in,
+        const BYTE *mask, size_t n_blocks)
+{
+    ERROR("AES-NI not available on this architecture!");
+}
+
+void aesni_encrypt_blocks_multikey(const BYTE *const *ek, BYTE *out,
+        const BYTE *in, size_t n_blocks)
+{
+    ERROR("AES-NI not available on this architecture!");
+}
+#endif
+
+/*==============================================================================
+ *============================================================================*/
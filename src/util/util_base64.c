@@ -0,0 +1,539 @@
+/*==============================================================================
+ *     File: util_base64.c
+ *  Created: 10/17/2026, 18:34
+ *   Author: Bernie Roesler
+ *
+ *  Description: Base64 by table lookup, one quad at a time, and by the
+ *      SSSE3/SSE4.1/AVX2 range lookups of W. Muła and D. Lemire, 12 or 24
+ *      bytes at a time. The vector loops only see the body of the input;
+ *      the last quad, the only one that may hold '=' padding, is always
+ *      done by the scalar code.
+ *
+ *============================================================================*/
+
+#include "util_base64.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+static const char B64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Flags in the reverse table. All have the high bit set, which no 6-bit
+ * value does, so one test of OR-ed values catches any of them. */
+#define B64_BAD   0xFF
+#define B64_PAD   0xFE
+#define B64_SPACE 0xFD      /* isspace() in the C locale */
+#define B64_HIGH  0x80
+
+/* Whitespace is only skipped by the stream decoder */
+#define IS_BAD(x) ((x) == B64_BAD || (x) == B64_SPACE)
+#define ANY_BAD(a, b, c, d) (IS_BAD(a) || IS_BAD(b) || IS_BAD(c) || IS_BAD(d))
+
+/* 6-bit value of each character, or one of the flags above */
+static const BYTE B64_REV[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFD, 0xFD, 0xFD, 0xFD, 0xFD, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B,
+    0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+    0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+    0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20,
+    0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30,
+    0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+/*------------------------------------------------------------------------------
+ *         Scalar kernels
+ *----------------------------------------------------------------------------*/
+/* Encode n_quad whole groups of 3 bytes */
+static void encode_quads(char *out, const BYTE *in, size_t n_quad)
+{
+    for (size_t i = 0; i < n_quad; i++, in += 3, out += 4) {
+        uint32_t v = (in[0] << 16) | (in[1] << 8) | in[2];
+        out[0] = B64_ALPHABET[(v >> 18) & 0x3F];
+        out[1] = B64_ALPHABET[(v >> 12) & 0x3F];
+        out[2] = B64_ALPHABET[(v >>  6) & 0x3F];
+        out[3] = B64_ALPHABET[ v        & 0x3F];
+    }
+}
+
+/* Encode the last 1 or 2 bytes as a padded quad */
+static void encode_last(char *out, const BYTE *in, size_t n)
+{
+    uint32_t v = (in[0] << 16) | ((n > 1) ? in[1] << 8 : 0);
+    out[0] = B64_ALPHABET[(v >> 18) & 0x3F];
+    out[1] = B64_ALPHABET[(v >> 12) & 0x3F];
+    out[2] = (n > 1) ? B64_ALPHABET[(v >> 6) & 0x3F] : '=';
+    out[3] = '=';
+}
+
+/* Decode n_quad whole, unpadded quads. Returns 0 or B64_ECHAR. */
+static int decode_quads(BYTE *out, const BYTE *in, size_t n_quad)
+{
+    for (size_t i = 0; i < n_quad; i++, in += 4, out += 3) {
+        uint32_t a = B64_REV[in[0]],
+                 b = B64_REV[in[1]],
+                 c = B64_REV[in[2]],
+                 d = B64_REV[in[3]];
+
+        if ((a | b | c | d) & B64_HIGH) {
+            /* '=' is only allowed in the last quad */
+            return ANY_BAD(a, b, c, d) ? B64_ECHAR : B64_EPAD;
+        }
+
+        uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+        out[0] = v >> 16;
+        out[1] = v >> 8;
+        out[2] = v;
+    }
+    return 0;
+}
+
+/* Decode the table values of a quad that may end in "=" or "==". Returns
+ * the bytes written or a B64_ERROR. */
+static ssize_t decode_sextets(BYTE *out, uint32_t a, uint32_t b, uint32_t c,
+        uint32_t d)
+{
+    /* Past this, only B64_PAD has the high bit set */
+    if (ANY_BAD(a, b, c, d)) { return B64_ECHAR; }
+    if ((a | b) & B64_HIGH) { return B64_EPAD; }
+    if (c == B64_PAD && d != B64_PAD) { return B64_EPAD; }
+
+    int n_pad = (c == B64_PAD) + (d == B64_PAD);
+    if (c == B64_PAD) { c = 0; }
+    if (d == B64_PAD) { d = 0; }
+
+    uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+    out[0] = v >> 16;
+    if (n_pad < 2) { out[1] = v >> 8; }
+    if (n_pad < 1) { out[2] = v; }
+    return 3 - n_pad;
+}
+
+static ssize_t decode_last(BYTE *out, const BYTE *in)
+{
+    return decode_sextets(out, B64_REV[in[0]], B64_REV[in[1]],
+                          B64_REV[in[2]], B64_REV[in[3]]);
+}
+
+/*------------------------------------------------------------------------------
+ *         Vector kernels
+ *----------------------------------------------------------------------------*/
+#if defined(__x86_64__) || defined(__i386__)
+/* Both kernels map each character through three 16-entry tables indexed by
+ * its nibbles. lut_lo[lo] & lut_hi[hi] is non-zero exactly for characters
+ * outside the alphabet ('=' included). lut_roll[hi], with '/' moved to slot
+ * 1, is the offset from the character to its 6-bit value. maddubs and madd
+ * then pack each 4 x 6 bits into 24 bits of a 32-bit lane, and a byte
+ * shuffle squeezes out the top byte of every lane. */
+#define LUT_LO    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, \
+                  0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+#define LUT_HI    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, \
+                  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+#define LUT_ROLL  0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+#define LUT_PACK  2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+
+/* Decode 16 characters at a time. Returns the characters consumed, a
+ * multiple of 16, or B64_ECHAR. */
+__attribute__((target("ssse3,sse4.1")))
+static ssize_t decode_sse41(BYTE *out, const BYTE *in, size_t nchar)
+{
+    const __m128i lut_lo   = _mm_setr_epi8(LUT_LO),
+                  lut_hi   = _mm_setr_epi8(LUT_HI),
+                  lut_roll = _mm_setr_epi8(LUT_ROLL),
+                  pack     = _mm_setr_epi8(LUT_PACK),
+                  mask_2f  = _mm_set1_epi8(0x2F);
+    size_t i = 0;
+
+    for (; i + 16 <= nchar; i += 16, out += 12) {
+        __m128i str = _mm_loadu_si128((const __m128i *)(in + i));
+
+        /* 0x2F keeps the nibble and leaves bit 7 clear for pshufb */
+        __m128i hi_nib = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f),
+                lo_nib = _mm_and_si128(str, mask_2f);
+        __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nib),
+                lo = _mm_shuffle_epi8(lut_lo, lo_nib);
+        if (!_mm_testz_si128(lo, hi)) { return B64_ECHAR; }
+
+        __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f),
+                roll  = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nib));
+        str = _mm_add_epi8(str, roll);
+
+        str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+        str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+        str = _mm_shuffle_epi8(str, pack);
+
+        _mm_storel_epi64((__m128i *)out, str);
+        uint32_t w = _mm_extract_epi32(str, 2);
+        memcpy(out + 8, &w, 4);
+    }
+    return i;
+}
+
+/* Decode 32 characters at a time, as above */
+__attribute__((target("avx2")))
+static ssize_t decode_avx2(BYTE *out, const BYTE *in, size_t nchar)
+{
+    const __m256i lut_lo   = _mm256_setr_epi8(LUT_LO, LUT_LO),
+                  lut_hi   = _mm256_setr_epi8(LUT_HI, LUT_HI),
+                  lut_roll = _mm256_setr_epi8(LUT_ROLL, LUT_ROLL),
+                  pack     = _mm256_setr_epi8(LUT_PACK, LUT_PACK),
+                  lanes    = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1),
+                  mask_2f  = _mm256_set1_epi8(0x2F);
+    size_t i = 0;
+
+    for (; i + 32 <= nchar; i += 32, out += 24) {
+        __m256i str = _mm256_loadu_si256((const __m256i *)(in + i));
+
+        __m256i hi_nib = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f),
+                lo_nib = _mm256_and_si256(str, mask_2f);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nib),
+                lo = _mm256_shuffle_epi8(lut_lo, lo_nib);
+        if (!_mm256_testz_si256(lo, hi)) { return B64_ECHAR; }
+
+        __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f),
+                roll  = _mm256_shuffle_epi8(lut_roll,
+                                            _mm256_add_epi8(eq_2f, hi_nib));
+        str = _mm256_add_epi8(str, roll);
+
+        str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+        str = _mm256_shuffle_epi8(str, pack);
+        str = _mm256_permutevar8x32_epi32(str, lanes);
+
+        /* 24 bytes, without touching the 8 after them */
+        _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(str));
+        _mm_storel_epi64((__m128i *)(out + 16),
+                         _mm256_extracti128_si256(str, 1));
+    }
+    return i;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+/* The encoders spread each 3 bytes over a 32-bit lane, move each 6-bit field
+ * into its own byte with two 16-bit multiplies, and map the values to
+ * characters by adding a per-range offset from a 16-entry table. */
+#define ENC_SPREAD 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+#define ENC_ROLL   65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, \
+                   -19, -16, 0, 0
+
+/* Encode 12 bytes at a time. Loads read 16, so 4 bytes must follow the last
+ * group. Returns the bytes consumed. */
+__attribute__((target("ssse3")))
+static size_t encode_ssse3(char *out, const BYTE *in, size_t nbyte)
+{
+    const __m128i spread = _mm_setr_epi8(ENC_SPREAD),
+                  lut    = _mm_setr_epi8(ENC_ROLL);
+    size_t i = 0;
+
+    for (; i + 16 <= nbyte; i += 12, out += 16) {
+        __m128i str = _mm_loadu_si128((const __m128i *)(in + i));
+        str = _mm_shuffle_epi8(str, spread);
+
+        __m128i t0 = _mm_and_si128(str, _mm_set1_epi32(0x0FC0FC00)),
+                t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040)),
+                t2 = _mm_and_si128(str, _mm_set1_epi32(0x003F03F0)),
+                t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        str = _mm_or_si128(t1, t3);
+
+        /* 0 for A-Z, 1 for a-z, 2 for 0-9, 12 for '+' and 13 for '/' */
+        __m128i idx  = _mm_subs_epu8(str, _mm_set1_epi8(51)),
+                mask = _mm_cmpgt_epi8(str, _mm_set1_epi8(25));
+        idx = _mm_sub_epi8(idx, mask);
+        str = _mm_add_epi8(str, _mm_shuffle_epi8(lut, idx));
+
+        _mm_storeu_si128((__m128i *)out, str);
+    }
+    return i;
+}
+
+/* Encode 24 bytes at a time, 12 per 128-bit lane, as above. Loads read 28. */
+__attribute__((target("avx2")))
+static size_t encode_avx2(char *out, const BYTE *in, size_t nbyte)
+{
+    const __m256i spread = _mm256_setr_epi8(ENC_SPREAD, ENC_SPREAD),
+                  lut    = _mm256_setr_epi8(ENC_ROLL, ENC_ROLL);
+    size_t i = 0;
+
+    for (; i + 28 <= nbyte; i += 24, out += 32) {
+        __m256i str = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *)(in + i))),
+                _mm_loadu_si128((const __m128i *)(in + i + 12)), 1);
+        str = _mm256_shuffle_epi8(str, spread);
+
+        __m256i t0 = _mm256_and_si256(str, _mm256_set1_epi32(0x0FC0FC00)),
+                t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040)),
+                t2 = _mm256_and_si256(str, _mm256_set1_epi32(0x003F03F0)),
+                t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        str = _mm256_or_si256(t1, t3);
+
+        __m256i idx  = _mm256_subs_epu8(str, _mm256_set1_epi8(51)),
+                mask = _mm256_cmpgt_epi8(str, _mm256_set1_epi8(25));
+        idx = _mm256_sub_epi8(idx, mask);
+        str = _mm256_add_epi8(str, _mm256_shuffle_epi8(lut, idx));
+
+        _mm256_storeu_si256((__m256i *)out, str);
+    }
+    return i;
+}
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Public interface
+ *----------------------------------------------------------------------------*/
+/* Encode the whole groups from done onwards and the padded tail */
+static size_t encode_rest(char *out, const BYTE *in, size_t nbyte,
+        size_t done)
+{
+    size_t n_quad = nbyte / 3;
+    encode_quads(out + done/3*4, in + done, n_quad - done/3);
+    if (nbyte % 3) { encode_last(out + n_quad*4, in + n_quad*3, nbyte % 3); }
+    return B64_ENCODE_LEN(nbyte);
+}
+
+size_t b64_encode_scalar(char *b64, const BYTE *byte, size_t nbyte)
+{
+    size_t nchar = encode_rest(b64, byte, nbyte, 0);
+    b64[nchar] = '\0';
+    return nchar;
+}
+
+size_t b64_encode(char *b64, const BYTE *byte, size_t nbyte)
+{
+    size_t done = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) {
+        done = encode_avx2(b64, byte, nbyte);
+    } else if (cpu_has_ssse3()) {
+        done = encode_ssse3(b64, byte, nbyte);
+    }
+#endif
+
+    size_t nchar = encode_rest(b64, byte, nbyte, done);
+    b64[nchar] = '\0';
+    return nchar;
+}
+
+ssize_t b64_encode_wrap(char *b64, const BYTE *byte, size_t nbyte,
+        size_t width)
+{
+    if (width == 0) { return B64_ELEN; }
+
+    /* Encode in one go, then open a gap after each line, starting from the
+     * back: line k moves up by k, so none is overwritten before it moves */
+    size_t nchar  = b64_encode(b64, byte, nbyte),
+           n_line = (nchar + width - 1) / width;
+    char *p = b64 + nchar + n_line;
+
+    *p = '\0';
+    for (size_t k = n_line; k-- > 0; ) {
+        size_t len = MIN(width, nchar - k*width);
+        *--p = '\n';
+        p -= len;
+        memmove(p, b64 + k*width, len);
+    }
+    return nchar + n_line;
+}
+
+
+/* Decode the body from done onwards and the last quad */
+static ssize_t decode_rest(BYTE *out, const BYTE *in, size_t nchar,
+        size_t done)
+{
+    size_t n_body = nchar - 4;
+    int err = decode_quads(out + done/4*3, in + done, (n_body - done) / 4);
+    if (err) { return err; }
+
+    ssize_t n_last = decode_last(out + n_body/4*3, in + n_body);
+    return (n_last < 0) ? n_last : (ssize_t)(n_body/4*3) + n_last;
+}
+
+ssize_t b64_decode_scalar(BYTE *byte, const char *b64, size_t nchar)
+{
+    if (nchar % 4) { return B64_ELEN; }
+    if (nchar == 0) { return 0; }
+    return decode_rest(byte, (const BYTE *)b64, nchar, 0);
+}
+
+ssize_t b64_decode(BYTE *byte, const char *b64, size_t nchar)
+{
+    if (nchar % 4) { return B64_ELEN; }
+    if (nchar == 0) { return 0; }
+
+    const BYTE *in = (const BYTE *)b64;
+    ssize_t done = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+    /* The vector loops stop short of the last quad */
+    if (cpu_has_avx2()) {
+        done = decode_avx2(byte, in, nchar - 4);
+    } else if (cpu_has_ssse3() && cpu_has_sse41()) {
+        done = decode_sse41(byte, in, nchar - 4);
+    }
+
+    /* Let the scalar code tell a stray '=' from a bad character */
+    if (done < 0) { return b64_decode_scalar(byte, b64, nchar); }
+#endif
+
+    return decode_rest(byte, in, nchar, done);
+}
+
+/*------------------------------------------------------------------------------
+ *         Decode incrementally
+ *----------------------------------------------------------------------------*/
+void b64_stream_init(B64_STREAM *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+ssize_t b64_stream_update(B64_STREAM *s, BYTE *byte, const char *b64,
+        size_t nchar)
+{
+    /* s     : decoder state
+     * byte  : output, at least B64_STREAM_LEN(nchar) bytes
+     * b64   : next nchar characters of input, any whitespace ignored
+     *
+     * returns : number of bytes written, or a B64_ERROR
+     */
+    const BYTE *in = (const BYTE *)b64;
+    BYTE *p = byte;
+    size_t i = 0;
+    STATS_START(t0);
+
+    while (i < nchar) {
+        BYTE v = B64_REV[in[i]];
+        if (v == B64_SPACE) { i++; continue; }
+
+        /* Nothing may follow the padding */
+        if (s->done) { return B64_EPAD; }
+
+        /* Between quads, decode the whole quads up to the next whitespace,
+         * i.e. a line of a wrapped file, in one go */
+        if (s->n_quad == 0) {
+            size_t j = i;
+            while (j < nchar && B64_REV[in[j]] != B64_SPACE) { j++; }
+
+            size_t run = (j - i) & ~(size_t)3;
+            if (run) {
+                ssize_t n = b64_decode(p, b64 + i, run);
+                if (n < 0) { return n; }
+                s->done = ((size_t)n < run/4*3);    /* it ended in '=' */
+                p += n;
+                i += run;
+                continue;
+            }
+        }
+
+        /* A quad split by whitespace or a chunk boundary */
+        if (v == B64_BAD) { return B64_ECHAR; }
+        s->quad[s->n_quad++] = v;
+        i++;
+        if (s->n_quad < 4) { continue; }
+
+        BYTE *q = s->quad;
+        ssize_t n = decode_sextets(p, q[0], q[1], q[2], q[3]);
+        if (n < 0) { return n; }
+        s->done = (q[3] == B64_PAD);
+        s->n_quad = 0;
+        p += n;
+    }
+
+    STATS_STOP(STAT_B64, t0, p - byte);
+    return p - byte;
+}
+
+int b64_stream_final(B64_STREAM *s)
+{
+    return s->n_quad ? B64_ELEN : 0;
+}
+
+/*------------------------------------------------------------------------------
+ *         Decode a file
+ *----------------------------------------------------------------------------*/
+ssize_t b64_decode_file(FILE *fp, B64_EMIT emit, void *arg)
+{
+    /* One chunk of input and its bytes, whatever the file size */
+    char *b64 = init_str(B64_FILE_CHUNK);
+    BYTE *byte = init_byte(B64_EMIT_MAX);
+    B64_STREAM s;
+    b64_stream_init(&s);
+
+    ssize_t total = 0;
+    size_t nchar;
+    while ((nchar = fread(b64, 1, B64_FILE_CHUNK, fp)) > 0) {
+        ssize_t nbyte = b64_stream_update(&s, byte, b64, nchar);
+        if (nbyte < 0) { total = nbyte; break; }
+        if (nbyte && emit(arg, byte, nbyte)) { total = B64_ESTOP; break; }
+        total += nbyte;
+    }
+
+    if (total >= 0 && ferror(fp)) { total = B64_EIO; }
+    if (total >= 0 && b64_stream_final(&s)) { total = B64_ELEN; }
+
+    free(b64);
+    free(byte);
+    return total;
+}
+
+int b64_emit_buf(void *arg, const BYTE *byte, size_t nbyte)
+{
+    B64_BUF *buf = arg;
+    if (buf->nbyte + nbyte > buf->size) { return -1; }
+    memcpy(buf->byte + buf->nbyte, byte, nbyte);
+    buf->nbyte += nbyte;
+    return 0;
+}
+
+ssize_t b64_file2byte(BYTE **byte, const char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    if (!fp) { ERROR("File %s could not be read!", filename); }
+
+    /* The file size bounds the bytes; no copy of the text is kept */
+    fseek(fp, 0, SEEK_END);
+    long nchar = ftell(fp);
+    rewind(fp);
+
+    B64_BUF buf = { init_byte(B64_STREAM_LEN(nchar)), 0,
+                    B64_STREAM_LEN(nchar) };
+    ssize_t nbyte = b64_decode_file(fp, b64_emit_buf, &buf);
+    fclose(fp);
+
+    if (nbyte < 0) {
+        free(buf.byte);
+        return nbyte;
+    }
+    *byte = buf.byte;
+    return nbyte;
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,572 @@
+/*==============================================================================
+ *     File: util_bitslice.c
+ *  Created: 10/17/2026, 13:12
+ *   Author: Bernie Roesler
+ *
+ *  Description: Constant-time bitsliced software AES-128.
+ *
+ *      The state of 4 blocks fits in 8 64-bit words, one per bit-plane: bit i
+ *      of state byte (row r, column c) of block k lives in plane i at bit
+ *
+ *          r*16 + c*4 + k
+ *
+ *      so each row is a 16-bit field. ShiftRows becomes a rotate inside each
+ *      field and MixColumns a rotate of the whole word by whole rows. SubBytes
+ *      is the 113-gate Boyar-Peralta circuit, evaluated on all 128 bytes of
+ *      the 8 planes at once. GCC vector extensions widen every word to
+ *      BITSLICE_LANES independent 64-bit lanes; the same code is compiled
+ *      once for AVX2 and once for the baseline target.
+ *
+ *============================================================================*/
+
+#include <openssl/crypto.h>
+
+#include "util_bitslice.h"
+
+/* One bit-plane of BITSLICE_LANES * 4 blocks */
+typedef uint64_t bs_word __attribute__((vector_size(8 * BITSLICE_LANES)));
+
+/* Everything the kernel touches must be inlined into the target-specific
+ * entry points below to be compiled for that target */
+#define BS_INLINE static inline __attribute__((always_inline))
+
+/* Bytes in one kernel call */
+#define BS_BATCH_LEN (16 * BITSLICE_BLOCKS)
+
+/*------------------------------------------------------------------------------
+ *         Bytes <-> bit-planes
+ *----------------------------------------------------------------------------*/
+/* Before the transpose, word j = 4*(c&1) + k holds block k, columns c and
+ * c+2 (c = j>>2) with their bytes interleaved: byte 2r is row r of column c,
+ * byte 2r+1 row r of column c+2. Columns are 4 contiguous bytes. */
+
+#define SWAPMOVE(a, b, m, n) do { \
+    bs_word _t = (((a) >> (n)) ^ (b)) & (m); \
+    (b) ^= _t; \
+    (a) ^= _t << (n); \
+} while (0)
+
+/* Transpose the 8x8 bit matrix at each byte position of w[0..7]:
+ * bit i of byte b of w[j] <-> bit j of byte b of w[i]. Self-inverse. */
+BS_INLINE void bs_ortho(bs_word *w)
+{
+    const uint64_t m1 = 0x5555555555555555ULL,
+                   m2 = 0x3333333333333333ULL,
+                   m4 = 0x0F0F0F0F0F0F0F0FULL;
+
+    SWAPMOVE(w[0], w[1], m1, 1); SWAPMOVE(w[2], w[3], m1, 1);
+    SWAPMOVE(w[4], w[5], m1, 1); SWAPMOVE(w[6], w[7], m1, 1);
+
+    SWAPMOVE(w[0], w[2], m2, 2); SWAPMOVE(w[1], w[3], m2, 2);
+    SWAPMOVE(w[4], w[6], m2, 2); SWAPMOVE(w[5], w[7], m2, 2);
+
+    SWAPMOVE(w[0], w[4], m4, 4); SWAPMOVE(w[1], w[5], m4, 4);
+    SWAPMOVE(w[2], w[6], m4, 4); SWAPMOVE(w[3], w[7], m4, 4);
+}
+
+/* Byte k of a 32-bit word -> byte 2k of a 64-bit word */
+BS_INLINE uint64_t bs_spread(uint32_t a)
+{
+    uint64_t x = a;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x <<  8)) & 0x00FF00FF00FF00FFULL;
+    return x;
+}
+
+/* Byte 2k of a 64-bit word -> byte k of a 32-bit word */
+BS_INLINE uint32_t bs_unspread(uint64_t x)
+{
+    x &= 0x00FF00FF00FF00FFULL;
+    x = (x | (x >>  8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return (uint32_t)x;
+}
+
+BS_INLINE uint32_t bs_load32(const BYTE *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8
+        | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+BS_INLINE void bs_store32(BYTE *p, uint32_t x)
+{
+    p[0] = (BYTE)x;
+    p[1] = (BYTE)(x >> 8);
+    p[2] = (BYTE)(x >> 16);
+    p[3] = (BYTE)(x >> 24);
+}
+
+/* BITSLICE_BLOCKS blocks -> 8 bit-planes. The byte shuffling is scalar, the
+ * transpose runs on all lanes at once. */
+BS_INLINE void bs_pack(bs_word *q, const BYTE *in)
+{
+    uint64_t w[8][BITSLICE_LANES];
+
+    for (int l = 0; l < BITSLICE_LANES; l++, in += 64) {
+        for (int j = 0; j < 8; j++) {
+            const BYTE *col = in + 16*(j & 3) + 4*(j >> 2);
+            w[j][l] = bs_spread(bs_load32(col))
+                    | bs_spread(bs_load32(col + 8)) << 8;
+        }
+    }
+
+    memcpy(q, w, sizeof(w));
+    bs_ortho(q);
+}
+
+/* 8 bit-planes -> BITSLICE_BLOCKS blocks. Clobbers q. */
+BS_INLINE void bs_unpack(BYTE *out, bs_word *q)
+{
+    uint64_t w[8][BITSLICE_LANES];
+
+    bs_ortho(q);
+    memcpy(w, q, sizeof(w));
+
+    for (int l = 0; l < BITSLICE_LANES; l++, out += 64) {
+        for (int j = 0; j < 8; j++) {
+            BYTE *col = out + 16*(j & 3) + 4*(j >> 2);
+            bs_store32(col,     bs_unspread(w[j][l]));
+            bs_store32(col + 8, bs_unspread(w[j][l] >> 8));
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         SubBytes: Boyar-Peralta S-box circuit
+ *----------------------------------------------------------------------------*/
+BS_INLINE void bs_sbox(bs_word *q)
+{
+    bs_word x0, x1, x2, x3, x4, x5, x6, x7;
+    bs_word y1, y2, y3, y4, y5, y6, y7, y8, y9;
+    bs_word y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+    bs_word y20, y21;
+    bs_word z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    bs_word z10, z11, z12, z13, z14, z15, z16, z17;
+    bs_word t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    bs_word t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    bs_word t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    bs_word t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    bs_word t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    bs_word t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    bs_word t60, t61, t62, t63, t64, t65, t66, t67;
+    bs_word s0, s1, s2, s3, s4, s5, s6, s7;
+
+    /* The circuit numbers bits from the most significant */
+    x0 = q[7]; x1 = q[6]; x2 = q[5]; x3 = q[4];
+    x4 = q[3]; x5 = q[2]; x6 = q[1]; x7 = q[0];
+
+    /* Top linear transformation */
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    /* Non-linear section: inversion in GF(2^8) */
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    /* Bottom linear transformation */
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0; q[6] = s1; q[5] = s2; q[4] = s3;
+    q[3] = s4; q[2] = s5; q[1] = s6; q[0] = s7;
+}
+
+/* Inverse of the S-box affine map: v -> A^-1 (v ^ 0x63) */
+BS_INLINE void bs_inv_affine(bs_word *q)
+{
+    bs_word q0 = ~q[0], q1 = ~q[1], q2 = q[2], q3 = q[3],
+            q4 = q[4], q5 = ~q[5], q6 = ~q[6], q7 = q[7];
+
+    q[7] = q1 ^ q4 ^ q6;
+    q[6] = q0 ^ q3 ^ q5;
+    q[5] = q7 ^ q2 ^ q4;
+    q[4] = q6 ^ q1 ^ q3;
+    q[3] = q5 ^ q0 ^ q2;
+    q[2] = q4 ^ q7 ^ q1;
+    q[1] = q3 ^ q6 ^ q0;
+    q[0] = q2 ^ q5 ^ q7;
+}
+
+/* With L(v) = A^-1 (v ^ 0x63), S(v) = L^-1(inv(v)), so S^-1(v) = inv(L(v)) =
+ * L(S(L(v))) */
+BS_INLINE void bs_inv_sbox(bs_word *q)
+{
+    bs_inv_affine(q);
+    bs_sbox(q);
+    bs_inv_affine(q);
+}
+
+/*------------------------------------------------------------------------------
+ *         ShiftRows, MixColumns, AddRoundKey
+ *----------------------------------------------------------------------------*/
+/* Row r moves left by r columns: rotate its 16-bit field right by 4r bits */
+BS_INLINE void bs_shift_rows(bs_word *q)
+{
+    for (int i = 0; i < 8; i++) {
+        bs_word x = q[i];
+        q[i] = (x & 0x000000000000FFFFULL)
+             | ((x & 0x00000000FFF00000ULL) >>  4)
+             | ((x & 0x00000000000F0000ULL) << 12)
+             | ((x & 0x0000FF0000000000ULL) >>  8)
+             | ((x & 0x000000FF00000000ULL) <<  8)
+             | ((x & 0xF000000000000000ULL) >> 12)
+             | ((x & 0x0FFF000000000000ULL) <<  4);
+    }
+}
+
+BS_INLINE void bs_inv_shift_rows(bs_word *q)
+{
+    for (int i = 0; i < 8; i++) {
+        bs_word x = q[i];
+        q[i] = (x & 0x000000000000FFFFULL)
+             | ((x & 0x00000000F0000000ULL) >> 12)
+             | ((x & 0x000000000FFF0000ULL) <<  4)
+             | ((x & 0x0000FF0000000000ULL) >>  8)
+             | ((x & 0x000000FF00000000ULL) <<  8)
+             | ((x & 0xFFF0000000000000ULL) >>  4)
+             | ((x & 0x000F000000000000ULL) << 12);
+    }
+}
+
+/* Rotate each lane right by n bits; n is a multiple of 16, i.e. whole rows */
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+/* Multiply every byte by x in GF(2^8), modulo x^8 + x^4 + x^3 + x + 1 */
+BS_INLINE void bs_xtime(bs_word *t)
+{
+    bs_word hi = t[7];
+    t[7] = t[6];
+    t[6] = t[5];
+    t[5] = t[4];
+    t[4] = t[3] ^ hi;
+    t[3] = t[2] ^ hi;
+    t[2] = t[1];
+    t[1] = t[0] ^ hi;
+    t[0] = hi;
+}
+
+/* s'_r = 2 s_r ^ 3 s_{r+1} ^ s_{r+2} ^ s_{r+3} = 2 (s_r ^ s_{r+1}) ^ s_{r+1}
+ * ^ s_{r+2} ^ s_{r+3}, where row r+1 is the word rotated right by 16 */
+BS_INLINE void bs_mix_columns(bs_word *q)
+{
+    bs_word t[8], u[8];
+    for (int i = 0; i < 8; i++) {
+        bs_word r1 = ROTR(q[i], 16);
+        t[i] = q[i] ^ r1;
+        u[i] = r1 ^ ROTR(q[i], 32) ^ ROTR(q[i], 48);
+    }
+    bs_xtime(t);
+    for (int i = 0; i < 8; i++) { q[i] = t[i] ^ u[i]; }
+}
+
+/* InvMixColumns = MixColumns after s_r ^= 4 (s_r ^ s_{r+2}) */
+BS_INLINE void bs_inv_mix_columns(bs_word *q)
+{
+    bs_word w[8];
+    for (int i = 0; i < 8; i++) { w[i] = q[i] ^ ROTR(q[i], 32); }
+    bs_xtime(w);
+    bs_xtime(w);
+    for (int i = 0; i < 8; i++) { q[i] ^= w[i]; }
+    bs_mix_columns(q);
+}
+
+/* Round keys are stored for one lane; broadcast to all of them */
+BS_INLINE void bs_add_round_key(bs_word *q, const uint64_t *rk)
+{
+    for (int i = 0; i < 8; i++) { q[i] ^= rk[i]; }
+}
+
+/*------------------------------------------------------------------------------
+ *         One batch of BITSLICE_BLOCKS blocks
+ *----------------------------------------------------------------------------*/
+BS_INLINE void bs_encrypt_batch(const uint64_t *rk, BYTE *out, const BYTE *in)
+{
+    bs_word q[8];
+
+    bs_pack(q, in);
+    bs_add_round_key(q, rk);
+    for (int r = 1; r < AES_128_ROUNDS; r++) {
+        bs_sbox(q);
+        bs_shift_rows(q);
+        bs_mix_columns(q);
+        bs_add_round_key(q, rk + 8*r);
+    }
+    bs_sbox(q);
+    bs_shift_rows(q);
+    bs_add_round_key(q, rk + 8*AES_128_ROUNDS);
+    bs_unpack(out, q);
+}
+
+BS_INLINE void bs_decrypt_batch(const uint64_t *rk, BYTE *out, const BYTE *in)
+{
+    bs_word q[8];
+
+    bs_pack(q, in);
+    bs_add_round_key(q, rk + 8*AES_128_ROUNDS);
+    for (int r = AES_128_ROUNDS - 1; r > 0; r--) {
+        bs_inv_shift_rows(q);
+        bs_inv_sbox(q);
+        bs_add_round_key(q, rk + 8*r);
+        bs_inv_mix_columns(q);
+    }
+    bs_inv_shift_rows(q);
+    bs_inv_sbox(q);
+    bs_add_round_key(q, rk);
+    bs_unpack(out, q);
+}
+
+/*------------------------------------------------------------------------------
+ *         Target-specific entry points
+ *----------------------------------------------------------------------------*/
+typedef void (*bs_batch_fn)(const uint64_t *, BYTE *, const BYTE *);
+
+static void encrypt_batch_base(const uint64_t *rk, BYTE *out, const BYTE *in)
+{
+    bs_encrypt_batch(rk, out, in);
+}
+
+static void decrypt_batch_base(const uint64_t *rk, BYTE *out, const BYTE *in)
+{
+    bs_decrypt_batch(rk, out, in);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void encrypt_batch_avx2(const uint64_t *rk, BYTE *out, const BYTE *in)
+{
+    bs_encrypt_batch(rk, out, in);
+}
+
+__attribute__((target("avx2")))
+static void decrypt_batch_avx2(const uint64_t *rk, BYTE *out, const BYTE *in)
+{
+    bs_decrypt_batch(rk, out, in);
+}
+#endif
+
+/* Run n_blocks through fn, padding the last batch out to a full one */
+static void bs_blocks(bs_batch_fn fn, const uint64_t *rk, BYTE *out,
+        const BYTE *in, size_t n_blocks)
+{
+    for (; n_blocks >= BITSLICE_BLOCKS; n_blocks -= BITSLICE_BLOCKS) {
+        fn(rk, out, in);
+        in  += BS_BATCH_LEN;
+        out += BS_BATCH_LEN;
+    }
+
+    if (n_blocks) {
+        BYTE tmp[BS_BATCH_LEN] = {0};
+        memcpy(tmp, in, n_blocks*16);
+        fn(rk, tmp, tmp);
+        memcpy(out, tmp, n_blocks*16);
+    }
+}
+
+void bitslice_encrypt_blocks(const uint64_t *rk, BYTE *out, const BYTE *in,
+        size_t n_blocks)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) {
+        bs_blocks(encrypt_batch_avx2, rk, out, in, n_blocks);
+        return;
+    }
+#endif
+    bs_blocks(encrypt_batch_base, rk, out, in, n_blocks);
+}
+
+void bitslice_decrypt_blocks(const uint64_t *rk, BYTE *out, const BYTE *in,
+        size_t n_blocks)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) {
+        bs_blocks(decrypt_batch_avx2, rk, out, in, n_blocks);
+        return;
+    }
+#endif
+    bs_blocks(decrypt_batch_base, rk, out, in, n_blocks);
+}
+
+/*------------------------------------------------------------------------------
+ *         Key expansion
+ *----------------------------------------------------------------------------*/
+/* Constant-time multiply in GF(2^8): no branches or lookups on a or b */
+static BYTE gf_mul(BYTE a, BYTE b)
+{
+    BYTE p = 0;
+    for (int i = 0; i < 8; i++) {
+        p ^= -(b & 1) & a;
+        a = (a << 1) ^ (-(a >> 7) & 0x1b);
+        b >>= 1;
+    }
+    return p;
+}
+
+/* S-box by arithmetic rather than a table: A(x^254) ^ 0x63 */
+static BYTE ct_sbox(BYTE x)
+{
+    BYTE y = 1;
+
+    /* x^254 == x^-1 (and 0 -> 0); the exponent is public */
+    for (int i = 7; i >= 0; i--) {
+        y = gf_mul(y, y);
+        if ((254 >> i) & 1) { y = gf_mul(y, x); }
+    }
+
+#define ROTL8(v, n) ((BYTE)(((v) << (n)) | ((v) >> (8 - (n)))))
+    return y ^ ROTL8(y, 1) ^ ROTL8(y, 2) ^ ROTL8(y, 3) ^ ROTL8(y, 4) ^ 0x63;
+#undef ROTL8
+}
+
+void bitslice_expand_key(uint64_t *rk, const BYTE *key)
+{
+    BYTE w[(AES_128_ROUNDS + 1) * 16];
+    BYTE rcon = 0x01;
+
+    /* Standard AES-128 byte schedule */
+    memcpy(w, key, 16);
+    for (int i = 16; i < (int)sizeof(w); i += 4) {
+        BYTE t[4] = { w[i-4], w[i-3], w[i-2], w[i-1] };
+        if (i % 16 == 0) {
+            /* RotWord, SubWord, Rcon */
+            BYTE t0 = t[0];
+            t[0] = ct_sbox(t[1]) ^ rcon;
+            t[1] = ct_sbox(t[2]);
+            t[2] = ct_sbox(t[3]);
+            t[3] = ct_sbox(t0);
+            rcon = gf_mul(rcon, 2);
+        }
+        for (int j = 0; j < 4; j++) { w[i+j] = w[i-16+j] ^ t[j]; }
+    }
+
+    /* Bitslice each round key as a batch of copies of itself; every lane
+     * then holds the same planes, so keep lane 0 */
+    BYTE copies[BS_BATCH_LEN];
+    bs_word q[8];
+    for (int r = 0; r <= AES_128_ROUNDS; r++) {
+        for (int k = 0; k < BITSLICE_BLOCKS; k++) {
+            memcpy(copies + 16*k, w + 16*r, 16);
+        }
+        bs_pack(q, copies);
+        for (int i = 0; i < 8; i++) { rk[8*r + i] = q[i][0]; }
+    }
+
+    /* Don't leave the schedule on the stack. A plain memset of a dead
+     * buffer may be optimized away; OPENSSL_cleanse is not. */
+    OPENSSL_cleanse(w, sizeof(w));
+    OPENSSL_cleanse(copies, sizeof(copies));
+    OPENSSL_cleanse(q, sizeof(q));
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -9,7 +9,51 @@
 
 #include "util_convert.h"
 
-static const char *HEX_LUT = "0123456789ABCDEF";
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+static const char HEX_UPPER[] = "0123456789ABCDEF",
+                  HEX_LOWER[] = "0123456789abcdef";
+
+/* Value of each hex digit, 0xFF for any other character. The high bit marks
+ * the error, so OR-ing values together checks a whole run at once. */
+#define HEX_BAD 0xFF
+
+static const BYTE HEX_NIBBLE[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
 
 /*------------------------------------------------------------------------------ 
  *          Convert string to uppercase (in-place)
@@ -46,26 +90,17 @@ char *strtolower(char *s)
 *-----------------------------------------------------------------------------*/
 BYTE get_hex_byte(const char *hex)
 {
+    /* Take 1 or 2 chars, error if input is length 0. Only look as far as the
+     * second char, not the whole string. */
+    int nmax = (hex[0] && hex[1]) ? 2 : 1;
     BYTE u = 0;
-    int c = 0;
-    char p;
-
-    /* Take 1 or 2 chars, error if input is length 0 */
-    int nmax = (strlen(hex) > 1) ? 2 : 1;
-
-    for (int i = 0; i < nmax; i++)
-    {
-        p = *hex;
-        if      (p >= '0' && p <= '9') { c = p - '0'; }
-        else if (p >= 'a' && p <= 'f') { c = p - 'a' + 10; } 
-        else if (p >= 'A' && p <= 'F') { c = p - 'A' + 10; } 
-        else { 
-            ERROR("Invalid hex character! Got char: \\x%d.\n", p); 
-        } 
-
-        u <<= 4;
-        u += c;
-        hex++;
+
+    for (int i = 0; i < nmax; i++) {
+        BYTE c = HEX_NIBBLE[(BYTE)hex[i]];
+        if (c == HEX_BAD) {
+            ERROR("Invalid hex character! Got char: \\x%d.\n", hex[i]);
+        }
+        u = (u << 4) | c;
     }
     return u;
 }
@@ -82,17 +117,65 @@ BYTE get_hex_byte(const char *hex)
 char *byte2hex(const BYTE *byte, size_t nbyte)
 {
     char *hex = init_str(2*nbyte); /* include NULL termination for STRING */
-    char *p = hex;
-    const BYTE *c = byte;
+    byte2hex_into(hex, byte, nbyte);
+    return hex;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Encode 16 bytes to 32 chars at a time: widen each byte to 16 bits, put
+ * its high nibble in the low byte and its low nibble in the high byte, and
+ * look both up in the 16-char alphabet. Returns the bytes consumed. */
+__attribute__((target("avx2")))
+static size_t hex_encode_avx2(char *hex, const BYTE *byte, size_t nbyte,
+        const char *alphabet)
+{
+    const __m256i lut  = _mm256_broadcastsi128_si256(
+                            _mm_loadu_si128((const __m128i *)alphabet)),
+                  mask = _mm256_set1_epi16(0x0F);
+    size_t i = 0;
+
+    for (; i + 16 <= nbyte; i += 16, hex += 32) {
+        __m256i x = _mm256_cvtepu8_epi16(
+                        _mm_loadu_si128((const __m128i *)(byte + i)));
+        __m256i hi = _mm256_srli_epi16(x, 4),
+                lo = _mm256_slli_epi16(_mm256_and_si256(x, mask), 8);
+        x = _mm256_shuffle_epi8(lut, _mm256_or_si256(hi, lo));
+        _mm256_storeu_si256((__m256i *)hex, x);
+    }
+    return i;
+}
+#endif
+
+/* Encode with the given 16-char alphabet */
+static ssize_t hex_encode(char *hex, const BYTE *byte, size_t nbyte,
+        const char *alphabet)
+{
+    size_t i = 0;
+    STATS_START(t0);
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) { i = hex_encode_avx2(hex, byte, nbyte, alphabet); }
+#endif
 
     /* One byte --> 2 hex chars */
-    for (size_t i = 0; i < nbyte; i++)
-    {
-        *p++ = HEX_LUT[*c   >> 0x04]; /* take first nibble (4 bits) */
-        *p++ = HEX_LUT[*c++  & 0x0F]; /* take next  nibble */
+    for (; i < nbyte; i++) {
+        hex[2*i]   = alphabet[byte[i] >> 0x04]; /* take first nibble (4 bits) */
+        hex[2*i+1] = alphabet[byte[i]  & 0x0F]; /* take next  nibble */
     }
+    hex[2*nbyte] = '\0';
 
-    return hex;
+    STATS_STOP(STAT_HEX, t0, nbyte);
+    return 2*nbyte;
+}
+
+ssize_t byte2hex_into(char *hex, const BYTE *byte, size_t nbyte)
+{
+    return hex_encode(hex, byte, nbyte, HEX_UPPER);
+}
+
+ssize_t byte2hex_lower_into(char *hex, const BYTE *byte, size_t nbyte)
+{
+    return hex_encode(hex, byte, nbyte, HEX_LOWER);
 }
 
 /*------------------------------------------------------------------------------ 
@@ -108,18 +191,84 @@ size_t hex2byte(BYTE **byte, const char *hex)
 {
     size_t nchar = strlen(hex);
     if (nchar & 1) { ERROR("Input string is not a valid hex string!"); }
-    size_t nbyte = nchar/2;
 
-    *byte = init_byte(nbyte);     /* allocate memory */
-    BYTE *p = *byte;
+    *byte = init_byte(HEX2BYTE_LEN(nchar));     /* allocate memory */
+    ssize_t nbyte = hex2byte_into(*byte, hex, nchar);
+    if (nbyte < 0) { ERROR("Invalid hex character in string!"); }
+
+    return nbyte;
+}
 
-    /* Take every 2 hex characters and combine bytes to make 1 ASCII char */
-    for (size_t i = 0; i < nbyte; i++)
-    {
-        *p++ = get_hex_byte(hex+2*i);
+#if defined(__x86_64__) || defined(__i386__)
+/* Decode 32 chars to 16 bytes at a time. A char is a digit if it lies in
+ * '0'..'9', or a letter if, with the case bit set, it lies in 'a'..'f'; the
+ * signed compares also reject everything >= 0x80. maddubs then combines each
+ * pair as 16*hi + lo. Returns the chars consumed, or -1. */
+__attribute__((target("avx2")))
+static ssize_t hex_decode_avx2(BYTE *byte, const char *hex, size_t nchar)
+{
+    const __m256i zero = _mm256_set1_epi8('0' - 1),
+                  nine = _mm256_set1_epi8('9' + 1),
+                  a    = _mm256_set1_epi8('a' - 1),
+                  f    = _mm256_set1_epi8('f' + 1),
+                  lcase = _mm256_set1_epi8(0x20),
+                  pair  = _mm256_set1_epi16(0x0110);
+    size_t i = 0;
+
+    for (; i + 32 <= nchar; i += 32, byte += 16) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(hex + i)),
+                l = _mm256_or_si256(c, lcase);
+
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, zero),
+                                         _mm256_cmpgt_epi8(nine, c)),
+                alpha = _mm256_and_si256(_mm256_cmpgt_epi8(l, a),
+                                         _mm256_cmpgt_epi8(f, l));
+        if (~_mm256_movemask_epi8(_mm256_or_si256(digit, alpha))) {
+            return -1;
+        }
+
+        /* '0' -> 0, 'a' -> 10. Digits already have the case bit set. No
+         * blendv: GCC folds it wrongly under -funsigned-char. */
+        __m256i v = _mm256_sub_epi8(
+                _mm256_sub_epi8(l, _mm256_set1_epi8('0')),
+                _mm256_and_si256(alpha, _mm256_set1_epi8('a' - 10 - '0')));
+        v = _mm256_maddubs_epi16(v, pair);
+        v = _mm256_packus_epi16(v, v);
+        v = _mm256_permute4x64_epi64(v, 0x08);
+        _mm_storeu_si128((__m128i *)byte, _mm256_castsi256_si128(v));
     }
+    return i;
+}
+#endif
 
-    return nbyte;
+ssize_t hex2byte_into(BYTE *byte, const char *hex, size_t nchar)
+{
+    if (nchar & 1) { return -1; }
+    const BYTE *h = (const BYTE *)hex;
+    size_t i = 0;
+    STATS_START(t0);
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) {
+        ssize_t n = hex_decode_avx2(byte, hex, nchar);
+        if (n < 0) { return -1; }
+        i = n;
+    }
+#endif
+
+    /* Take every 2 hex characters and combine them to make 1 byte. Errors
+     * are collected and checked once, so the loop has no branches. */
+    BYTE bad = 0;
+    for (; i < nchar; i += 2) {
+        BYTE hi = HEX_NIBBLE[h[i]],
+             lo = HEX_NIBBLE[h[i+1]];
+        bad |= hi | lo;
+        byte[i/2] = (hi << 4) | (lo & 0x0F);
+    }
+    if (bad & 0x80) { return -1; }
+
+    STATS_STOP(STAT_HEX, t0, nchar/2);
+    return nchar/2;
 }
 
 /*------------------------------------------------------------------------------
@@ -0,0 +1,72 @@
+/*==============================================================================
+ *     File: util_cpu.c
+ *  Created: 10/17/2026, 11:04
+ *   Author: Bernie Roesler
+ *
+ *  Description: Runtime detection of CPU instruction set extensions via CPUID
+ *
+ *============================================================================*/
+
+#include "util_cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+/* Feature bits (leaf 1 ecx, leaf 7 ebx) */
+#define CPUID_SSSE3   (1 <<  9)
+#define CPUID_SSE41   (1 << 19)
+#define CPUID_OSXSAVE (1 << 27)
+#define CPUID_AVX     (1 << 28)
+#define CPUID_AESNI   (1 << 25)
+#define CPUID_AVX2    (1 <<  5)
+
+/* Cached CPUID results, filled in on first use */
+static int cpu_probed = 0;
+static unsigned int leaf1_ecx = 0,
+                    leaf7_ebx = 0,
+                    ymm_enabled = 0;
+
+/*------------------------------------------------------------------------------
+ *         Query CPUID once
+ *----------------------------------------------------------------------------*/
+static void cpu_probe(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (cpu_probed) { return; }
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        leaf1_ecx = ecx;
+    }
+
+    if (__get_cpuid_max(0, NULL) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        leaf7_ebx = ebx;
+    }
+
+    /* AVX registers are only usable if the OS saves them on context switch:
+     * XCR0 bits 1 (SSE) and 2 (AVX) must both be set */
+    if ((leaf1_ecx & CPUID_OSXSAVE) && (leaf1_ecx & CPUID_AVX)) {
+        unsigned int xcr0_lo, xcr0_hi;
+        __asm__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+        ymm_enabled = ((xcr0_lo & 0x6) == 0x6);
+    }
+
+    cpu_probed = 1;
+}
+
+int cpu_has_aesni(void) { cpu_probe(); return !!(leaf1_ecx & CPUID_AESNI); }
+int cpu_has_ssse3(void) { cpu_probe(); return !!(leaf1_ecx & CPUID_SSSE3); }
+int cpu_has_sse41(void) { cpu_probe(); return !!(leaf1_ecx & CPUID_SSE41); }
+int cpu_has_avx2(void)  { cpu_probe(); return ymm_enabled && (leaf7_ebx & CPUID_AVX2); }
+
+#else
+/* No x86 extensions anywhere else */
+int cpu_has_aesni(void) { return 0; }
+int cpu_has_ssse3(void) { return 0; }
+int cpu_has_sse41(void) { return 0; }
+int cpu_has_avx2(void)  { return 0; }
+#endif
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,234 @@
+/*==============================================================================
+ *     File: util_hamming.c
+ *  Created: 10/17/2026, 23:24
+ *   Author: Bernie Roesler
+ *
+ *  Description: Popcount kernels. The scalar path counts 64-bit words; the
+ *      AVX2 path counts the nibbles of 32 bytes at once with a shuffle
+ *      table, summing up to 31 steps of byte counts before widening them
+ *      with vpsadbw.
+ *
+ *      The autocorrelation takes HAMMING_CHUNK positions at a time through
+ *      every shift, so the input is read from memory once however many
+ *      shifts there are.
+ *
+ *============================================================================*/
+
+#include "util_hamming.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/* Differing bits, or equal bytes, of a and b over nbyte bytes */
+typedef uint64_t (*PAIR_COUNT)(const BYTE *a, const BYTE *b, size_t nbyte);
+
+/* The same for b, b + 1, b + 2 and b + 3, added to count[0] to count[3] */
+typedef void (*PAIR_COUNT4)(uint64_t *count, const BYTE *a, const BYTE *b,
+        size_t nbyte);
+
+/*------------------------------------------------------------------------------
+ *         Kernels
+ *----------------------------------------------------------------------------*/
+static uint64_t pop_xor_scalar(const BYTE *a, const BYTE *b, size_t nbyte)
+{
+    uint64_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= nbyte; i += 8) {
+        uint64_t u, v;
+        memcpy(&u, a + i, 8);
+        memcpy(&v, b + i, 8);
+        count += __builtin_popcountll(u ^ v);
+    }
+    for (; i < nbyte; i++) { count += __builtin_popcount(a[i] ^ b[i]); }
+    return count;
+}
+
+/* Zero bytes of a ^ b: the high bit of each byte of z is set if the byte
+ * of x is zero */
+static uint64_t eq_count_scalar(const BYTE *a, const BYTE *b, size_t nbyte)
+{
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= nbyte; i += 8) {
+        uint64_t u, v;
+        memcpy(&u, a + i, 8);
+        memcpy(&v, b + i, 8);
+        uint64_t x = u ^ v,
+                 z = ~(((x & low7) + low7) | x | low7);
+        count += __builtin_popcountll(z);
+    }
+    for (; i < nbyte; i++) { count += (a[i] == b[i]); }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Sum of the four 64-bit lanes */
+__attribute__((target("avx2")))
+static inline uint64_t sum_epi64(__m256i v)
+{
+    uint64_t lane[4];
+    _mm256_storeu_si256((__m256i *)lane, v);
+    return lane[0] + lane[1] + lane[2] + lane[3];
+}
+
+__attribute__((target("avx2")))
+static uint64_t eq_count_avx2(const BYTE *a, const BYTE *b, size_t nbyte)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i total = zero;
+
+    size_t i = 0;
+    while (i + 32 <= nbyte) {
+        /* Equal bytes are -1; 255 steps fit in a byte */
+        __m256i acc = zero;
+        for (int j = 0; j < 255 && i + 32 <= nbyte; j++, i += 32) {
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(
+                        _mm256_loadu_si256((const __m256i *)(a + i)),
+                        _mm256_loadu_si256((const __m256i *)(b + i))));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(acc, zero));
+    }
+
+    return sum_epi64(total) + eq_count_scalar(a + i, b + i, nbyte - i);
+}
+
+/* count[j] += equal bytes of a and b + j, for j = 0 to 3: four shifts
+ * sharing each load of a. b is read to nbyte + 3. */
+__attribute__((target("avx2")))
+static void eq_count4_avx2(uint64_t *count, const BYTE *a, const BYTE *b,
+        size_t nbyte)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i t0 = zero, t1 = zero, t2 = zero, t3 = zero;
+
+    size_t i = 0;
+    while (i + 32 <= nbyte) {
+        __m256i c0 = zero, c1 = zero, c2 = zero, c3 = zero;
+        for (int j = 0; j < 255 && i + 32 <= nbyte; j++, i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            const BYTE *y = b + i;
+            c0 = _mm256_sub_epi8(c0, _mm256_cmpeq_epi8(x,
+                        _mm256_loadu_si256((const __m256i *)(y))));
+            c1 = _mm256_sub_epi8(c1, _mm256_cmpeq_epi8(x,
+                        _mm256_loadu_si256((const __m256i *)(y + 1))));
+            c2 = _mm256_sub_epi8(c2, _mm256_cmpeq_epi8(x,
+                        _mm256_loadu_si256((const __m256i *)(y + 2))));
+            c3 = _mm256_sub_epi8(c3, _mm256_cmpeq_epi8(x,
+                        _mm256_loadu_si256((const __m256i *)(y + 3))));
+        }
+        t0 = _mm256_add_epi64(t0, _mm256_sad_epu8(c0, zero));
+        t1 = _mm256_add_epi64(t1, _mm256_sad_epu8(c1, zero));
+        t2 = _mm256_add_epi64(t2, _mm256_sad_epu8(c2, zero));
+        t3 = _mm256_add_epi64(t3, _mm256_sad_epu8(c3, zero));
+    }
+
+    count[0] += sum_epi64(t0) + eq_count_scalar(a + i, b + i,     nbyte - i);
+    count[1] += sum_epi64(t1) + eq_count_scalar(a + i, b + i + 1, nbyte - i);
+    count[2] += sum_epi64(t2) + eq_count_scalar(a + i, b + i + 2, nbyte - i);
+    count[3] += sum_epi64(t3) + eq_count_scalar(a + i, b + i + 3, nbyte - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t pop_xor_avx2(const BYTE *a, const BYTE *b, size_t nbyte)
+{
+    const __m256i lut = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nib  = _mm256_set1_epi8(0x0F),
+                  zero = _mm256_setzero_si256();
+    __m256i total = zero;
+
+    size_t i = 0;
+    while (i + 32 <= nbyte) {
+        /* At most 8 per byte a step, so 31 steps fit in a byte */
+        __m256i acc = zero;
+        for (int j = 0; j < 31 && i + 32 <= nbyte; j++, i += 32) {
+            __m256i x = _mm256_xor_si256(
+                    _mm256_loadu_si256((const __m256i *)(a + i)),
+                    _mm256_loadu_si256((const __m256i *)(b + i)));
+            __m256i lo = _mm256_and_si256(x, nib),
+                    hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nib);
+            acc = _mm256_add_epi8(acc, _mm256_add_epi8(
+                        _mm256_shuffle_epi8(lut, lo),
+                        _mm256_shuffle_epi8(lut, hi)));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(acc, zero));
+    }
+
+    return sum_epi64(total) + pop_xor_scalar(a + i, b + i, nbyte - i);
+}
+#endif
+
+static PAIR_COUNT pop_xor_best(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) { return pop_xor_avx2; }
+#endif
+    return pop_xor_scalar;
+}
+
+/* count4, if any, does four shifts at once */
+static void autocorr(uint64_t *dist, const BYTE *byte, size_t nbyte,
+        size_t max_shift, PAIR_COUNT count, PAIR_COUNT4 count4)
+{
+    BZERO(dist, (max_shift + 1)*sizeof(uint64_t));
+
+    for (size_t c = 0; c < nbyte; c += HAMMING_CHUNK) {
+        size_t end = MIN(nbyte, c + HAMMING_CHUNK),
+               s = 1;
+        /* While all four shifts pair every position of the chunk */
+        if (count4) {
+            for (; s + 3 <= max_shift && end + s + 3 <= nbyte; s += 4) {
+                count4(dist + s, byte + c, byte + c + s, end - c);
+            }
+        }
+        /* Positions i in [c, end) with i + s < nbyte */
+        for (; s <= max_shift && c + s < nbyte; s++) {
+            size_t e = MIN(end, nbyte - s);
+            dist[s] += count(byte + c, byte + c + s, e - c);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         Public interface
+ *----------------------------------------------------------------------------*/
+size_t hamming_xor(const BYTE *a, const BYTE *b, size_t nbyte)
+{
+    return pop_xor_best()(a, b, nbyte);
+}
+
+void hamming_autocorr(uint64_t *dist, const BYTE *byte, size_t nbyte,
+        size_t max_shift)
+{
+    autocorr(dist, byte, nbyte, max_shift, pop_xor_best(), NULL);
+}
+
+void hamming_autocorr_scalar(uint64_t *dist, const BYTE *byte, size_t nbyte,
+        size_t max_shift)
+{
+    autocorr(dist, byte, nbyte, max_shift, pop_xor_scalar, NULL);
+}
+
+void coincidence_autocorr(uint64_t *count, const BYTE *byte, size_t nbyte,
+        size_t max_shift)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) {
+        autocorr(count, byte, nbyte, max_shift, eq_count_avx2, eq_count4_avx2);
+        return;
+    }
+#endif
+    autocorr(count, byte, nbyte, max_shift, eq_count_scalar, NULL);
+}
+
+void coincidence_autocorr_scalar(uint64_t *count, const BYTE *byte,
+        size_t nbyte, size_t max_shift)
+{
+    autocorr(count, byte, nbyte, max_shift, eq_count_scalar, NULL);
+}
+
+/*==============================================================================
+ *============================================================================*/
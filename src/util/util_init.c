@@ -9,6 +9,33 @@
 
 #include "util_init.h"
 
+/* Arena memory not handed out is poisoned for AddressSanitizer, and each
+ * allocation is followed by a poisoned redzone to catch overruns */
+#if defined(__SANITIZE_ADDRESS__)
+#define ARENA_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ARENA_ASAN
+#endif
+#endif
+
+#ifdef ARENA_ASAN
+#include <sanitizer/asan_interface.h>
+#define ARENA_REDZONE ARENA_ALIGN
+#else
+#define ASAN_POISON_MEMORY_REGION(p, n)   ((void)(p), (void)(n))
+#define ASAN_UNPOISON_MEMORY_REGION(p, n) ((void)(p), (void)(n))
+#define ARENA_REDZONE 0
+#endif
+
+/* Round n up to a multiple of ARENA_ALIGN */
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/* Chunk data starts just past its header; the first chunk sits just past the
+ * arena itself, in the same malloc */
+#define CHUNK_DATA(c)  ((BYTE *)(c) + ARENA_ROUND(sizeof(ARENA_CHUNK)))
+#define ARENA_FIRST(a) ((ARENA_CHUNK *)((BYTE *)(a) + ARENA_ROUND(sizeof(ARENA))))
+
 /*------------------------------------------------------------------------------
  *         Allocate memory for string
  *----------------------------------------------------------------------------*/
@@ -16,6 +43,7 @@ char *init_str(size_t len)
 {
     char *buffer = calloc(len+1, sizeof(char));
     MALLOC_CHECK(buffer);
+    STATS_COUNT(STAT_ALLOC, len+1);
     return buffer;
 }
 
@@ -51,6 +79,7 @@ BYTE *init_byte(size_t len)
 {
     BYTE *buffer = calloc(len+1, sizeof(BYTE));
     MALLOC_CHECK(buffer);
+    STATS_COUNT(STAT_ALLOC, len+1);
     return buffer;
 }
 
@@ -73,9 +102,131 @@ int *init_int(size_t len)
 {
     int *buffer = calloc(len, sizeof(int));
     MALLOC_CHECK(buffer);
+    STATS_COUNT(STAT_ALLOC, len*sizeof(int));
     return buffer;
 }
 
+/*------------------------------------------------------------------------------
+ *         Arena allocator
+ *----------------------------------------------------------------------------*/
+static void init_chunk(ARENA_CHUNK *c, ARENA_CHUNK *prev, size_t size)
+{
+    c->prev = prev;
+    c->size = size;
+    c->used = 0;
+    ASAN_POISON_MEMORY_REGION(CHUNK_DATA(c), size);
+}
+
+ARENA *init_arena(size_t size, int flags)
+{
+    size = ARENA_ROUND(size);
+    ARENA *a = malloc(ARENA_ROUND(sizeof(ARENA))
+                      + ARENA_ROUND(sizeof(ARENA_CHUNK)) + size);
+    MALLOC_CHECK(a);
+
+    a->head = ARENA_FIRST(a);
+    a->chunk_size = size;
+    a->flags = flags;
+    a->n_alloc = 0;
+    a->n_chunk = 1;
+    init_chunk(a->head, NULL, size);
+    return a;
+}
+
+void free_arena(ARENA *a)
+{
+    if (!a) { return; }
+    arena_reset(a);
+    ASAN_UNPOISON_MEMORY_REGION(CHUNK_DATA(a->head), a->head->size);
+    free(a);
+}
+
+ARENA_MARK arena_push(const ARENA *a)
+{
+    ARENA_MARK mark = { a->head, a->head->used };
+    return mark;
+}
+
+void arena_pop(ARENA *a, ARENA_MARK mark)
+{
+    /* Drop whole chunks allocated since the mark */
+    while (a->head != mark.chunk) {
+        ARENA_CHUNK *c = a->head;
+        a->head = c->prev;
+        ASAN_UNPOISON_MEMORY_REGION(CHUNK_DATA(c), c->size);
+        free(c);
+    }
+
+    /* Give back the rest, poisoned so stale pointers show */
+    BYTE *p = CHUNK_DATA(a->head) + mark.used;
+    size_t n = a->head->used - mark.used;
+    if (a->flags & ARENA_POISON) {
+        ASAN_UNPOISON_MEMORY_REGION(p, n);
+        memset(p, ARENA_POISON_BYTE, n);
+    }
+    ASAN_POISON_MEMORY_REGION(p, n);
+    a->head->used = mark.used;
+}
+
+void arena_reset(ARENA *a)
+{
+    ARENA_MARK start = { ARENA_FIRST(a), 0 };
+    arena_pop(a, start);
+}
+
+void *arena_alloc(ARENA *a, size_t len)
+{
+    size_t need = ARENA_ROUND(len + ARENA_REDZONE);
+    ARENA_CHUNK *c = a->head;
+
+    /* Start a new chunk when this one is full */
+    if (c->used + need > c->size) {
+        size_t size = (need > a->chunk_size) ? need : a->chunk_size;
+        ARENA_CHUNK *next = malloc(ARENA_ROUND(sizeof(ARENA_CHUNK)) + size);
+        MALLOC_CHECK(next);
+        init_chunk(next, c, size);
+        a->head = c = next;
+        a->n_chunk++;
+    }
+
+    BYTE *p = CHUNK_DATA(c) + c->used;
+    c->used += need;
+    a->n_alloc++;
+    STATS_COUNT(STAT_ARENA, len);
+
+    ASAN_UNPOISON_MEMORY_REGION(p, len);
+    if (a->flags & ARENA_ZERO) { memset(p, 0, len); }
+    return p;
+}
+
+char *arena_str(ARENA *a, size_t len)
+{
+    char *buffer = arena_alloc(a, len+1);
+    buffer[len] = '\0';
+    return buffer;
+}
+
+BYTE *arena_byte(ARENA *a, size_t len)
+{
+    BYTE *buffer = arena_alloc(a, len+1);
+    buffer[len] = '\0';
+    return buffer;
+}
+
+BYTE *arena_rand_byte(ARENA *a, size_t len)
+{
+    BYTE *key = arena_byte(a, len);
+    for (size_t i = 0; i < len; i++) {
+        key[i] = rand() % 0x100;     /* generate random byte [0x00,0xFF] */ 
+    }
+    return key;
+}
+
+int *arena_int(ARENA *a, size_t len)
+{
+    return arena_alloc(a, len*sizeof(int));
+}
+
 /*------------------------------------------------------------------------------
  *         Repeat byte array to fill nbyte array
  *----------------------------------------------------------------------------*/
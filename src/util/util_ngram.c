@@ -0,0 +1,306 @@
+/*==============================================================================
+ *     File: util_ngram.c
+ *  Created: 10/17/2026, 22:12
+ *   Author: Bernie Roesler
+ *
+ *  Description: N-gram language models: training, mapping the table file,
+ *      and scoring. Each position adds three table lookups, so scoring is
+ *      done in 8 lanes; the AVX2 path gathers a lane per position and adds
+ *      in the same order as the scalar code, giving identical scores.
+ *
+ *============================================================================*/
+#include <fcntl.h>
+#include <float.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "util_ngram.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/* Table entries and file size */
+#define NGRAM_N_BI  (NGRAM_SYMS*NGRAM_SYMS)
+#define NGRAM_N_TRI (NGRAM_SYMS*NGRAM_SYMS*NGRAM_SYMS)
+#define NGRAM_FILE_LEN (sizeof(NGRAM_HEADER) + 256                           \
+        + sizeof(float)*(256 + NGRAM_N_BI + NGRAM_N_TRI))
+
+/* Byte classes */
+#define SYM_SPACE   26
+#define SYM_DIGIT   27
+#define SYM_PUNCT   28
+#define SYM_PRINT   29
+#define SYM_NEWLINE 30
+#define SYM_OTHER   31
+
+/* Added to every count when training */
+#define NGRAM_SMOOTH 0.5
+
+/* Positions summed in separate lanes */
+#define NGRAM_LANES 8
+
+/*------------------------------------------------------------------------------
+ *         Training
+ *----------------------------------------------------------------------------*/
+static BYTE sym_of(int b)
+{
+    if (isalpha(b))                   { return tolower(b) - 'a'; }
+    if (b == ' ')                     { return SYM_SPACE; }
+    if (isdigit(b))                   { return SYM_DIGIT; }
+    if (b && strchr(".,;:!?", b))     { return SYM_PUNCT; }
+    if (b == '\n' || b == '\t')       { return SYM_NEWLINE; }
+    if (isprint(b))                   { return SYM_PRINT; }
+    return SYM_OTHER;
+}
+
+int ngram_train(const char *path, const BYTE *corpus, size_t nbyte)
+{
+    const double k = NGRAM_SMOOTH;
+    const size_t S = NGRAM_SYMS;
+
+    BYTE sym[256];
+    for (int b = 0; b < 256; b++) { sym[b] = sym_of(b); }
+
+    /* Count bytes, class pairs and class triples */
+    double *c1 = calloc(256 + NGRAM_N_BI + NGRAM_N_TRI, sizeof(double));
+    MALLOC_CHECK(c1);
+    double *c2 = c1 + 256,
+           *c3 = c2 + NGRAM_N_BI;
+
+    for (size_t i = 0; i < nbyte; i++) {
+        size_t s0 = sym[corpus[i]];
+        c1[corpus[i]]++;
+        if (i >= 1) {
+            size_t s1 = sym[corpus[i-1]];
+            c2[s1*S + s0]++;
+            if (i >= 2) { c3[(sym[corpus[i-2]]*S + s1)*S + s0]++; }
+        }
+    }
+
+    float *uni = malloc(sizeof(float)*(256 + NGRAM_N_BI + NGRAM_N_TRI));
+    MALLOC_CHECK(uni);
+    float *bi  = uni + 256,
+          *tri = bi + NGRAM_N_BI;
+
+    /* log P(b), and log P(s) as the sum over the bytes of s */
+    double ps[NGRAM_SYMS] = { 0 };
+    for (int b = 0; b < 256; b++) {
+        double p = (c1[b] + k) / (nbyte + 256*k);
+        uni[b] = log(p);
+        ps[sym[b]] += p;
+    }
+
+    /* log P(s | s1) - log P(s) */
+    double p_bi[NGRAM_N_BI];
+    for (size_t a = 0; a < S; a++) {
+        double ctx = 0;
+        for (size_t s = 0; s < S; s++) { ctx += c2[a*S + s]; }
+        for (size_t s = 0; s < S; s++) {
+            p_bi[a*S + s] = log((c2[a*S + s] + k) / (ctx + S*k));
+            bi[a*S + s] = p_bi[a*S + s] - log(ps[s]);
+        }
+    }
+
+    /* log P(s | s2 s1) - log P(s | s1) */
+    for (size_t ab = 0; ab < NGRAM_N_BI; ab++) {
+        double ctx = 0;
+        for (size_t s = 0; s < S; s++) { ctx += c3[ab*S + s]; }
+        for (size_t s = 0; s < S; s++) {
+            double p = log((c3[ab*S + s] + k) / (ctx + S*k));
+            tri[ab*S + s] = p - p_bi[(ab % S)*S + s];
+        }
+    }
+
+    NGRAM_HEADER h;
+    BZERO(&h, sizeof(h));
+    h.magic   = NGRAM_MAGIC;
+    h.version = NGRAM_VERSION;
+    h.order   = NGRAM_MAX_ORDER;
+    h.n_sym   = NGRAM_SYMS;
+
+    int err = -1;
+    FILE *fp = fopen(path, "wb");
+    if (fp) {
+        size_t n_float = 256 + NGRAM_N_BI + NGRAM_N_TRI;
+        int ok = fwrite(&h, sizeof(h), 1, fp) == 1
+              && fwrite(sym, 1, 256, fp) == 256
+              && fwrite(uni, sizeof(float), n_float, fp) == n_float;
+        err = (fclose(fp) == 0 && ok) ? 0 : -1;
+    }
+
+    free(c1);
+    free(uni);
+    return err;
+}
+
+/*------------------------------------------------------------------------------
+ *         Loading
+ *----------------------------------------------------------------------------*/
+NGRAM *ngram_load(const char *path, int order)
+{
+    if (order < 1 || order > NGRAM_MAX_ORDER) {
+        ERROR("N-gram order %d not in [1, %d]!", order, NGRAM_MAX_ORDER);
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { return NULL; }
+
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size != NGRAM_FILE_LEN) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, NGRAM_FILE_LEN, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { return NULL; }
+
+    const NGRAM_HEADER *h = map;
+    if (h->magic != NGRAM_MAGIC || h->version != NGRAM_VERSION
+            || h->n_sym != NGRAM_SYMS || h->order < (uint32_t)order) {
+        munmap(map, NGRAM_FILE_LEN);
+        return NULL;
+    }
+
+    /* Classes index the tables, so each must be in range */
+    const BYTE *sym = (const BYTE *)(h + 1);
+    for (int b = 0; b < 256; b++) {
+        if (sym[b] >= NGRAM_SYMS) {
+            munmap(map, NGRAM_FILE_LEN);
+            return NULL;
+        }
+    }
+
+    NGRAM *m = NEW(NGRAM);
+    MALLOC_CHECK(m);
+    m->sym = sym;
+    m->uni = (const float *)(m->sym + 256);
+    m->bi  = m->uni + 256;
+    m->tri = m->bi + NGRAM_N_BI;
+    for (int b = 0; b < 256; b++) { m->sym32[b] = m->sym[b]; }
+    m->order = order;
+    m->map = map;
+    m->map_len = NGRAM_FILE_LEN;
+    return m;
+}
+
+void ngram_free(NGRAM *m)
+{
+    if (!m) { return; }
+    munmap(m->map, m->map_len);
+    free(m);
+}
+
+/*------------------------------------------------------------------------------
+ *         Scoring
+ *----------------------------------------------------------------------------*/
+/* Add the terms of positions [i, end) into lane i % NGRAM_LANES */
+static void score_range(const NGRAM *m, const BYTE *byte, size_t i,
+        size_t end, BYTE key, float *acc)
+{
+    for (; i < end; i++) {
+        BYTE b0 = byte[i] ^ key;
+        float t = m->uni[b0];
+        if (m->order >= 2 && i >= 1) {
+            size_t s0 = m->sym[b0],
+                   s1 = m->sym[byte[i-1] ^ key];
+            t += m->bi[s1*NGRAM_SYMS + s0];
+            if (m->order >= 3 && i >= 2) {
+                size_t s2 = m->sym[byte[i-2] ^ key];
+                t += m->tri[(s2*NGRAM_SYMS + s1)*NGRAM_SYMS + s0];
+            }
+        }
+        acc[i % NGRAM_LANES] += t;
+    }
+}
+
+static float score_reduce(const float *acc, size_t nbyte)
+{
+    float sum = 0;
+    for (int j = 0; j < NGRAM_LANES; j++) { sum += acc[j]; }
+    return -sum / nbyte;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Classes of the 8 bytes at p, XOR-ed with key */
+__attribute__((target("avx2")))
+static inline __m256i sym8(const NGRAM *m, const BYTE *p, __m128i key,
+        __m256i *b)
+{
+    *b = _mm256_cvtepu8_epi32(
+            _mm_xor_si128(_mm_loadl_epi64((const __m128i *)p), key));
+    return _mm256_i32gather_epi32(m->sym32, *b, 4);
+}
+
+/* Whole blocks of positions from 8 on, where every lane has its full
+ * context. Returns the first position not done. */
+__attribute__((target("avx2")))
+static size_t score_avx2(const NGRAM *m, const BYTE *byte, size_t nbyte,
+        BYTE key, float *acc)
+{
+    const __m128i vkey = _mm_set1_epi8((char)key);
+    __m256 vacc = _mm256_loadu_ps(acc);
+
+    size_t i = NGRAM_LANES;
+    for (; i + NGRAM_LANES <= nbyte; i += NGRAM_LANES) {
+        __m256i b0, b1, b2;
+        __m256i s0 = sym8(m, byte + i, vkey, &b0);
+        __m256 t = _mm256_i32gather_ps(m->uni, b0, 4);
+        if (m->order >= 2) {
+            __m256i s1 = sym8(m, byte + i - 1, vkey, &b1);
+            __m256i ctx = _mm256_slli_epi32(s1, 5);
+            t = _mm256_add_ps(t, _mm256_i32gather_ps(m->bi,
+                        _mm256_add_epi32(ctx, s0), 4));
+            if (m->order >= 3) {
+                __m256i s2 = sym8(m, byte + i - 2, vkey, &b2);
+                ctx = _mm256_slli_epi32(_mm256_add_epi32(
+                            _mm256_slli_epi32(s2, 5), s1), 5);
+                t = _mm256_add_ps(t, _mm256_i32gather_ps(m->tri,
+                            _mm256_add_epi32(ctx, s0), 4));
+            }
+        }
+        vacc = _mm256_add_ps(vacc, t);
+    }
+
+    _mm256_storeu_ps(acc, vacc);
+    return i;
+}
+#endif
+
+float ngram_score_xor(const NGRAM *m, const BYTE *byte, size_t nbyte,
+        BYTE key)
+{
+    if (!nbyte) { return FLT_MAX; }
+
+    float acc[NGRAM_LANES] = { 0 };
+    size_t i = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (nbyte >= 2*NGRAM_LANES && cpu_has_avx2()) {
+        score_range(m, byte, 0, NGRAM_LANES, key, acc);
+        i = score_avx2(m, byte, nbyte, key, acc);
+    }
+#endif
+
+    score_range(m, byte, i, nbyte, key, acc);
+    return score_reduce(acc, nbyte);
+}
+
+float ngram_score(const NGRAM *m, const BYTE *byte, size_t nbyte)
+{
+    return ngram_score_xor(m, byte, nbyte, 0);
+}
+
+float ngram_score_scalar(const NGRAM *m, const BYTE *byte, size_t nbyte)
+{
+    if (!nbyte) { return FLT_MAX; }
+
+    float acc[NGRAM_LANES] = { 0 };
+    score_range(m, byte, 0, nbyte, 0, acc);
+    return score_reduce(acc, nbyte);
+}
+
+/*==============================================================================
+ *============================================================================*/
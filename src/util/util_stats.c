@@ -0,0 +1,159 @@
+/*==============================================================================
+ *     File: util_stats.c
+ *  Created: 10/17/2026, 16:24
+ *   Author: Bernie Roesler
+ *
+ *  Description: Counters behind the STATS_* macros, and their JSON dump
+ *
+ *============================================================================*/
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "header.h"
+#include "util_stats.h"
+
+/* Room for the JSON text of every counter */
+#define STATS_JSON_LEN 2048
+
+typedef struct _STAT {
+    uint64_t calls, bytes, ticks;
+} STAT;
+
+static const char * const STAT_NAME[STAT_COUNT] = {
+    "alloc", "arena", "aes", "oracle", "hex", "b64", "xor"
+};
+
+/* Updated from parallel_for workers too, so every add is atomic */
+static STAT stats[STAT_COUNT];
+
+/*------------------------------------------------------------------------------
+ *         Format the counters as JSON
+ *----------------------------------------------------------------------------*/
+/* Hand-written rather than snprintf, which is not async-signal-safe. Each
+ * appends to buf at *n, stopping short of len - 1. */
+static void json_str(char *buf, size_t len, size_t *n, const char *str)
+{
+    for (; *str && *n + 1 < len; str++) { buf[(*n)++] = *str; }
+}
+
+static void json_u64(char *buf, size_t len, size_t *n, uint64_t x)
+{
+    char digit[20];
+    int k = 0;
+    do { digit[k++] = '0' + x % 10; x /= 10; } while (x);
+    while (k && *n + 1 < len) { buf[(*n)++] = digit[--k]; }
+}
+
+/* NUL-terminated; returns the length */
+static size_t stats_json(char *buf, size_t len)
+{
+    size_t n = 0;
+
+#ifdef UTIL_STATS
+    const char *clock = UTIL_STATS_CLOCK;
+#else
+    const char *clock = "none";
+#endif
+
+    json_str(buf, len, &n, "{\"clock\": \"");
+    json_str(buf, len, &n, clock);
+    json_str(buf, len, &n, "\"");
+    for (int i = 0; i < STAT_COUNT; i++) {
+        STAT s;
+        s.calls = __atomic_load_n(&stats[i].calls, __ATOMIC_RELAXED);
+        s.bytes = __atomic_load_n(&stats[i].bytes, __ATOMIC_RELAXED);
+        s.ticks = __atomic_load_n(&stats[i].ticks, __ATOMIC_RELAXED);
+        json_str(buf, len, &n, ", \"");
+        json_str(buf, len, &n, STAT_NAME[i]);
+        json_str(buf, len, &n, "\": {\"calls\": ");
+        json_u64(buf, len, &n, s.calls);
+        json_str(buf, len, &n, ", \"bytes\": ");
+        json_u64(buf, len, &n, s.bytes);
+        json_str(buf, len, &n, ", \"ticks\": ");
+        json_u64(buf, len, &n, s.ticks);
+        json_str(buf, len, &n, "}");
+    }
+    json_str(buf, len, &n, "}\n");
+    buf[n] = '\0';
+
+    return n;
+}
+
+/*------------------------------------------------------------------------------
+ *         Dump at exit and on SIGUSR1
+ *----------------------------------------------------------------------------*/
+/* UTIL_STATS_ENV, copied when the dump is registered; empty for stderr */
+static char stats_path[4096];
+
+/* No stdio, allocation or getenv: only open(2), write(2) and close(2), which
+ * are async-signal-safe, so the signal handler may call it */
+static void stats_write(void)
+{
+    char buf[STATS_JSON_LEN];
+    size_t n = stats_json(buf, sizeof(buf));
+
+    int fd = *stats_path ? open(stats_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+                         : STDERR_FILENO;
+    if (fd < 0) { return; }
+    if (write(fd, buf, n) < 0) { /* nothing left to report it to */ }
+    if (fd != STDERR_FILENO) { close(fd); }
+}
+
+static void stats_signal(int sig)
+{
+    (void)sig;
+    int saved = errno;
+    stats_write();
+    errno = saved;
+}
+
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+
+static void stats_register(void)
+{
+    /* A path too long to copy whole falls back to stderr */
+    const char *path = getenv(UTIL_STATS_ENV);
+    if (path && strlen(path) < sizeof(stats_path)) { strcpy(stats_path, path); }
+
+    struct sigaction sa;
+    BZERO(&sa, sizeof(sa));
+    sa.sa_handler = stats_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    atexit(stats_write);
+}
+
+/*------------------------------------------------------------------------------
+ *         Public interface
+ *----------------------------------------------------------------------------*/
+void util_stats_add(STAT_ID id, uint64_t nbyte, uint64_t ticks)
+{
+    pthread_once(&stats_once, stats_register);
+    __atomic_fetch_add(&stats[id].calls, 1,     __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats[id].bytes, nbyte, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats[id].ticks, ticks, __ATOMIC_RELAXED);
+}
+
+void util_stats_dump(FILE *stream)
+{
+    char buf[STATS_JSON_LEN];
+    stats_json(buf, sizeof(buf));
+    fputs(buf, stream);
+}
+
+void util_stats_reset(void)
+{
+    for (int i = 0; i < STAT_COUNT; i++) {
+        __atomic_store_n(&stats[i].calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats[i].bytes, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats[i].ticks, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -37,6 +37,12 @@ int *count_chars(const BYTE *s, size_t nbyte)
     return cf;
 }
 
+void count_bytes(size_t *hist, const BYTE *s, size_t nbyte)
+{
+    BZERO(hist, NUM_BYTES*sizeof(size_t));
+    for (size_t i = 0; i < nbyte; i++) { hist[s[i]]++; }
+}
+
 /*------------------------------------------------------------------------------
  *         Hamming weight of byte array 
  *----------------------------------------------------------------------------*/
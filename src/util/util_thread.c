@@ -0,0 +1,109 @@
+/*==============================================================================
+ *     File: util_thread.c
+ *  Created: 10/17/2026, 14:44
+ *   Author: Bernie Roesler
+ *
+ *  Description: Minimal pthreads helpers for splitting work across cores
+ *
+ *============================================================================*/
+#include <pthread.h>
+#include <unistd.h>
+
+#include "util_thread.h"
+
+/* Upper bound on threads for one parallel_for call */
+#define MAX_THREADS 64
+
+/*------------------------------------------------------------------------------
+ *         Number of worker threads
+ *----------------------------------------------------------------------------*/
+/* sysconf reads /sys on Linux, far slower than a small decryption, so the
+ * CPU count is looked up once */
+static long n_cpus = 0;
+static pthread_once_t n_cpus_once = PTHREAD_ONCE_INIT;
+
+static void count_cpus(void)
+{
+    n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+int util_nthreads(void)
+{
+    const char *env = getenv(THREADS_ENV);
+    long n = 0;
+
+    if (env && *env) {
+        n = strtol(env, NULL, 10);
+    } else {
+        pthread_once(&n_cpus_once, count_cpus);
+        n = n_cpus;
+    }
+
+    if (n < 1) { n = 1; }
+    if (n > MAX_THREADS) { n = MAX_THREADS; }
+    return (int)n;
+}
+
+/*------------------------------------------------------------------------------
+ *         Run a function over sub-ranges in parallel
+ *----------------------------------------------------------------------------*/
+typedef struct _RANGE_TASK {
+    void (*fn)(size_t, size_t, void *);
+    void *arg;
+    size_t start, end;
+} RANGE_TASK;
+
+static void *range_worker(void *task)
+{
+    RANGE_TASK *t = (RANGE_TASK *)task;
+    t->fn(t->start, t->end, t->arg);
+    return NULL;
+}
+
+void parallel_for(size_t n, size_t min_chunk, int n_threads,
+        void (*fn)(size_t start, size_t end, void *arg), void *arg)
+{
+    pthread_t tid[MAX_THREADS];
+    RANGE_TASK task[MAX_THREADS] = {{0}};
+    size_t n_tasks = n_threads < 1 ? 1 : MIN((size_t)n_threads, MAX_THREADS);
+
+    if (!n) { return; }
+
+    /* Never split finer than min_chunk items */
+    if (min_chunk && n / min_chunk < n_tasks) {
+        n_tasks = n / min_chunk ? n / min_chunk : 1;
+    }
+
+    if (n_tasks == 1) {
+        fn(0, n, arg);
+        return;
+    }
+
+    /* Spread the remainder over the first n % n_tasks ranges */
+    size_t per = n / n_tasks,
+           extra = n % n_tasks,
+           start = 0;
+    for (size_t i = 0; i < n_tasks; i++) {
+        task[i].fn = fn;
+        task[i].arg = arg;
+        task[i].start = start;
+        task[i].end = start + per + (i < extra);
+        start = task[i].end;
+    }
+
+    /* Worker threads take ranges 1..n_tasks-1, this thread takes range 0 */
+    for (size_t i = 1; i < n_tasks; i++) {
+        if (pthread_create(&tid[i], NULL, range_worker, &task[i])) {
+            ERROR("Could not create thread!");
+        }
+    }
+
+    range_worker(&task[0]);
+
+    for (size_t i = 1; i < n_tasks; i++) {
+        pthread_join(tid[i], NULL);
+    }
+}
+
+/*==============================================================================
+ *============================================================================*/
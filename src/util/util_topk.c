@@ -0,0 +1,88 @@
+/*==============================================================================
+ *     File: util_topk.c
+ *  Created: 10/17/2026, 21:14
+ *   Author: Bernie Roesler
+ *
+ *  Description: Bounded heap keeping the k lowest-scoring candidates seen
+ *
+ *============================================================================*/
+#include <math.h>
+
+#include "util_topk.h"
+
+/* a ranks below (is worse than) b */
+static int topk_worse(const TOPK_ITEM *a, const TOPK_ITEM *b)
+{
+    return (a->score > b->score)
+        || (a->score == b->score && a->value > b->value);
+}
+
+static void topk_swap(TOPK_ITEM *a, TOPK_ITEM *b)
+{
+    TOPK_ITEM t = *a;
+    *a = *b;
+    *b = t;
+}
+
+/* Restore the heap below i, over the first n items */
+static void sift_down(TOPK_ITEM *item, size_t i, size_t n)
+{
+    for (;;) {
+        size_t l = 2*i + 1,
+               r = l + 1,
+               m = i;
+        if (l < n && topk_worse(&item[l], &item[m])) { m = l; }
+        if (r < n && topk_worse(&item[r], &item[m])) { m = r; }
+        if (m == i) { return; }
+        topk_swap(&item[i], &item[m]);
+        i = m;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ *         Public interface
+ *----------------------------------------------------------------------------*/
+void topk_init(TOPK *top, size_t k)
+{
+    if (k < 1 || k > TOPK_MAX) {
+        ERROR("Top-k size %zu not in [1, %d]!", k, TOPK_MAX);
+    }
+    top->n = 0;
+    top->k = k;
+}
+
+void topk_push(TOPK *top, float score, size_t value)
+{
+    if (isnan(score)) { return; }
+    TOPK_ITEM x = { score, value };
+
+    /* Room left: add at the bottom and sift up */
+    if (top->n < top->k) {
+        size_t i = top->n++;
+        top->item[i] = x;
+        while (i > 0 && topk_worse(&top->item[i], &top->item[(i-1)/2])) {
+            topk_swap(&top->item[i], &top->item[(i-1)/2]);
+            i = (i-1)/2;
+        }
+        return;
+    }
+
+    /* Full: replace the worst item if x beats it */
+    if (topk_worse(&top->item[0], &x)) {
+        top->item[0] = x;
+        sift_down(top->item, 0, top->n);
+    }
+}
+
+size_t topk_sort(TOPK *top)
+{
+    /* Heap sort: the worst item goes to the end each time */
+    for (size_t n = top->n; n > 1; n--) {
+        topk_swap(&top->item[0], &top->item[n-1]);
+        sift_down(top->item, 0, n-1);
+    }
+    return top->n;
+}
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,189 @@
+/*==============================================================================
+ *     File: util_xor.c
+ *  Created: 10/17/2026, 20:09
+ *   Author: Bernie Roesler
+ *
+ *  Description: Wide XOR kernels. The loops are written with GCC vector
+ *      extensions and compiled twice, for AVX2 and for the baseline target,
+ *      as in util_bitslice.c.
+ *
+ *      A repeating key is never expanded to the length of the input. Keys
+ *      of at least XOR_WIDE bytes are XOR-ed a contiguous run of the key at
+ *      a time, loaded straight from the key. Shorter keys are repeated into
+ *      a window of key_len + XOR_WIDE bytes; each wide step loads XOR_WIDE
+ *      bytes of it at the phase, which is the key register rotated into
+ *      place.
+ *
+ *============================================================================*/
+
+#include "util_xor.h"
+
+typedef uint64_t xor_v16 __attribute__((vector_size(16)));
+typedef uint64_t xor_v32 __attribute__((vector_size(32)));
+
+/* Inlined into the target-specific entry points below */
+#define XOR_INLINE static inline __attribute__((always_inline))
+
+/*------------------------------------------------------------------------------
+ *         Kernels
+ *----------------------------------------------------------------------------*/
+/* dst = a ^ b for XOR_WIDE bytes */
+XOR_INLINE void xor_wide(BYTE *dst, const BYTE *a, const BYTE *b)
+{
+    xor_v32 u0, u1, v0, v1;
+    memcpy(&u0, a,      32);
+    memcpy(&u1, a + 32, 32);
+    memcpy(&v0, b,      32);
+    memcpy(&v1, b + 32, 32);
+    u0 ^= v0;
+    u1 ^= v1;
+    memcpy(dst,      &u0, 32);
+    memcpy(dst + 32, &u1, 32);
+}
+
+XOR_INLINE void xor_buf_body(BYTE *dst, const BYTE *a, const BYTE *b,
+        size_t nbyte)
+{
+    size_t i = 0;
+    for (; i + XOR_WIDE <= nbyte; i += XOR_WIDE) {
+        xor_wide(dst + i, a + i, b + i);
+    }
+    for (; i + 16 <= nbyte; i += 16) {
+        xor_v16 u, v;
+        memcpy(&u, a + i, 16);
+        memcpy(&v, b + i, 16);
+        u ^= v;
+        memcpy(dst + i, &u, 16);
+    }
+    for (; i < nbyte; i++) { dst[i] = a[i] ^ b[i]; }
+}
+
+/* win holds the key repeated to key_len + XOR_WIDE bytes, key_len < XOR_WIDE */
+XOR_INLINE size_t xor_window_body(BYTE *dst, const BYTE *src, size_t nbyte,
+        const BYTE *win, size_t key_len, size_t phase)
+{
+    size_t step = (nbyte >= XOR_WIDE) ? XOR_WIDE % key_len : 0,
+           i = 0;
+    for (; i + XOR_WIDE <= nbyte; i += XOR_WIDE) {
+        xor_wide(dst + i, src + i, win + phase);
+        phase += step;
+        if (phase >= key_len) { phase -= key_len; }
+    }
+    for (; i < nbyte; i++) {
+        dst[i] = src[i] ^ win[phase];
+        if (++phase == key_len) { phase = 0; }
+    }
+    return phase;
+}
+
+/* key_len >= XOR_WIDE: one contiguous run of the key at a time */
+XOR_INLINE size_t xor_long_body(BYTE *dst, const BYTE *src, size_t nbyte,
+        const BYTE *key, size_t key_len, size_t phase)
+{
+    while (nbyte) {
+        size_t n = MIN(nbyte, key_len - phase);
+        xor_buf_body(dst, src, key + phase, n);
+        dst += n;
+        src += n;
+        nbyte -= n;
+        phase += n;
+        if (phase == key_len) { phase = 0; }
+    }
+    return phase;
+}
+
+/*------------------------------------------------------------------------------
+ *         Target-specific entry points
+ *----------------------------------------------------------------------------*/
+static void xor_buf_base(BYTE *dst, const BYTE *a, const BYTE *b,
+        size_t nbyte)
+{
+    xor_buf_body(dst, a, b, nbyte);
+}
+
+static size_t xor_window_base(BYTE *dst, const BYTE *src, size_t nbyte,
+        const BYTE *win, size_t key_len, size_t phase)
+{
+    return xor_window_body(dst, src, nbyte, win, key_len, phase);
+}
+
+static size_t xor_long_base(BYTE *dst, const BYTE *src, size_t nbyte,
+        const BYTE *key, size_t key_len, size_t phase)
+{
+    return xor_long_body(dst, src, nbyte, key, key_len, phase);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void xor_buf_avx2(BYTE *dst, const BYTE *a, const BYTE *b,
+        size_t nbyte)
+{
+    xor_buf_body(dst, a, b, nbyte);
+}
+
+__attribute__((target("avx2")))
+static size_t xor_window_avx2(BYTE *dst, const BYTE *src, size_t nbyte,
+        const BYTE *win, size_t key_len, size_t phase)
+{
+    return xor_window_body(dst, src, nbyte, win, key_len, phase);
+}
+
+__attribute__((target("avx2")))
+static size_t xor_long_avx2(BYTE *dst, const BYTE *src, size_t nbyte,
+        const BYTE *key, size_t key_len, size_t phase)
+{
+    return xor_long_body(dst, src, nbyte, key, key_len, phase);
+}
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Public interface
+ *----------------------------------------------------------------------------*/
+void xor_buf(BYTE *dst, const BYTE *a, const BYTE *b, size_t nbyte)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) {
+        xor_buf_avx2(dst, a, b, nbyte);
+        return;
+    }
+#endif
+    xor_buf_base(dst, a, b, nbyte);
+}
+
+size_t xor_repeat(BYTE *dst, const BYTE *src, size_t nbyte, const BYTE *key,
+        size_t key_len, size_t phase)
+{
+    if (key_len == 0) { ERROR("Empty XOR key!"); }
+    if (phase >= key_len) { phase %= key_len; }
+
+    if (key_len >= XOR_WIDE) {
+#if defined(__x86_64__) || defined(__i386__)
+        if (cpu_has_avx2()) {
+            return xor_long_avx2(dst, src, nbyte, key, key_len, phase);
+        }
+#endif
+        return xor_long_base(dst, src, nbyte, key, key_len, phase);
+    }
+
+    /* Short keys: a window any XOR_WIDE bytes of which start at a phase. Too
+     * short an input for a wide step only reads the first key_len bytes. */
+    if (nbyte < XOR_WIDE) {
+        return xor_window_base(dst, src, nbyte, key, key_len, phase);
+    }
+
+    BYTE win[2*XOR_WIDE];
+    for (size_t j = 0, k = 0; j < key_len + XOR_WIDE; j++) {
+        win[j] = key[k];
+        if (++k == key_len) { k = 0; }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_has_avx2()) {
+        return xor_window_avx2(dst, src, nbyte, win, key_len, phase);
+    }
+#endif
+    return xor_window_base(dst, src, nbyte, win, key_len, phase);
+}
+
+/*==============================================================================
+ *============================================================================*/